@@ -0,0 +1,213 @@
+// Standard Library Includes
+#include <cstddef>
+#include <vector>
+
+// External Includes
+#include <benchmark/benchmark.h>
+
+// Local Includes
+#include "engine.h"
+#include "memory.h"
+
+namespace {
+    // A running sum, the deepest graph for its number of nodes
+    Value buildChain(const Value &x, const std::size_t length) {
+        Value total{0.0};
+        for (std::size_t idx = 0; idx < length; ++idx) {
+            total = total + x * 2.0;
+        }
+        return total;
+    }
+
+    // A balanced tree of additions over products of leaves, only logarithmically deep
+    Value buildWideTree(const std::vector<Value> &leaves) {
+        std::vector<Value> level;
+        level.reserve(leaves.size());
+        for (const auto &leaf: leaves) {
+            level.push_back(leaf * leaf);
+        }
+        while (level.size() > 1) {
+            std::vector<Value> next;
+            next.reserve((level.size() + 1) / 2);
+            for (std::size_t idx = 0; idx + 1 < level.size(); idx += 2) {
+                next.push_back(level[idx] + level[idx + 1]);
+            }
+            if (level.size() % 2 == 1) {
+                next.push_back(level.back());
+            }
+            level = std::move(next);
+        }
+        return level.front();
+    }
+
+    std::vector<Value> makeLeaves(const std::size_t count) {
+        std::vector<Value> leaves;
+        leaves.reserve(count);
+        for (std::size_t idx = 0; idx < count; ++idx) {
+            leaves.emplace_back(0.001 * static_cast<double>(idx));
+        }
+        return leaves;
+    }
+}
+
+// region Building nodes
+
+static void BM_Add(benchmark::State &state) {
+    const Value x{1.5};
+    const Value y{-2.0};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        Value out = x + y;
+        benchmark::DoNotOptimize(out);
+    }
+    bench::setNodesPerIteration(state, 1);
+}
+
+BENCHMARK(BM_Add);
+
+static void BM_Multiply(benchmark::State &state) {
+    const Value x{1.5};
+    const Value y{-2.0};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        Value out = x * y;
+        benchmark::DoNotOptimize(out);
+    }
+    bench::setNodesPerIteration(state, 1);
+}
+
+BENCHMARK(BM_Multiply);
+
+static void BM_MultiplyConstant(benchmark::State &state) {
+    const Value x{1.5};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        Value out = x * 2.0;
+        benchmark::DoNotOptimize(out);
+    }
+    bench::setNodesPerIteration(state, 1);
+}
+
+BENCHMARK(BM_MultiplyConstant);
+
+static void BM_Pow(benchmark::State &state) {
+    const Value x{1.5};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        Value out = x.pow(3.0);
+        benchmark::DoNotOptimize(out);
+    }
+    bench::setNodesPerIteration(state, 1);
+}
+
+BENCHMARK(BM_Pow);
+
+static void BM_Relu(benchmark::State &state) {
+    const Value x{1.5};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        Value out = x.relu();
+        benchmark::DoNotOptimize(out);
+    }
+    bench::setNodesPerIteration(state, 1);
+}
+
+BENCHMARK(BM_Relu);
+
+static void BM_BuildChain(benchmark::State &state) {
+    const auto length = static_cast<std::size_t>(state.range(0));
+    const Value x{0.5};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        Value total = buildChain(x, length);
+        benchmark::DoNotOptimize(total);
+    }
+    bench::setNodesPerIteration(state, 2 * length + 1);
+}
+
+BENCHMARK(BM_BuildChain)->RangeMultiplier(10)->Range(100, 100000);
+
+// endregion Building nodes
+
+// region Traversing graphs
+
+static void BM_TopoSortChain(benchmark::State &state) {
+    const Value x{0.5};
+    const Value total = buildChain(x, static_cast<std::size_t>(state.range(0)));
+    const std::size_t nodes = total.count_nodes();
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        benchmark::DoNotOptimize(total.count_nodes());
+    }
+    bench::setNodesPerIteration(state, nodes);
+}
+
+BENCHMARK(BM_TopoSortChain)->RangeMultiplier(10)->Range(100, 100000);
+
+static void BM_TopoSortWideTree(benchmark::State &state) {
+    const std::vector<Value> leaves = makeLeaves(static_cast<std::size_t>(state.range(0)));
+    const Value total = buildWideTree(leaves);
+    const std::size_t nodes = total.count_nodes();
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        benchmark::DoNotOptimize(total.count_nodes());
+    }
+    bench::setNodesPerIteration(state, nodes);
+}
+
+BENCHMARK(BM_TopoSortWideTree)->RangeMultiplier(10)->Range(100, 100000);
+
+static void BM_BackwardsChain(benchmark::State &state) {
+    const Value x{0.5};
+    const Value total = buildChain(x, static_cast<std::size_t>(state.range(0)));
+    const std::size_t nodes = total.count_nodes();
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        total.backwards();
+    }
+    bench::setNodesPerIteration(state, nodes);
+}
+
+BENCHMARK(BM_BackwardsChain)->RangeMultiplier(10)->Range(100, 100000);
+
+static void BM_BackwardsWideTree(benchmark::State &state) {
+    const std::vector<Value> leaves = makeLeaves(static_cast<std::size_t>(state.range(0)));
+    const Value total = buildWideTree(leaves);
+    const std::size_t nodes = total.count_nodes();
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        total.backwards();
+    }
+    bench::setNodesPerIteration(state, nodes);
+}
+
+BENCHMARK(BM_BackwardsWideTree)->RangeMultiplier(10)->Range(100, 100000);
+
+static void BM_BackwardsWideTreeParallel(benchmark::State &state) {
+    const std::vector<Value> leaves = makeLeaves(static_cast<std::size_t>(state.range(0)));
+    const Value total = buildWideTree(leaves);
+    const std::size_t nodes = total.count_nodes();
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        total.backwards(ThreadPool::global());
+    }
+    bench::setNodesPerIteration(state, nodes);
+}
+
+BENCHMARK(BM_BackwardsWideTreeParallel)->RangeMultiplier(10)->Range(1000, 100000)->UseRealTime();
+
+static void BM_BuildAndReleaseChain(benchmark::State &state) {
+    // Building the graph and freeing it during the backward pass, as a training step does
+    const auto length = static_cast<std::size_t>(state.range(0));
+    const Value x{0.5};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        const Value total = buildChain(x, length);
+        total.backwards(false);
+    }
+    bench::setNodesPerIteration(state, 2 * length + 2);
+}
+
+BENCHMARK(BM_BuildAndReleaseChain)->RangeMultiplier(10)->Range(100, 100000);
+
+// endregion Traversing graphs
@@ -0,0 +1,211 @@
+// Standard Library Includes
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// External Includes
+#include <benchmark/benchmark.h>
+
+// Local Includes
+#include "engine.h"
+#include "memory.h"
+#include "nn.h"
+#include "tensor.h"
+
+namespace {
+    std::vector<Value> makeInputs(const std::size_t count) {
+        std::vector<Value> inputs;
+        inputs.reserve(count);
+        for (std::size_t idx = 0; idx < count; ++idx) {
+            inputs.emplace_back(0.01 * static_cast<double>(idx) - 0.5);
+        }
+        return inputs;
+    }
+}
+
+// region Value graphs
+
+static void BM_NeuronForwardBackward(benchmark::State &state) {
+    const int nin = static_cast<int>(state.range(0));
+    const Neuron neuron{nin, true};
+    const std::vector<Value> inputs = makeInputs(nin);
+    const std::size_t nodes = neuron(inputs).count_nodes();
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        neuron(inputs).backwards(false);
+    }
+    bench::setNodesPerIteration(state, nodes);
+}
+
+BENCHMARK(BM_NeuronForwardBackward)->RangeMultiplier(4)->Range(8, 512);
+
+static void BM_LayerForwardBackward(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const Layer layer{width, width, true};
+    const std::vector<Value> inputs = makeInputs(width);
+    // The outputs are added up, so a single backward pass reaches all of them
+    const std::size_t nodes = sum(layer(inputs)).count_nodes();
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        sum(layer(inputs)).backwards(false);
+    }
+    bench::setNodesPerIteration(state, nodes);
+}
+
+BENCHMARK(BM_LayerForwardBackward)->RangeMultiplier(4)->Range(8, 128);
+
+static void BM_MultiLayerPerceptronForwardBackward(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const MultiLayerPerceptron mlp{width, std::vector{width, width, 1}};
+    const std::vector<Value> inputs = makeInputs(width);
+    const std::size_t nodes = mlp(inputs)[0].count_nodes();
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        mlp(inputs)[0].backwards(false);
+    }
+    bench::setNodesPerIteration(state, nodes);
+}
+
+BENCHMARK(BM_MultiLayerPerceptronForwardBackward)->RangeMultiplier(4)->Range(8, 128);
+
+static void BM_MultiLayerPerceptronHessianVectorProduct(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const MultiLayerPerceptron mlp{width, std::vector{width, width, 1}};
+    const std::vector<Value> inputs = makeInputs(width);
+    const std::vector<Value> parameters = mlp.get_parameters();
+    const std::vector<double> vector(parameters.size(), 1.0);
+    const std::size_t nodes = mlp(inputs)[0].count_nodes();
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        benchmark::DoNotOptimize(hvp(mlp(inputs)[0], parameters, vector));
+    }
+    bench::setNodesPerIteration(state, nodes);
+}
+
+BENCHMARK(BM_MultiLayerPerceptronHessianVectorProduct)->RangeMultiplier(4)->Range(8, 128);
+
+static void BM_MultiLayerPerceptronCheckpointed(benchmark::State &state) {
+    // A deep network, keeping the activations of every other Layer
+    const int width = static_cast<int>(state.range(0));
+    const MultiLayerPerceptron mlp{width, std::vector{width, width, width, width, width, width, 1}};
+    const std::vector<Value> inputs = makeInputs(width);
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        mlp.checkpointed(inputs, 2)[0].backwards(false);
+    }
+}
+
+BENCHMARK(BM_MultiLayerPerceptronCheckpointed)->RangeMultiplier(4)->Range(8, 128);
+
+static void BM_MultiLayerPerceptronDeep(benchmark::State &state) {
+    // The same network as BM_MultiLayerPerceptronCheckpointed, keeping the whole graph
+    const int width = static_cast<int>(state.range(0));
+    const MultiLayerPerceptron mlp{width, std::vector{width, width, width, width, width, width, 1}};
+    const std::vector<Value> inputs = makeInputs(width);
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        mlp(inputs)[0].backwards(false);
+    }
+}
+
+BENCHMARK(BM_MultiLayerPerceptronDeep)->RangeMultiplier(4)->Range(8, 128);
+
+// endregion Value graphs
+
+// region Tensor graphs
+
+static void BM_MultiLayerPerceptronTensorForwardBackward(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const MultiLayerPerceptron mlp{width, std::vector{width, width, 1}};
+    std::vector<double> data(static_cast<std::size_t>(width));
+    for (std::size_t idx = 0; idx < data.size(); ++idx) {
+        data[idx] = 0.01 * static_cast<double>(idx) - 0.5;
+    }
+    const Tensor inputs{{static_cast<std::size_t>(width)}, data};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        mlp(inputs).backwards(false);
+    }
+}
+
+BENCHMARK(BM_MultiLayerPerceptronTensorForwardBackward)->RangeMultiplier(4)->Range(8, 128);
+
+// A batch of 64 samples through a MultiLayerPerceptron of either scalar type
+template<typename T>
+static void BM_MultiLayerPerceptronBatchForwardBackward(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const std::size_t batch = 64;
+    const BasicMultiLayerPerceptron<T> mlp{width, std::vector{width, width, 1}};
+    std::vector<T> data(batch * static_cast<std::size_t>(width));
+    for (std::size_t idx = 0; idx < data.size(); ++idx) {
+        data[idx] = static_cast<T>(0.001 * static_cast<double>(idx % 1000) - 0.5);
+    }
+    const BasicTensor<T> inputs{{batch, static_cast<std::size_t>(width)}, data};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        mlp(inputs).backwards(false);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_MultiLayerPerceptronBatchForwardBackward, double)->RangeMultiplier(4)->Range(32, 512);
+BENCHMARK_TEMPLATE(BM_MultiLayerPerceptronBatchForwardBackward, float)->RangeMultiplier(4)->Range(32, 512);
+
+// endregion Tensor graphs
+
+// region Parameters
+
+static void BM_ConstructMultiLayerPerceptron(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        MultiLayerPerceptron mlp{width, std::vector{width, width, 1}, Initialization::He, 0};
+        benchmark::DoNotOptimize(mlp);
+    }
+}
+
+BENCHMARK(BM_ConstructMultiLayerPerceptron)->RangeMultiplier(8)->Range(8, 512)->UseRealTime();
+
+static void BM_GetParameters(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const MultiLayerPerceptron mlp{width, std::vector{width, width, 1}};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        // A copy, as the Python bindings make
+        std::vector<Value> params = mlp.get_parameters();
+        benchmark::DoNotOptimize(params);
+    }
+    state.counters["parameters"] = static_cast<double>(mlp.get_parameters().size());
+}
+
+BENCHMARK(BM_GetParameters)->RangeMultiplier(4)->Range(8, 128);
+
+static void BM_ZeroGrad(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const MultiLayerPerceptron mlp{width, std::vector{width, width, 1}};
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        mlp.zero_grad();
+        benchmark::ClobberMemory();
+    }
+    state.counters["parameters"] = static_cast<double>(mlp.get_parameters().size());
+}
+
+BENCHMARK(BM_ZeroGrad)->RangeMultiplier(4)->Range(8, 128);
+
+static void BM_LoadMultiLayerPerceptron(benchmark::State &state) {
+    // Mapping the file, without touching its pages
+    const int width = static_cast<int>(state.range(0));
+    const std::string path = (std::filesystem::temp_directory_path() / "nanograd_bench_model.bin").string();
+    MultiLayerPerceptron{width, std::vector{width, width, 1}}.save(path);
+    const bench::MemoryCounters memory{state};
+    for (auto _: state) {
+        MultiLayerPerceptron mlp = MultiLayerPerceptron::load(path);
+        benchmark::DoNotOptimize(mlp);
+    }
+    std::filesystem::remove(path);
+}
+
+BENCHMARK(BM_LoadMultiLayerPerceptron)->RangeMultiplier(8)->Range(8, 512);
+
+// endregion Parameters
@@ -0,0 +1,90 @@
+#include "memory.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::size_t> liveBytes{0};
+    std::atomic<std::size_t> peakBytes{0};
+
+    // Every block starts with its size, padded so the memory handed out keeps
+    // the alignment malloc guarantees
+    constexpr std::size_t headerSize = alignof(std::max_align_t);
+
+    void *allocate(const std::size_t size) {
+        auto *block = static_cast<unsigned char *>(std::malloc(size + headerSize));
+        if (block == nullptr) {
+            throw std::bad_alloc{};
+        }
+        *reinterpret_cast<std::size_t *>(block) = size;
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        const std::size_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        // The benchmarks allocate from a single thread, so a racy maximum is good enough
+        if (live > peakBytes.load(std::memory_order_relaxed)) {
+            peakBytes.store(live, std::memory_order_relaxed);
+        }
+        return block + headerSize;
+    }
+
+    void deallocate(void *ptr) {
+        if (ptr == nullptr) {
+            return;
+        }
+        auto *block = static_cast<unsigned char *>(ptr) - headerSize;
+        liveBytes.fetch_sub(*reinterpret_cast<std::size_t *>(block), std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+// The array and nothrow forms call these by default, the over-aligned forms
+// aren't replaced (nothing in nanograd_core uses over-aligned types)
+void *operator new(const std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+namespace bench {
+    std::uint64_t allocationCount() {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    std::size_t heapBytes() {
+        return liveBytes.load(std::memory_order_relaxed);
+    }
+
+    std::size_t peakHeapBytes() {
+        return peakBytes.load(std::memory_order_relaxed);
+    }
+
+    void resetPeakHeapBytes() {
+        peakBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    std::size_t peakResidentBytes() {
+#if defined(__APPLE__)
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<std::size_t>(usage.ru_maxrss);
+#elif defined(__unix__)
+        // Reported in kilobytes on Linux
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#else
+        return 0;
+#endif
+    }
+}
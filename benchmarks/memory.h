@@ -0,0 +1,88 @@
+#pragma once
+// Standard Library Includes
+#include <cstddef>
+#include <cstdint>
+
+// Local Includes
+
+// External Includes
+#include <benchmark/benchmark.h>
+
+namespace bench {
+  /**
+   * @brief Get the number of calls to operator new so far, on any thread.
+   * @return Number of heap allocations
+   */
+  std::uint64_t allocationCount();
+
+  /**
+   * @brief Get the number of bytes currently allocated through operator new.
+   * @return Live heap bytes
+   */
+  std::size_t heapBytes();
+
+  /**
+   * @brief Get the largest number of bytes allocated at once since the last
+   *     call to resetPeakHeapBytes.
+   * @return Peak live heap bytes
+   */
+  std::size_t peakHeapBytes();
+
+  /**
+   * @brief Start tracking the peak from the bytes currently allocated.
+   */
+  void resetPeakHeapBytes();
+
+  /**
+   * @brief Get the peak resident set size of the whole process.
+   * @return Peak resident bytes, or 0 where it can't be measured
+   */
+  std::size_t peakResidentBytes();
+
+  /**
+   * @brief Report the time per node, given the number of graph nodes
+   *     created or visited by every iteration.
+   * @param state State of the running benchmark.
+   * @param nodes Number of nodes per iteration.
+   */
+  inline void setNodesPerIteration(benchmark::State &state, const std::size_t nodes) {
+    state.counters["per_node"] = benchmark::Counter(static_cast<double>(nodes),
+                                                    benchmark::Counter::kIsIterationInvariantRate |
+                                                    benchmark::Counter::kInvert);
+  }
+
+  /**
+   * @brief Measures the heap use of a benchmark from its construction to its
+   *     destruction, and reports it as counters.
+   *
+   * Reports the allocations per iteration, the peak heap bytes allocated on
+   * top of those live when the measure started, and the peak resident set
+   * size of the process (which never decreases, so it covers every benchmark
+   * run so far).
+   */
+  class MemoryCounters {
+    benchmark::State &state;
+    std::uint64_t startAllocations;
+    std::size_t startBytes;
+
+  public:
+    explicit MemoryCounters(benchmark::State &state)
+      : state(state), startAllocations(allocationCount()), startBytes(heapBytes()) {
+      resetPeakHeapBytes();
+    }
+
+    MemoryCounters(const MemoryCounters &) = delete;
+
+    MemoryCounters &operator=(const MemoryCounters &) = delete;
+
+    ~MemoryCounters() {
+      this->state.counters["allocs"] = benchmark::Counter(
+        static_cast<double>(allocationCount() - this->startAllocations), benchmark::Counter::kAvgIterations);
+      this->state.counters["peak_heap"] = benchmark::Counter(
+        static_cast<double>(peakHeapBytes() - this->startBytes), benchmark::Counter::kDefaults,
+        benchmark::Counter::kIs1024);
+      this->state.counters["peak_rss"] = benchmark::Counter(
+        static_cast<double>(peakResidentBytes()), benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+    }
+  };
+}
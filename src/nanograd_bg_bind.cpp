@@ -1,27 +1,69 @@
 // Standard Library Dependencies
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 // Local Dependencies
+#include "dual.h"
 #include "engine.h"
 #include "nn.h"
+#include "optim.h"
+#include "profiler.h"
+#include "tensor.h"
+#include "thread_pool.h"
 
 // External Dependencies
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
 
-// Create a python trampoline class for Module
-class PyModule : public Module {
-    using Module::Module;
+namespace {
+    // Contiguous float64 arrays pass through untouched, anything else is converted once
+    using DoubleArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
 
-public:
-    void zero_grad() override { PYBIND11_OVERRIDE(void, Module, zero_grad,); }
+    // The heavy entry points only touch C++ objects once their arguments are converted,
+    // so they run without the GIL and Python threads can run independent models concurrently
+    using ReleaseGil = py::call_guard<py::gil_scoped_release>;
 
-    std::vector<Value> get_parameters() override {
-        PYBIND11_OVERRIDE(std::vector<Value>, Module, get_parameters,);
+    // Wrap a buffer of a Tensor in a NumPy array, the array keeps the Tensor alive
+    py::array_t<double> asArray(const Tensor &tensor, const std::span<double> buffer) {
+        auto *owner = new Tensor(tensor);
+        const py::capsule base(owner, [](void *ptr) { delete static_cast<Tensor *>(ptr); });
+        const std::vector<py::ssize_t> shape(tensor.get_shape().begin(), tensor.get_shape().end());
+        return py::array_t<double>(shape, buffer.data(), base);
     }
-};
+
+    // View a NumPy array as a Tensor without copying it (read-only arrays are copied,
+    // since the Tensor can write to its data)
+    Tensor fromArray(const DoubleArray &array) {
+        if (array.ndim() != 1 && array.ndim() != 2) {
+            throw std::runtime_error("Tensor: only 1-D and 2-D arrays are supported, got " +
+                                     std::to_string(array.ndim()) + " dimensions");
+        }
+        std::vector<std::size_t> shape(array.shape(), array.shape() + array.ndim());
+        // Without a base, the new array owns a copy of the buffer
+        auto *owned = new DoubleArray(array.writeable() ? array : DoubleArray(array.request()));
+        // The Tensor can be released without holding the GIL, so take it before releasing the array
+        std::shared_ptr<void> storage(owned, [](void *ptr) {
+            py::gil_scoped_acquire gil;
+            delete static_cast<DoubleArray *>(ptr);
+        });
+        return Tensor::view(std::move(shape), owned->mutable_data(), std::move(storage));
+    }
+
+    // Context manager entering a NoGradGuard for the duration of a with block
+    struct NoGradContext {
+        std::optional<NoGradGuard> guard;
+    };
+}
 
 void add_engine(py::module_ &m) {
     const py::module_ engine =
@@ -45,12 +87,27 @@ void add_engine(py::module_ &m) {
             .def("zero_grad", &Value::zero_grad, R"pbdoc(
                 Set the value of grad to 0.0
             )pbdoc")
-            .def("backwards", &Value::backwards, R"pbdoc(
+            .def("backwards",
+                 [](const Value &v, const bool parallel, const bool retainGraph) {
+                     if (parallel) {
+                         v.backwards(ThreadPool::global(), retainGraph);
+                     } else {
+                         v.backwards(retainGraph);
+                     }
+                 }, py::arg("parallel") = false, py::arg("retain_graph") = true, ReleaseGil(), R"pbdoc(
                 Compute the gradients of a Value. 
 
                 Uses backpropagation to calculate the dertivative of this Value with
                 respect to any Vaues which were used to generate it. 
 
+                Args:
+                    parallel (bool): Whether to spread the computation over a pool of 
+                        threads, one per core. Only worth it for large graphs with many 
+                        independent parts, such as the output of a wide Layer.
+                    retain_graph (bool): Whether to keep the graph so backwards can be
+                        called again. Otherwise the nodes are released as soon as their
+                        gradient has been propagated, freeing the memory of the graph.
+
                 Examples:
                     >>> # Create some Values
                     >>> x = Value(3)
@@ -90,26 +147,307 @@ void add_engine(py::module_ &m) {
                 Args:
                    data (float): Data to wrap in the Value.
             )pbdoc";
+
+    // Add Dual class to submodule
+    py::class_<Dual>(engine, "Dual")
+            .def(py::init<const double, const double>(), py::arg("data"), py::arg("tangent") = 0.)
+            .def("__repr__", &Dual::as_string, R"pbdoc(
+            Create a string representation of the Dual. 
+
+            Returns:
+                str: A representation of the Dual.
+            )pbdoc")
+            .def_property("data", &Dual::get_data, &Dual::set_data, R"pbdoc(
+                float: Value of the dual number.
+            )pbdoc")
+            .def_property("tangent", &Dual::get_tangent, &Dual::set_tangent, R"pbdoc(
+                float: Derivative of the dual number along the direction being propagated.
+            )pbdoc")
+            .def(py::self + py::self)
+            .def(double() + py::self)
+            .def(py::self + double())
+            .def(py::self - py::self)
+            .def(double() - py::self)
+            .def(py::self - double())
+            .def(py::self * py::self)
+            .def(double() * py::self)
+            .def(py::self * double())
+            .def(py::self / py::self)
+            .def(double() / py::self)
+            .def(py::self / double())
+            .def("__pow__", [](const Dual &a, const double b) { return a.pow(b); })
+            .def("__neg__", [](const Dual &a) { return -a; })
+            .def("relu", &Dual::relu, R"pbdoc(
+                Calculate the output of a ReLU on the Dual.
+
+                Returns:
+                    Dual: The output of the ReLU operation, with its tangent.
+            )pbdoc")
+            .doc() = R"pbdoc(
+                A dual number, carrying a tangent alongside its data for forward-mode 
+                differentiation.
+
+                Every operation computes the tangent of its result along with its data, 
+                so a single evaluation gives the derivatives of every output along one 
+                direction of the inputs, without recording a graph.
+
+                Args:
+                   data (float): Value of the dual number.
+                   tangent (float): Derivative along the direction being propagated, 
+                       0 for a constant.
+            )pbdoc";
+
+    // Add Tensor class to submodule
+    py::class_<Tensor>(engine, "Tensor", py::buffer_protocol())
+            .def(py::init(&fromArray), py::arg("data"))
+            .def_buffer([](const Tensor &t) -> py::buffer_info {
+                const auto &shape = t.get_shape();
+                std::vector<py::ssize_t> strides{static_cast<py::ssize_t>(sizeof(double))};
+                if (shape.size() == 2) {
+                    strides.insert(strides.begin(), static_cast<py::ssize_t>(shape[1] * sizeof(double)));
+                }
+                return py::buffer_info(t.get_data().data(), sizeof(double), py::format_descriptor<double>::format(),
+                                       static_cast<py::ssize_t>(shape.size()),
+                                       std::vector<py::ssize_t>(shape.begin(), shape.end()), strides);
+            })
+            .def("__repr__", &Tensor::as_string)
+            .def("__len__", &Tensor::size)
+            .def_property_readonly("shape", [](const Tensor &t) { return py::tuple(py::cast(t.get_shape())); },
+                                   R"pbdoc(
+                tuple[int, ...]: Shape of the Tensor, either (length,) or (rows, columns).
+            )pbdoc")
+            .def_property_readonly("data", [](const Tensor &t) { return asArray(t, t.get_data()); }, R"pbdoc(
+                numpy.ndarray: Writable view of the data of the Tensor, sharing its memory.
+            )pbdoc")
+            .def_property_readonly("grad", [](const Tensor &t) { return asArray(t, t.get_grad()); }, R"pbdoc(
+                numpy.ndarray: Writable view of the gradient of the Tensor, sharing its memory.
+            )pbdoc")
+            .def("zero_grad", &Tensor::zero_grad, R"pbdoc(
+                Set every element of the gradient to 0.0
+            )pbdoc")
+            .def("backwards", py::overload_cast<bool>(&Tensor::backwards, py::const_),
+                 py::arg("retain_graph") = true, ReleaseGil(), R"pbdoc(
+                Compute the gradients of the sum of the elements of the Tensor.
+
+                Args:
+                    retain_graph (bool): Whether to keep the graph so backwards can be
+                        called again, otherwise the nodes are released during the pass.
+            )pbdoc")
+            .def(py::self + py::self)
+            .def(py::self * py::self)
+            .def("__matmul__", &Tensor::matmul, ReleaseGil())
+            .def("matmul", &Tensor::matmul, ReleaseGil(), R"pbdoc(
+                Compute the matrix product with another Tensor.
+
+                Args:
+                    other (Tensor): Right hand side of the product, either 2-D or 1-D.
+
+                Returns:
+                    Tensor: The matrix product.
+            )pbdoc")
+            .def("matmul_transposed", &Tensor::matmul_transposed, ReleaseGil(), R"pbdoc(
+                Compute the matrix product with the transpose of another Tensor.
+
+                Args:
+                    other (Tensor): 2-D right hand side of the product, used transposed.
+
+                Returns:
+                    Tensor: The matrix product.
+            )pbdoc")
+            .def("__pow__", [](const Tensor &a, const double b) { return a.pow(b); })
+            .def("relu", &Tensor::relu, R"pbdoc(
+                Apply a ReLU to every element of the Tensor.
+
+                Returns:
+                    Tensor: The output of the ReLU operation.
+            )pbdoc")
+            .def("sum", &Tensor::sum, R"pbdoc(
+                Sum all the elements of the Tensor.
+
+                Returns:
+                    Tensor: Tensor of shape (1,) holding the sum.
+            )pbdoc")
+            .doc() = R"pbdoc(
+                A dense 1-D or 2-D array of floats which can be used in computing gradients.
+
+                The Tensor views the memory of the array it is created from without
+                copying it, as long as it is a writeable C-contiguous float64 array, and
+                supports the buffer protocol so numpy.asarray gives a view of its data.
+
+                Args:
+                   data (numpy.ndarray): 1-D or 2-D array holding the data.
+            )pbdoc";
+
+    engine.def("sum", [](const std::vector<Value> &values) { return sum(values); }, py::arg("values"), R"pbdoc(
+                Add up a list of Values as a single node.
+
+                Args:
+                    values (list[Value]): Values to add up.
+
+                Returns:
+                    Value: The sum of the values.
+            )pbdoc");
+    engine.def("dot", [](const std::vector<Value> &lhs, const std::vector<Value> &rhs) { return dot(lhs, rhs); },
+               py::arg("lhs"), py::arg("rhs"), R"pbdoc(
+                Compute the dot product of two lists of Values as a single node.
+
+                Args:
+                    lhs (list[Value]): Values on the left hand side of the products.
+                    rhs (list[Value]): Values on the right hand side of the products, 
+                        of the same length as lhs.
+
+                Returns:
+                    Value: The sum of lhs[i] * rhs[i].
+            )pbdoc");
+
+    engine.def("sum", [](const std::vector<Dual> &values) { return sum(values); }, py::arg("values"), R"pbdoc(
+                Add up a list of Duals.
+
+                Args:
+                    values (list[Dual]): Duals to add up.
+
+                Returns:
+                    Dual: The sum of the values.
+            )pbdoc");
+    engine.def("dot", [](const std::vector<Dual> &lhs, const std::vector<Dual> &rhs) { return dot(lhs, rhs); },
+               py::arg("lhs"), py::arg("rhs"), R"pbdoc(
+                Compute the dot product of two lists of Duals.
+
+                Args:
+                    lhs (list[Dual]): Duals on the left hand side of the products.
+                    rhs (list[Dual]): Duals on the right hand side of the products, 
+                        of the same length as lhs.
+
+                Returns:
+                    Dual: The sum of lhs[i] * rhs[i].
+            )pbdoc");
+    engine.def("jvp", &jvp, py::arg("function"), py::arg("primals"), py::arg("tangents"), R"pbdoc(
+                Compute a function and its Jacobian-vector product in a single forward sweep.
+
+                Args:
+                    function (Callable[[list[Dual]], list[Dual]]): Function to differentiate.
+                    primals (list[float]): Point the function is evaluated at.
+                    tangents (list[float]): Direction the derivatives are taken along, of 
+                        the same length as primals.
+
+                Returns:
+                    list[Dual]: Outputs of the function, whose tangents hold the product of 
+                        its Jacobian at primals with tangents.
+            )pbdoc");
+
+    engine.def("checkpoint", &checkpoint, py::arg("segment"), py::arg("inputs"), R"pbdoc(
+                Run part of a computation without keeping its intermediate nodes.
+
+                The segment runs once without recording its graph, and again from the
+                data of its inputs when the backward pass reaches its outputs, so only
+                the outputs are kept in memory in between.
+
+                Args:
+                    segment (Callable[[list[Value]], list[Value]]): Function computing the
+                        outputs from the inputs, giving the same results on every call.
+                    inputs (list[Value]): Inputs of the segment.
+
+                Returns:
+                    list[Value]: The outputs of the segment.
+            )pbdoc");
+
+    engine.def("grad", &grad, py::arg("output"), py::arg("inputs"), py::arg("create_graph") = false, ReleaseGil(),
+               R"pbdoc(
+                Compute the gradients of a Value with respect to some inputs, as Values.
+
+                Unlike backwards, the gradients are returned and the grad of the nodes
+                is left untouched. With create_graph, the gradients are part of a graph
+                themselves, so they can be differentiated again.
+
+                Args:
+                    output (Value): Value to differentiate.
+                    inputs (list[Value]): Values to differentiate output with respect to.
+                    create_graph (bool): Whether to record the graph of the gradients.
+
+                Returns:
+                    list[Value]: The gradient of output with respect to every input.
+            )pbdoc");
+    engine.def("hvp", &hvp, py::arg("output"), py::arg("inputs"), py::arg("vector"), ReleaseGil(), R"pbdoc(
+                Compute the product of the Hessian of a Value with a vector.
+
+                Forward-over-reverse, so the cost is a small multiple of a backward pass
+                and the Hessian is never formed.
+
+                Args:
+                    output (Value): Value whose Hessian is taken.
+                    inputs (list[Value]): Values the Hessian is taken with respect to.
+                    vector (list[float]): Vector multiplied with the Hessian, of the same
+                        length as inputs.
+
+                Returns:
+                    list[float]: The product of the Hessian of output with vector.
+            )pbdoc");
+
+    py::class_<NoGradContext>(engine, "no_grad", R"pbdoc(
+                Context manager disabling gradient tracking on the current thread.
+
+                Operations inside the with block only compute their data, without
+                recording the graph needed for backwards, which saves the time and
+                memory of building it when only predictions are needed.
+            )pbdoc")
+            .def(py::init<>())
+            .def("__enter__", [](NoGradContext &context) -> NoGradContext & {
+                context.guard.emplace();
+                return context;
+            }, py::return_value_policy::reference_internal)
+            .def("__exit__", [](NoGradContext &context, const py::args &) {
+                context.guard.reset();
+            });
+    engine.def("is_grad_enabled", &NoGradGuard::is_grad_enabled, R"pbdoc(
+                Check whether operations on the current thread record the graph.
+
+                Returns:
+                    bool: False inside a no_grad block, True otherwise.
+            )pbdoc");
 }
 
 void add_nn(py::module_ &m) {
     const auto nn = m.def_submodule("nn", "Neural Network Classes");
+    // Add the initialization schemes to the submodule, before the constructors using them as defaults
+    py::enum_<Initialization>(nn, "Initialization", R"pbdoc(
+                Distribution the initial weights are drawn from, all uniform around 0.
+            )pbdoc")
+            .value("Uniform", Initialization::Uniform, "Uniform in [-1, 1].")
+            .value("Xavier", Initialization::Xavier, "Uniform in +-sqrt(6 / (nin + nout)), for linear layers.")
+            .value("He", Initialization::He, "Uniform in +-sqrt(6 / nin), for ReLU layers.");
+
     // Add Module class to the submodule
-    py::class_<Module, PyModule>(nn, "Module")
+    py::class_<Module>(nn, "Module")
             .def(py::init<>())
+            .def(py::init<const std::vector<Value> &>(), py::arg("params"))
             .def("zero_grad", &Module::zero_grad, R"pbdoc(
                 Zero the gradients of all parameters associated with Module.
             )pbdoc")
             .def("get_parameters", &Module::get_parameters, R"pbdoc(
                 Get a list of all parameters associated with Module. 
             )pbdoc")
+            .def("get_flat_parameters", &Module::get_flat_parameters, R"pbdoc(
+                Get a Tensor viewing the data and gradients of all parameters associated with Module.
+
+                Returns:
+                    Tensor: One dimensional Tensor sharing its data and gradient with the parameters.
+            )pbdoc")
             .doc() = R"pbdoc(
                 Base class for neural network classes.
+
+                The data and gradients of the parameters are stored in a single contiguous 
+                buffer, which the Values passed in are moved into. Values which already
+                belong to another Module or to a Tensor can't be used.
+
+                Args:
+                    params (list[Value]): Parameters of the Module.
             )pbdoc";
 
     // Add the Neuron class to the submodule
     py::class_<Neuron>(nn, "Neuron")
-            .def(py::init<int, bool>())
+            .def(py::init<int, bool, Initialization, std::optional<std::uint64_t> >(), py::arg("nin"),
+                 py::arg("nonlinear"), py::arg("initialization") = Initialization::Uniform,
+                 py::arg("seed") = py::none())
             .def("get_parameters", &Neuron::get_parameters, R"pbdoc(
                 Get a list of all parameters associated with the Neuron. 
 
@@ -119,7 +457,15 @@ void add_nn(py::module_ &m) {
             .def("zero_grad", &Neuron::zero_grad, R"pbdoc(
                 Set the gradient of all Neuron parameters to 0.
             )pbdoc")
-            .def("__call__", &Neuron::operator())
+            .def("get_flat_parameters", &Neuron::get_flat_parameters, R"pbdoc(
+                Get a Tensor viewing the data and gradients of all Neuron parameters, which 
+                are stored contiguously.
+
+                Returns:
+                    Tensor: One dimensional Tensor sharing its data and gradient with the parameters.
+            )pbdoc")
+            .def("__call__", py::overload_cast<const std::vector<Value> &>(&Neuron::operator(), py::const_), ReleaseGil())
+            .def("__call__", py::overload_cast<const std::vector<Dual> &>(&Neuron::operator(), py::const_), ReleaseGil())
             .doc() = R"pbdoc(
                 A single neuron, with randomly initialized weights and bias, as well as an activation function.
 
@@ -127,11 +473,15 @@ void add_nn(py::module_ &m) {
                     nin (int): Number of inputs to the Neuron.
                     nonlinear (bool): Whether the activation function should be non-linear 
                         (fed through a ReLU).
+                    initialization (Initialization): Distribution of the initial weights.
+                    seed (int | None): Seed of the initial weights, drawn from the system if None.
             )pbdoc";
 
     // Add the Layer class to the submodule
     py::class_<Layer>(nn, "Layer")
-            .def(py::init<int, int, bool>())
+            .def(py::init<int, int, bool, Initialization, std::optional<std::uint64_t> >(), py::arg("nin"),
+                 py::arg("nout"), py::arg("nonlinear"), py::arg("initialization") = Initialization::Uniform,
+                 py::arg("seed") = py::none())
             .def("get_parameters", &Layer::get_parameters, R"pbdoc(
                 Get a list of all parameters associated with the Layer. 
 
@@ -142,7 +492,44 @@ void add_nn(py::module_ &m) {
             .def("zero_grad", &Layer::zero_grad, R"pbdoc(
                 Set the gradient of all Layer parameters to 0.
             )pbdoc")
-            .def("__call__", &Layer::operator())
+            .def("get_flat_parameters", &Layer::get_flat_parameters, R"pbdoc(
+                Get a Tensor viewing the data and gradients of all Layer parameters, which 
+                are stored contiguously.
+
+                Returns:
+                    Tensor: One dimensional Tensor sharing its data and gradient with the parameters.
+            )pbdoc")
+            .def("__call__", py::overload_cast<const std::vector<Value> &>(&Layer::operator(), py::const_), ReleaseGil())
+            .def("__call__", py::overload_cast<const Tensor &>(&Layer::operator(), py::const_), ReleaseGil())
+            .def("__call__", py::overload_cast<const std::vector<Dual> &>(&Layer::operator(), py::const_), ReleaseGil())
+            .def("__call__", [](const Layer &layer, const DoubleArray &x) {
+                     // The array is wrapped while holding the GIL, and released after it is reacquired
+                     const Tensor input = fromArray(x);
+                     py::gil_scoped_release release;
+                     return layer(input);
+                 },
+                 R"pbdoc(
+                Run the Layer on a NumPy array, without copying it.
+
+                Args:
+                    x (numpy.ndarray): Either a single input of shape (nin,), or a 
+                        batch of shape (batch, nin) with one input per row.
+
+                Returns:
+                    Tensor: Outputs of the Layer, of shape (nout,) or (batch, nout).
+            )pbdoc")
+            .def("get_parameter_tensors", &Layer::get_parameter_tensors, R"pbdoc(
+                Get the Tensors holding the parameters of the Layer.
+
+                Returns:
+                    list[Tensor]: The weights and biases, sharing their data with the parameters.
+            )pbdoc")
+            .def_property_readonly("weights", &Layer::get_weights, R"pbdoc(
+                Tensor: Weights of the Layer, of shape (nout, nin), one row per Neuron.
+            )pbdoc")
+            .def_property_readonly("biases", &Layer::get_biases, R"pbdoc(
+                Tensor: Biases of the Layer, of shape (nout,).
+            )pbdoc")
             .doc() = R"pbdoc(
                 A Layer of Neurons in a neural network.
 
@@ -151,11 +538,15 @@ void add_nn(py::module_ &m) {
                     nouts (int): Number of outputs from the Layer.
                     nonlinear (bool): Whether the output of the Layer should be nonlinear 
                         (fed through a ReLU).
+                    initialization (Initialization): Distribution of the initial weights.
+                    seed (int | None): Seed of the initial weights, drawn from the system if None.
             )pbdoc";
 
     // Add the multilayer perceptron class to the submodule
     py::class_<MultiLayerPerceptron>(nn, "MultiLayerPerceptron")
-            .def(py::init<int, std::vector<int> >())
+            .def(py::init<int, const std::vector<int> &, Initialization, std::optional<std::uint64_t> >(),
+                 py::arg("nin"), py::arg("nouts"), py::arg("initialization") = Initialization::Uniform,
+                 py::arg("seed") = py::none())
             .def("get_parameters", &MultiLayerPerceptron::get_parameters, R"pbdoc(
                 Get a list of all parameters associated with the MultiLayerPerceptron. 
 
@@ -166,7 +557,116 @@ void add_nn(py::module_ &m) {
             .def("zero_grad", &MultiLayerPerceptron::zero_grad, R"pbdoc(
                 Set the gradient of all MultiLayerPerceptron parameters to 0.
             )pbdoc")
-            .def("__call__", &MultiLayerPerceptron::operator())
+            .def("get_flat_parameters", &MultiLayerPerceptron::get_flat_parameters, R"pbdoc(
+                Get a Tensor viewing the data and gradients of all MultiLayerPerceptron parameters, which 
+                are stored contiguously.
+
+                Returns:
+                    Tensor: One dimensional Tensor sharing its data and gradient with the parameters.
+            )pbdoc")
+            .def("__call__", py::overload_cast<std::vector<Value> >(&MultiLayerPerceptron::operator(), py::const_),
+                 ReleaseGil())
+            .def("__call__", py::overload_cast<const Tensor &>(&MultiLayerPerceptron::operator(), py::const_),
+                 ReleaseGil())
+            .def("__call__", py::overload_cast<std::vector<Dual> >(&MultiLayerPerceptron::operator(), py::const_),
+                 ReleaseGil(), R"pbdoc(
+                Run the MultiLayerPerceptron on dual numbers, computing the derivatives of the 
+                outputs along the tangents of the inputs in the same pass.
+
+                Args:
+                    x (list[Dual]): Inputs to the MultiLayerPerceptron.
+
+                Returns:
+                    list[Dual]: Outputs of the last Layer, with their tangents.
+            )pbdoc")
+            .def("checkpointed", &MultiLayerPerceptron::checkpointed, py::arg("x"), py::arg("segment_length"),
+                 ReleaseGil(), R"pbdoc(
+                Run the MultiLayerPerceptron, keeping only the activations between segments of Layers.
+
+                The Layers of a segment are recomputed during the backward pass, trading a
+                second forward pass for the memory of their graph.
+
+                Args:
+                    x (list[Value]): Inputs to the MultiLayerPerceptron.
+                    segment_length (int): Number of Layers in each segment.
+
+                Returns:
+                    list[Value]: Outputs of the last Layer.
+            )pbdoc")
+            .def("__call__",
+                 [](const MultiLayerPerceptron &mlp, const DoubleArray &x) {
+                     const Tensor input = fromArray(x);
+                     py::gil_scoped_release release;
+                     return mlp(input);
+                 },
+                 R"pbdoc(
+                Run the MultiLayerPerceptron on a NumPy array, without copying it.
+
+                Args:
+                    x (numpy.ndarray): Either a single input of shape (nin,), or a 
+                        batch of shape (batch, nin) with one input per row.
+
+                Returns:
+                    Tensor: Outputs of the last Layer, one row per input for a batch.
+            )pbdoc")
+            .def("get_parameter_tensors", &MultiLayerPerceptron::get_parameter_tensors, R"pbdoc(
+                Get the Tensors holding the parameters of the MultiLayerPerceptron.
+
+                Returns:
+                    list[Tensor]: The weights and biases of every Layer in turn, sharing 
+                        their data with the parameters.
+            )pbdoc")
+            .def_property_readonly("layers", &MultiLayerPerceptron::get_layers, R"pbdoc(
+                list[Layer]: The Layers of the MultiLayerPerceptron, sharing their 
+                    parameters with it.
+            )pbdoc")
+            .def("compile", &MultiLayerPerceptron::compile, R"pbdoc(
+                Record the MultiLayerPerceptron once so that it can be replayed on new inputs.
+
+                Returns:
+                    CompiledMultiLayerPerceptron: The recorded MultiLayerPerceptron, sharing 
+                        its parameters with this one.
+            )pbdoc")
+            .def("save", py::overload_cast<const std::string &>(&MultiLayerPerceptron::save, py::const_),
+                 py::arg("path"), ReleaseGil(), R"pbdoc(
+                Save the MultiLayerPerceptron to a binary file.
+
+                Args:
+                    path (str): File to write, replaced if it exists.
+            )pbdoc")
+            .def("save",
+                 py::overload_cast<const std::string &, const Optimizer &>(&MultiLayerPerceptron::save,
+                                                                           py::const_),
+                 py::arg("path"), py::arg("optimizer"), ReleaseGil(), R"pbdoc(
+                Save the MultiLayerPerceptron to a binary file, along with the state of an optimizer.
+
+                Args:
+                    path (str): File to write, replaced if it exists.
+                    optimizer (Optimizer): Optimizer over the parameters of the 
+                        MultiLayerPerceptron, restored by load_optimizer_state.
+            )pbdoc")
+            .def_static("load", &MultiLayerPerceptron::load, py::arg("path"), ReleaseGil(), R"pbdoc(
+                Load a MultiLayerPerceptron saved by save.
+
+                The file is mapped into memory rather than read, so loading is immediate 
+                whatever the size of the model, and processes loading the same file share 
+                its memory. Updating the parameters never modifies the file.
+
+                Args:
+                    path (str): File written by save.
+
+                Returns:
+                    MultiLayerPerceptron: The saved MultiLayerPerceptron.
+            )pbdoc")
+            .def_static("load_optimizer_state", &MultiLayerPerceptron::load_optimizer_state, py::arg("path"),
+                        py::arg("optimizer"), R"pbdoc(
+                Restore the state of an optimizer saved along with a MultiLayerPerceptron.
+
+                Args:
+                    path (str): File written by save with an optimizer.
+                    optimizer (Optimizer): Optimizer of the same kind as the saved one, over 
+                        the parameters of the loaded MultiLayerPerceptron.
+            )pbdoc")
             .doc() = R"pbdoc(
                 A Multi-Layer Perceptron.
 
@@ -175,15 +675,242 @@ void add_nn(py::module_ &m) {
                     nouts (list[int]): Sizes of the Layers in the MultiLayerPerceptron, 
                         the last of which is the number of outputs form the 
                         MultiLayerPerceptron.
+                    initialization (Initialization): Distribution of the initial weights.
+                    seed (int | None): Seed of the initial weights, drawn from the system if None. 
+                        MultiLayerPerceptrons of the same sizes created with the same seed 
+                        are identical.
+            )pbdoc";
+
+    // Add the compiled multilayer perceptron class to the submodule
+    py::class_<CompiledMultiLayerPerceptron>(nn, "CompiledMultiLayerPerceptron")
+            .def(py::init<const MultiLayerPerceptron &>())
+            .def("__call__", &CompiledMultiLayerPerceptron::operator(), ReleaseGil(), R"pbdoc(
+                Run the recorded MultiLayerPerceptron on an input.
+
+                Args:
+                    x (list[float]): Input to the MultiLayerPerceptron.
+
+                Returns:
+                    list[float]: Outputs of the MultiLayerPerceptron.
+            )pbdoc")
+            .def("backwards", &CompiledMultiLayerPerceptron::backwards, ReleaseGil(), R"pbdoc(
+                Accumulate the gradients of the parameters for the last input.
+
+                Args:
+                    output_grads (list[float]): Gradient of the loss with respect to each 
+                        output of the last call.
+            )pbdoc")
+            .def("__len__", &CompiledMultiLayerPerceptron::size)
+            .doc() = R"pbdoc(
+                A MultiLayerPerceptron recorded once and replayed for every input.
+
+                Calling a compiled MultiLayerPerceptron only recomputes the recorded
+                graph instead of building a new one, which makes repeated calls with
+                the same shape of input much faster. The parameters are shared with 
+                the MultiLayerPerceptron it was compiled from, so their gradients 
+                accumulate as usual and updates to their data are used by the next call.
+
+                Args:
+                    mlp (MultiLayerPerceptron): MultiLayerPerceptron to record.
+            )pbdoc";
+
+    // Add the data parallel trainer to the nn submodule
+    py::class_<DataParallelTrainer>(nn, "DataParallelTrainer")
+            .def(py::init([](const MultiLayerPerceptron &mlp, const std::size_t numWorkers,
+                             const double learningRate) {
+                     return DataParallelTrainer{mlp, numWorkers, learningRate};
+                 }), py::arg("mlp"), py::arg("num_workers"), py::arg("learning_rate"))
+            .def(py::init<const MultiLayerPerceptron &, std::size_t, Optimizer &>(), py::arg("mlp"),
+                 py::arg("num_workers"), py::arg("optimizer"), py::keep_alive<1, 4>())
+            .def("step", &DataParallelTrainer::step, py::arg("inputs"), py::arg("targets"), ReleaseGil())
+            .def("step",
+                 [](DataParallelTrainer &trainer, const DoubleArray &inputs, const DoubleArray &targets) {
+                     const Tensor inputTensor = fromArray(inputs);
+                     const Tensor targetTensor = fromArray(targets);
+                     py::gil_scoped_release release;
+                     return trainer.step(inputTensor, targetTensor);
+                 }, py::arg("inputs"), py::arg("targets"), R"pbdoc(
+                Run a single training step on a batch.
+
+                Args:
+                    inputs (numpy.ndarray): Inputs of the batch, of shape (batch, nin).
+                    targets (numpy.ndarray): Expected outputs, of shape (batch, nout).
+
+                Returns:
+                    float: Mean squared error of the batch before the update.
+            )pbdoc")
+            .def_property_readonly("num_workers", &DataParallelTrainer::get_num_workers)
+            .doc() = R"pbdoc(
+                Trains a MultiLayerPerceptron using every core of the machine.
+
+                Each step splits the batch into one shard per worker, computes the
+                gradients of every shard on its own thread, sums them and updates the
+                parameters of the MultiLayerPerceptron with an optimizer (gradient 
+                descent with the given learning rate unless one is passed in).
+
+                Args:
+                    mlp (MultiLayerPerceptron): MultiLayerPerceptron to train, updated in place.
+                    num_workers (int): Number of shards each batch is split into.
+                    learning_rate (float): Step size of the gradient descent update.
+                    optimizer (Optimizer): Optimizer over the parameter tensors of mlp, 
+                        used instead of a learning rate.
+            )pbdoc";
+}
+
+void add_optim(py::module_ &m) {
+    const auto optim = m.def_submodule("optim", "Optimizers updating parameters from their gradients");
+
+    py::class_<Optimizer>(optim, "Optimizer")
+            .def("step", &Optimizer::step, py::arg("zero_grad") = false, ReleaseGil(), R"pbdoc(
+                Update the parameters using their current gradients.
+
+                Args:
+                    zero_grad (bool): Whether to also set the gradients to 0, in the same pass 
+                        over the parameters.
+            )pbdoc")
+            .def("zero_grad", &Optimizer::zero_grad, R"pbdoc(
+                Set the gradients of all the parameters to 0.
+            )pbdoc")
+            .def("get_parameters", &Optimizer::get_parameters, R"pbdoc(
+                Get the parameters updated by the optimizer.
+
+                Returns:
+                    list[Tensor]: The parameters.
+            )pbdoc")
+            .def("get_state", &Optimizer::get_state, R"pbdoc(
+                Get the state kept by the optimizer, such as the velocities.
+
+                Returns:
+                    list[float]: The state, flattened.
+            )pbdoc")
+            .def("set_state", [](Optimizer &optimizer, const std::vector<double> &state) {
+                optimizer.set_state(state);
+            }, py::arg("state"), R"pbdoc(
+                Restore the state of the optimizer.
+
+                Args:
+                    state (list[float]): State returned by get_state, for an optimizer of 
+                        the same kind over parameters of the same sizes.
+            )pbdoc")
+            .doc() = R"pbdoc(
+                Base class for the optimizers.
+            )pbdoc";
+
+    py::class_<SGD, Optimizer>(optim, "SGD")
+            .def(py::init<std::vector<Tensor>, double, double>(), py::arg("params"), py::arg("learning_rate"),
+                 py::arg("momentum") = 0.)
+            .def_property("learning_rate", &SGD::get_learning_rate, &SGD::set_learning_rate, R"pbdoc(
+                float: Step size of the updates.
+            )pbdoc")
+            .doc() = R"pbdoc(
+                Stochastic gradient descent, optionally with momentum.
+
+                Args:
+                    params (list[Tensor]): Parameters to update, such as the result of 
+                        MultiLayerPerceptron.get_parameter_tensors().
+                    learning_rate (float): Step size of the updates.
+                    momentum (float): Decay of the velocity, 0 for plain gradient descent.
+            )pbdoc";
+
+    py::class_<Adam, Optimizer>(optim, "Adam")
+            .def(py::init<std::vector<Tensor>, double, double, double, double>(), py::arg("params"),
+                 py::arg("learning_rate") = 0.001, py::arg("beta1") = 0.9, py::arg("beta2") = 0.999,
+                 py::arg("epsilon") = 1e-8)
+            .def_property("learning_rate", &Adam::get_learning_rate, &Adam::set_learning_rate, R"pbdoc(
+                float: Step size of the updates.
+            )pbdoc")
+            .doc() = R"pbdoc(
+                The Adam optimizer.
+
+                Args:
+                    params (list[Tensor]): Parameters to update, such as the result of 
+                        MultiLayerPerceptron.get_parameter_tensors().
+                    learning_rate (float): Step size of the updates.
+                    beta1 (float): Decay of the running mean of the gradients.
+                    beta2 (float): Decay of the running mean of the squared gradients.
+                    epsilon (float): Term keeping the denominator of the update away from 0.
             )pbdoc";
 }
 
+void add_profiler(py::module_ &m) {
+    auto profiler = m.def_submodule("profiler", "Opt-in instrumentation of the engine");
+
+    profiler.def("start", &Profiler::start, R"pbdoc(
+                Discard every previous record and start recording.
+            )pbdoc");
+    profiler.def("stop", &Profiler::stop, R"pbdoc(
+                Stop recording, keeping the records made so far.
+            )pbdoc");
+    profiler.def("reset", &Profiler::reset, R"pbdoc(
+                Discard every record.
+            )pbdoc");
+    profiler.def("is_enabled", &Profiler::is_enabled, R"pbdoc(
+                Check whether the profiler is recording.
+
+                Returns:
+                    bool: Whether the profiler is recording.
+            )pbdoc");
+    profiler.def("report", []() {
+        const ProfileReport report = Profiler::report();
+        py::dict operations;
+        for (const auto &[name, stats]: report.operations) {
+            py::dict entry;
+            entry["nodes"] = stats.nodes;
+            entry["seconds"] = stats.seconds;
+            entry["bytes"] = stats.bytes;
+            operations[py::str(name)] = entry;
+        }
+        py::dict out;
+        out["operations"] = operations;
+        out["forward_seconds"] = report.forwardSeconds;
+        out["topo_sort_seconds"] = report.topoSortSeconds;
+        out["backward_seconds"] = report.backwardSeconds;
+        out["nodes"] = report.nodes;
+        out["node_bytes"] = report.nodeBytes;
+        out["backward_passes"] = report.backwardPasses;
+        out["max_depth"] = report.maxDepth;
+        out["max_width"] = report.maxWidth;
+        return out;
+    }, R"pbdoc(
+                Summarize the work recorded on every thread.
+
+                Returns:
+                    dict: With the keys
+                        - operations: for every kind of operation, a dict with the number
+                          of nodes it created, the seconds spent in it and the bytes its
+                          nodes take up (nodes created outside operations are leaves),
+                        - forward_seconds, topo_sort_seconds, backward_seconds: the time
+                          spent building nodes, sorting graphs and propagating gradients,
+                        - nodes, node_bytes: totals over all operations,
+                        - backward_passes: the number of backward passes,
+                        - max_depth, max_width: the largest depth and width of their graphs.
+            )pbdoc");
+    profiler.def("chrome_trace", &Profiler::chrome_trace, R"pbdoc(
+                Get the recorded spans as a Chrome trace.
+
+                Returns:
+                    str: JSON document which can be opened in chrome://tracing or Perfetto.
+            )pbdoc");
+    profiler.def("write_chrome_trace", &Profiler::write_chrome_trace, py::arg("path"), R"pbdoc(
+                Write the recorded spans to a file as a Chrome trace.
+
+                Args:
+                    path (str): File to write the trace to.
+            )pbdoc");
+}
+
 PYBIND11_MODULE(_core, m) {
     m.doc() = "Small scalar valued automatic differentiation library";
 
     // Add the engine submodule
     add_engine(m);
 
+    // Add the optim submodule (before nn, which refers to Optimizer)
+    add_optim(m);
+
     // Add the nn submodule
     add_nn(m);
+
+    // Add the profiler submodule
+    add_profiler(m);
 }
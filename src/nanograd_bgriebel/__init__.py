@@ -2,9 +2,36 @@ from importlib.metadata import version
 
 __author__ = "Braden Griebel"
 __version__ = version("nanograd_bgriebel")
-__all__ = ["engine", "nn", "Value", "Module", "Neuron", "Layer", "MultiLayerPerceptron"]
+__all__ = [
+    "engine",
+    "nn",
+    "optim",
+    "profiler",
+    "Value",
+    "Tensor",
+    "Dual",
+    "no_grad",
+    "Module",
+    "Initialization",
+    "Neuron",
+    "Layer",
+    "MultiLayerPerceptron",
+    "CompiledMultiLayerPerceptron",
+    "DataParallelTrainer",
+    "SGD",
+    "Adam",
+]
 
 # Package Imports
-from nanograd_bgriebel._core import engine, nn
-from nanograd_bgriebel._core.engine import Value
-from nanograd_bgriebel._core.nn import Module, Neuron, Layer, MultiLayerPerceptron
\ No newline at end of file
+from nanograd_bgriebel._core import engine, nn, optim, profiler
+from nanograd_bgriebel._core.engine import Value, Tensor, Dual, no_grad
+from nanograd_bgriebel._core.nn import (
+    Module,
+    Initialization,
+    Neuron,
+    Layer,
+    MultiLayerPerceptron,
+    CompiledMultiLayerPerceptron,
+    DataParallelTrainer,
+)
+from nanograd_bgriebel._core.optim import SGD, Adam
@@ -1,3 +1,9 @@
+from collections.abc import Callable
+from typing import overload
+
+import numpy as np
+import numpy.typing as npt
+
 class Value:
     @property
     def data(self) -> float: ...
@@ -17,4 +23,69 @@ class Value:
     def __truediv__(self, other: Value | float) -> Value: ...
     def __rtruediv__(self, other: Value | float) -> Value: ...
     def relu(self) -> Value: ...
-    def backwards(self): ...
+    def backwards(self, parallel: bool = False, retain_graph: bool = True): ...
+
+class Dual:
+    @property
+    def data(self) -> float: ...
+    @data.setter
+    def data(self, new_data: float): ...
+    @property
+    def tangent(self) -> float: ...
+    @tangent.setter
+    def tangent(self, new_tangent: float): ...
+    def __init__(self, data: float, tangent: float = 0.0) -> None: ...
+    def __add__(self, other: Dual | float) -> Dual: ...
+    def __mul__(self, other: Dual | float) -> Dual: ...
+    def __pow__(self, other: float) -> Dual: ...
+    def __neg__(self) -> Dual: ...
+    def __sub__(self, other: Dual | float) -> Dual: ...
+    def __rsub__(self, other: Dual | float) -> Dual: ...
+    def __radd__(self, other: Dual | float) -> Dual: ...
+    def __rmul__(self, other: Dual | float) -> Dual: ...
+    def __truediv__(self, other: Dual | float) -> Dual: ...
+    def __rtruediv__(self, other: Dual | float) -> Dual: ...
+    def relu(self) -> Dual: ...
+
+class Tensor:
+    def __init__(self, data: npt.ArrayLike) -> None: ...
+    def __len__(self) -> int: ...
+    @property
+    def shape(self) -> tuple[int, ...]: ...
+    @property
+    def data(self) -> npt.NDArray[np.float64]: ...
+    @property
+    def grad(self) -> npt.NDArray[np.float64]: ...
+    def zero_grad(self) -> None: ...
+    def backwards(self, retain_graph: bool = True) -> None: ...
+    def __add__(self, other: Tensor) -> Tensor: ...
+    def __mul__(self, other: Tensor) -> Tensor: ...
+    def __matmul__(self, other: Tensor) -> Tensor: ...
+    def __pow__(self, other: float) -> Tensor: ...
+    def matmul(self, other: Tensor) -> Tensor: ...
+    def matmul_transposed(self, other: Tensor) -> Tensor: ...
+    def relu(self) -> Tensor: ...
+    def sum(self) -> Tensor: ...
+
+@overload
+def sum(values: list[Value]) -> Value: ...
+@overload
+def sum(values: list[Dual]) -> Dual: ...
+@overload
+def dot(lhs: list[Value], rhs: list[Value]) -> Value: ...
+@overload
+def dot(lhs: list[Dual], rhs: list[Dual]) -> Dual: ...
+def jvp(
+    function: Callable[[list[Dual]], list[Dual]],
+    primals: list[float],
+    tangents: list[float],
+) -> list[Dual]: ...
+def checkpoint(segment: Callable[[list[Value]], list[Value]], inputs: list[Value]) -> list[Value]: ...
+def grad(output: Value, inputs: list[Value], create_graph: bool = False) -> list[Value]: ...
+def hvp(output: Value, inputs: list[Value], vector: list[float]) -> list[float]: ...
+def is_grad_enabled() -> bool: ...
+
+class no_grad:
+    def __init__(self) -> None: ...
+    def __enter__(self) -> no_grad: ...
+    def __exit__(self, *args: object) -> None: ...
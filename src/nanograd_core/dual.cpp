@@ -0,0 +1,60 @@
+#include "dual.h"
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+Dual Dual::pow(const double other) const {
+    return Dual{std::pow(this->data, other), other * std::pow(this->data, other - 1.0) * this->tangent};
+}
+
+Dual Dual::relu() const {
+    return this->data > 0. ? *this : Dual{0.};
+}
+
+Dual sum(const std::span<const Dual> values) {
+    double data = 0.;
+    double tangent = 0.;
+    for (const auto &value: values) {
+        data += value.data;
+        tangent += value.tangent;
+    }
+    return Dual{data, tangent};
+}
+
+Dual dot(const std::span<const Dual> lhs, const std::span<const Dual> rhs) {
+    if (lhs.size() != rhs.size()) {
+        throw std::runtime_error("dot: mismatched size, lhs is of size " + std::to_string(lhs.size()) +
+                                 " and rhs is of size " + std::to_string(rhs.size()));
+    }
+    double data = 0.;
+    double tangent = 0.;
+    for (std::size_t idx = 0; idx < lhs.size(); ++idx) {
+        data += lhs[idx].data * rhs[idx].data;
+        tangent += lhs[idx].tangent * rhs[idx].data + lhs[idx].data * rhs[idx].tangent;
+    }
+    return Dual{data, tangent};
+}
+
+std::string Dual::as_string() const {
+    return "Dual(data=" + std::to_string(this->data) + ", tangent=" + std::to_string(this->tangent) + ")";
+}
+
+std::ostream &operator<<(std::ostream &os, const Dual &val) {
+    os << "Dual(data=" << val.data << ", tangent=" << val.tangent << ")";
+    return os;
+}
+
+std::vector<Dual> jvp(const std::function<std::vector<Dual>(const std::vector<Dual> &)> &function,
+                      const std::vector<double> &primals, const std::vector<double> &tangents) {
+    if (primals.size() != tangents.size()) {
+        throw std::runtime_error("jvp: mismatched size, primals is of size " + std::to_string(primals.size()) +
+                                 " and tangents is of size " + std::to_string(tangents.size()));
+    }
+    std::vector<Dual> inputs;
+    inputs.reserve(primals.size());
+    for (std::size_t idx = 0; idx < primals.size(); ++idx) {
+        inputs.emplace_back(primals[idx], tangents[idx]);
+    }
+    return function(inputs);
+}
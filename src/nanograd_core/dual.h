@@ -0,0 +1,192 @@
+#pragma once
+// Standard Library Includes
+#include <functional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+// Local Includes
+
+// External Includes
+
+/**
+ * @brief A dual number, for forward-mode automatic differentiation.
+ *
+ * A Dual carries a tangent (the derivative along some direction of the
+ * inputs) alongside its data, and every operation computes the tangent of its
+ * result together with the data. A single evaluation on inputs seeded with a
+ * direction therefore yields the Jacobian-vector product of every output with
+ * that direction. Nothing is recorded, so the memory used doesn't grow with
+ * the number of operations, and a Dual is a plain pair of doubles which is
+ * free to copy. Prefer it over Value when there are fewer inputs (or
+ * directions) than outputs.
+ */
+class Dual {
+  /**
+   * @brief Value of the number.
+   */
+  double data;
+  /**
+   * @brief Derivative of the number along the direction being propagated.
+   */
+  double tangent;
+
+public:
+  /**
+   * @brief Create a dual number.
+   * @param data Value of the number.
+   * @param tangent Derivative of the number along the direction being propagated,
+   *     0 for a constant.
+   */
+  explicit Dual(const double data, const double tangent = 0.) : data(data), tangent(tangent) {
+  }
+
+  // region Access
+  /**
+   * @brief Get the value of the number
+   * @return Value of the number
+   */
+  [[nodiscard]] double get_data() const {
+    return this->data;
+  }
+
+  /**
+   * @brief Set the value of the number
+   * @param data New value of the number
+   */
+  void set_data(const double data) {
+    this->data = data;
+  }
+
+  /**
+   * @brief Get the derivative along the direction being propagated
+   * @return Tangent of the number
+   */
+  [[nodiscard]] double get_tangent() const {
+    return this->tangent;
+  }
+
+  /**
+   * @brief Set the derivative along the direction being propagated
+   * @param tangent New tangent of the number
+   */
+  void set_tangent(const double tangent) {
+    this->tangent = tangent;
+  }
+
+  // endregion Access
+
+  // region Operations
+  friend Dual operator+(const Dual &lhs, const Dual &rhs) {
+    return Dual{lhs.data + rhs.data, lhs.tangent + rhs.tangent};
+  }
+
+  friend Dual operator+(const Dual &lhs, const double rhs) {
+    return Dual{lhs.data + rhs, lhs.tangent};
+  }
+
+  friend Dual operator+(const double lhs, const Dual &rhs) {
+    return rhs + lhs;
+  }
+
+  friend Dual operator*(const Dual &lhs, const Dual &rhs) {
+    return Dual{lhs.data * rhs.data, lhs.tangent * rhs.data + lhs.data * rhs.tangent};
+  }
+
+  friend Dual operator*(const Dual &lhs, const double rhs) {
+    return Dual{lhs.data * rhs, lhs.tangent * rhs};
+  }
+
+  friend Dual operator*(const double lhs, const Dual &rhs) {
+    return rhs * lhs;
+  }
+
+  friend Dual operator-(const Dual &val) {
+    return Dual{-val.data, -val.tangent};
+  }
+
+  friend Dual operator-(const Dual &lhs, const Dual &rhs) {
+    return Dual{lhs.data - rhs.data, lhs.tangent - rhs.tangent};
+  }
+
+  friend Dual operator-(const Dual &lhs, const double rhs) {
+    return Dual{lhs.data - rhs, lhs.tangent};
+  }
+
+  friend Dual operator-(const double lhs, const Dual &rhs) {
+    return Dual{lhs - rhs.data, -rhs.tangent};
+  }
+
+  friend Dual operator/(const Dual &lhs, const Dual &rhs) {
+    const double quotient = lhs.data / rhs.data;
+    return Dual{quotient, (lhs.tangent - quotient * rhs.tangent) / rhs.data};
+  }
+
+  friend Dual operator/(const Dual &lhs, const double rhs) {
+    return Dual{lhs.data / rhs, lhs.tangent / rhs};
+  }
+
+  friend Dual operator/(const double lhs, const Dual &rhs) {
+    const double quotient = lhs / rhs.data;
+    return Dual{quotient, -quotient * rhs.tangent / rhs.data};
+  }
+
+  /**
+   * @brief Raise a Dual to an exponent.
+   *
+   * @param other Double representing the exponent
+   * @return Dual representing the previous value raised to the power of other
+   */
+  [[nodiscard]] Dual pow(double other) const;
+
+  /**
+   * @brief Calculate a Rectified Linear Unit (ReLU) applied to the Dual.
+   *
+   * As for Value, the derivative at 0 is taken to be 0.
+   *
+   * @return Dual representing Dual after passing through the ReLU operation
+   */
+  [[nodiscard]] Dual relu() const;
+
+  /**
+   * @brief Add up any number of Duals.
+   * @param values Duals to add up.
+   * @return Dual representing the sum of values (0 if there are none)
+   */
+  friend Dual sum(std::span<const Dual> values);
+
+  /**
+   * @brief Compute the dot product of two sequences of Duals.
+   * @param lhs First sequence of Duals.
+   * @param rhs Second sequence of Duals, of the same length as lhs.
+   * @return Dual representing the sum of lhs[i] * rhs[i]
+   */
+  friend Dual dot(std::span<const Dual> lhs, std::span<const Dual> rhs);
+
+  // endregion Operations
+
+  /**
+   * @brief Get a string representation of the dual number
+   * @return String representing the dual number
+   */
+  [[nodiscard]] std::string as_string() const;
+
+  friend std::ostream &operator<<(std::ostream &os, const Dual &val);
+};
+
+Dual sum(std::span<const Dual> values);
+
+Dual dot(std::span<const Dual> lhs, std::span<const Dual> rhs);
+
+/**
+ * @brief Compute a function and its Jacobian-vector product in a single forward sweep.
+ *
+ * @param function Function of Duals to differentiate.
+ * @param primals Point the function is evaluated at.
+ * @param tangents Direction the derivatives are taken along, of the same length as primals.
+ * @return Outputs of the function, whose tangents hold the product of the
+ *     Jacobian of the function at primals with tangents
+ */
+std::vector<Dual> jvp(const std::function<std::vector<Dual>(const std::vector<Dual> &)> &function,
+                      const std::vector<double> &primals, const std::vector<double> &tangents);
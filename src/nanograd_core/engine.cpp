@@ -1,111 +1,662 @@
 #include "engine.h"
 
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "dual.h"
+#include "kernels.h"
+
 InternalValue::InternalValue(const double data, const double grad,
-    std::unordered_set<std::shared_ptr<InternalValue>> children, std::function<void()> backwardsInternal,
-    std::string operation): data(data), grad(grad), backwardsInternal(std::move(backwardsInternal)),
+    std::vector<std::shared_ptr<InternalValue>> children, std::function<void()> backwardsInternal,
+    std::string operation): data(&this->localData), grad(&this->localGrad), localData(data), localGrad(grad),
+                            backwardsInternal(std::move(backwardsInternal)),
                             children(std::move(children)), operation(std::move(operation)) {
+    if (Profiler::is_enabled()) [[unlikely]] {
+        Profiler::recordNode(sizeof(InternalValue) + this->children.capacity() * sizeof(this->children[0]) +
+                             Profiler::heapBytesOf(this->operation), "leaf");
+    }
+}
+
+InternalValue::~InternalValue() {
+    // Take over the children which would die along with this node, so that
+    // long chains are released by this loop rather than by nested destructors
+    std::vector<std::shared_ptr<InternalValue> > pending = std::move(this->children);
+    while (!pending.empty()) {
+        std::shared_ptr<InternalValue> node = std::move(pending.back());
+        pending.pop_back();
+        if (node.use_count() == 1) {
+            std::ranges::move(node->children, std::back_inserter(pending));
+            node->children.clear();
+        }
+    }
+}
+
+void InternalValue::release() {
+    // Leaves are left alone, they can be shared with graphs used by other threads
+    if (this->children.empty()) {
+        return;
+    }
+    this->backwardsInternal = []() {
+    };
+    this->children.clear();
 }
 
 std::shared_ptr<InternalValue> InternalValue::valFromFloat(double data) {
-    return std::make_shared<InternalValue>(InternalValue{
-        data, 0., std::unordered_set<std::shared_ptr<InternalValue> >{},
+    return std::make_shared<InternalValue>(
+        data, 0., std::vector<std::shared_ptr<InternalValue> >{},
         []() {
         },
         std::string{}
-    });
-}
-
-std::vector<std::shared_ptr<InternalValue>> Value::topoSort(const Value *root) {
-    // The nodes in topological order
-    std::vector<std::shared_ptr<InternalValue> > topo{};
-    // Nodes that have already been visited
-    std::unordered_set<std::shared_ptr<InternalValue> > visited{};
-    // Get the starting InternalValue
-    const std::shared_ptr<InternalValue> start = root->val;
-
-    // Define lambda which will build the topological ordering
-    std::function<void(const std::shared_ptr<InternalValue>)> build_topo;
-    build_topo =
-            [&](const std::shared_ptr<InternalValue> &currentValue) -> void {
-                if (!visited.contains(currentValue)) {
-                    visited.insert(currentValue);
-                    for (const auto &nextVal: currentValue->children) {
-                        build_topo(nextVal);
-                    }
-                    topo.push_back(currentValue);
-                }
-            };
+    );
+}
+
+std::shared_ptr<InternalValue> InternalValue::viewOf(double *data, double *grad, std::shared_ptr<void> storage) {
+    auto out = valFromFloat(0.);
+    out->data = data;
+    out->grad = grad;
+    out->storage = std::move(storage);
+    return out;
+}
+
+thread_local bool InternalValue::concurrentGrads = false;
 
-    build_topo(start);
+thread_local bool NoGradGuard::gradEnabled = true;
 
-    return topo;
+void Value::rebind(double *data, double *grad, std::shared_ptr<void> storage) const {
+    if (this->is_view()) {
+        throw std::runtime_error("Value::rebind: Value already views an external buffer");
+    }
+    *data = *this->val->data;
+    *grad = *this->val->grad;
+    this->val->data = data;
+    this->val->grad = grad;
+    this->val->storage = std::move(storage);
+}
+
+std::atomic<std::uint64_t> Value::traversalEpoch{0};
+
+void Value::topoSort(const Value *root, std::vector<InternalValue *> &topo,
+                     std::vector<std::shared_ptr<InternalValue> > *owners) {
+    topo.clear();
+    if (owners != nullptr) {
+        owners->clear();
+    }
+    // Each traversal gets a fresh epoch, so nodes don't need to be unmarked afterwards
+    const std::uint64_t epoch = traversalEpoch.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    // Explicit DFS stack of nodes along with the index of the next child to visit,
+    // reused across calls (it's moved out while in use in case of reentrant calls)
+    // (nodes are held through the edge they were reached by, so owners can be filled)
+    thread_local std::vector<std::pair<const std::shared_ptr<InternalValue> *, std::size_t> > stackCache{};
+    std::vector<std::pair<const std::shared_ptr<InternalValue> *, std::size_t> > stack = std::move(stackCache);
+    stack.clear();
+
+    root->val->visitEpoch.store(epoch, std::memory_order_relaxed);
+    stack.emplace_back(&root->val, 0);
+    while (!stack.empty()) {
+        auto &[currentValue, nextChild] = stack.back();
+        if (nextChild < (*currentValue)->children.size()) {
+            const std::shared_ptr<InternalValue> &child = (*currentValue)->children[nextChild++];
+            // Another traversal of a shared leaf (from a concurrent checkpoint recompute)
+            // can overwrite its epoch, at worst listing it twice, which is harmless for leaves
+            if (child->visitEpoch.load(std::memory_order_relaxed) != epoch) {
+                child->visitEpoch.store(epoch, std::memory_order_relaxed);
+                stack.emplace_back(&child, 0);
+            }
+        } else {
+            // All children have been added, so the node can follow them
+            topo.push_back(currentValue->get());
+            if (owners != nullptr) {
+                owners->push_back(*currentValue);
+            }
+            stack.pop_back();
+        }
+    }
+
+    stackCache = std::move(stack);
 }
 
 Value Value::pow(double other) const {
+    const Profiler::Operation profile{"pow"};
+    if (!NoGradGuard::is_grad_enabled()) {
+        return Value{std::pow(*this->val->data, other)};
+    }
     const auto resInternalValue = std::make_shared<InternalValue>(
-        std::pow(this->val->data, other), 0.,
-        std::unordered_set<std::shared_ptr<InternalValue> >{this->val},
+        std::pow(*this->val->data, other), 0.,
+        std::vector<std::shared_ptr<InternalValue> >{this->val},
         []() {
         }, std::string{"**" + std::to_string(other)});
 
     Value out{resInternalValue};
 
-    // Get references to the internal values
-    const std::shared_ptr<InternalValue> baseInt = this->val;
-    const std::shared_ptr<InternalValue> outInt = out.val;
+    // The children are kept alive by the node, and the node owns the lambda,
+    // so plain pointers are enough (and avoid a reference cycle)
+    InternalValue *baseInt = this->val.get();
+    InternalValue *outInt = out.val.get();
     const double exponent = other;
 
-    // Capture by value to get counted references to the internal values, without needing
-    // to access the wrapping Value (which can then be managed more easily in python)
+    out.val->kind = ValueOperation::Pow;
+    out.val->operand = exponent;
     out.val->backwardsInternal = [=]() -> void {
-        baseInt->grad +=
-                (exponent * std::pow(baseInt->data, exponent - 1.0)) * outInt->grad;
+        baseInt->add_grad((exponent * std::pow(*baseInt->data, exponent - 1.0)) * *outInt->grad);
+    };
+
+    return out;
+}
+
+Value Value::affine(const double scale, const double shift) const {
+    const Profiler::Operation profile{"affine"};
+    if (!NoGradGuard::is_grad_enabled()) {
+        return Value{scale * *this->val->data + shift};
+    }
+    // The label is fixed (and short enough not to allocate), scale is kept in operand
+    const auto resInternalValue = std::make_shared<InternalValue>(
+        scale * *this->val->data + shift, 0.,
+        std::vector<std::shared_ptr<InternalValue> >{this->val},
+        []() {
+        }, std::string{"affine"});
+
+    Value out{resInternalValue};
+
+    InternalValue *selfInt = this->val.get();
+    InternalValue *outInt = out.val.get();
+
+    out.val->kind = ValueOperation::Affine;
+    out.val->operand = scale;
+    out.val->backwardsInternal = [=]() -> void {
+        selfInt->add_grad(scale * *outInt->grad);
     };
 
     return out;
 }
 
 Value Value::relu() const {
+    const Profiler::Operation profile{"ReLU"};
+    if (!NoGradGuard::is_grad_enabled()) {
+        return Value{*this->val->data < 0. ? 0. : *this->val->data};
+    }
     const auto resInternalValue = std::make_shared<InternalValue>(
-        this->val->data < 0. ? 0. : this->val->data, 0.,
-        std::unordered_set<std::shared_ptr<InternalValue> >{this->val},
+        *this->val->data < 0. ? 0. : *this->val->data, 0.,
+        std::vector<std::shared_ptr<InternalValue> >{this->val},
         []() {
         }, std::string{"ReLU"});
 
     Value out{resInternalValue};
 
-    // Get references to internal values
-    const std::shared_ptr<InternalValue> selfInt = this->val;
-    const std::shared_ptr<InternalValue> outInt = out.val;
+    InternalValue *selfInt = this->val.get();
+    InternalValue *outInt = out.val.get();
+
+    out.val->kind = ValueOperation::ReLU;
+    out.val->backwardsInternal = [=]() -> void {
+        selfInt->add_grad(*outInt->data > 0. ? *outInt->grad : 0.);
+    };
+
+    return out;
+}
+
+Value sum(const std::span<const Value> values) {
+    const Profiler::Operation profile{"sum"};
+    double data = 0.;
+    for (const auto &value: values) {
+        data += *value.val->data;
+    }
+    if (!NoGradGuard::is_grad_enabled()) {
+        return Value{data};
+    }
+    std::vector<std::shared_ptr<InternalValue> > children;
+    children.reserve(values.size());
+    for (const auto &value: values) {
+        children.push_back(value.val);
+    }
+    const auto resInternalValue = std::make_shared<InternalValue>(data, 0., std::move(children), []() {
+    }, std::string{"sum"});
+
+    Value out{resInternalValue};
+    InternalValue *outInt = out.val.get();
+    out.val->kind = ValueOperation::Sum;
+    out.val->backwardsInternal = [=]() -> void {
+        const double outGrad = *outInt->grad;
+        for (const auto &child: outInt->children) {
+            child->add_grad(outGrad);
+        }
+    };
+
+    return out;
+}
+
+Value dot(const std::span<const Value> lhs, const std::span<const Value> rhs) {
+    const Profiler::Operation profile{"dot"};
+    if (lhs.size() != rhs.size()) {
+        throw std::runtime_error(
+            "dot: mismatched size, lhs is of size " + std::to_string(lhs.size()) + " and rhs is of size " +
+            std::to_string(rhs.size()));
+    }
+    const std::size_t n = lhs.size();
+    thread_local std::vector<double> lhsData;
+    thread_local std::vector<double> rhsData;
+    lhsData.resize(n);
+    rhsData.resize(n);
+    for (std::size_t idx = 0; idx < n; ++idx) {
+        lhsData[idx] = *lhs[idx].val->data;
+        rhsData[idx] = *rhs[idx].val->data;
+    }
+    const double data = kernels::dot(lhsData.data(), rhsData.data(), n);
+    if (!NoGradGuard::is_grad_enabled()) {
+        return Value{data};
+    }
+    // The children hold the left hand sides followed by the right hand sides
+    std::vector<std::shared_ptr<InternalValue> > children;
+    children.reserve(2 * n);
+    for (const auto &value: lhs) {
+        children.push_back(value.val);
+    }
+    for (const auto &value: rhs) {
+        children.push_back(value.val);
+    }
+    const auto resInternalValue = std::make_shared<InternalValue>(data, 0., std::move(children), []() {
+    }, std::string{"dot"});
 
+    Value out{resInternalValue};
+    InternalValue *outInt = out.val.get();
+    out.val->kind = ValueOperation::Dot;
     out.val->backwardsInternal = [=]() -> void {
-        selfInt->grad += (outInt->data > 0. ? outInt->grad : 0.);
+        const double outGrad = *outInt->grad;
+        const auto &nodes = outInt->children;
+        for (std::size_t idx = 0; idx < n; ++idx) {
+            InternalValue *left = nodes[idx].get();
+            InternalValue *right = nodes[n + idx].get();
+            left->add_grad(*right->data * outGrad);
+            right->add_grad(*left->data * outGrad);
+        }
     };
 
     return out;
 }
 
 std::string Value::as_string() const {
-    return "Value(data=" + std::to_string(this->val->data) +
-           ", grad=" + std::to_string(this->val->grad) + ")";
+    return "Value(data=" + std::to_string(*this->val->data) +
+           ", grad=" + std::to_string(*this->val->grad) + ")";
 }
 
-auto Value::backwards() const -> void {
-    // Start by topologically sorting the InternalValues
-    auto nodes = Value::topoSort(this);
+std::size_t Value::count_nodes() const {
+    thread_local std::vector<InternalValue *> nodesCache{};
+    std::vector<InternalValue *> nodes = std::move(nodesCache);
+    Value::topoSort(this, nodes);
+    const std::size_t count = nodes.size();
+    nodesCache = std::move(nodes);
+    return count;
+}
+
+auto Value::backwards(const bool retainGraph) const -> void {
+    // Start by topologically sorting the InternalValues, reusing the buffer
+    // from previous calls (moved out while in use in case of reentrant calls)
+    thread_local std::vector<InternalValue *> nodesCache{};
+    std::vector<InternalValue *> nodes = std::move(nodesCache);
+    // Only filled when releasing the graph, holding every node here lets each one drop its
+    // children as soon as it is done, while the children stay alive until their own turn
+    std::vector<std::shared_ptr<InternalValue> > owners;
+    const Profiler::Span profile{"backwards", "engine"};
+    {
+        const Profiler::Span sorting{"topo sort", "engine", Profiler::Phase::TopoSort};
+        Value::topoSort(this, nodes, retainGraph ? nullptr : &owners);
+    }
+    if (Profiler::is_enabled()) [[unlikely]] {
+        Profiler::recordGraph(std::span<InternalValue *const>{nodes});
+    }
 
     /* Set value of this node to be 1 (since it is what
       the gradient is being calculated for)*/
-    this->val->grad = 1.0;
-    // Create a reverse view of the nodes vector
+    *this->val->grad = 1.0;
 
     // Iterate through the nodes in reverse order
-    for (const std::ranges::reverse_view reverseNodes{nodes}; const std::shared_ptr<InternalValue> &v: reverseNodes) {
-        (v->backwardsInternal)();
+    const Profiler::Span running{"backward pass", "engine", Profiler::Phase::Backward};
+    if (retainGraph) {
+        for (const std::ranges::reverse_view reverseNodes{nodes}; InternalValue *v: reverseNodes) {
+            (v->backwardsInternal)();
+        }
+    } else {
+        for (std::size_t idx = nodes.size(); idx-- > 0;) {
+            (nodes[idx]->backwardsInternal)();
+            nodes[idx]->release();
+            owners[idx].reset();
+        }
+    }
+
+    nodesCache = std::move(nodes);
+}
+
+namespace {
+    // State shared by the tasks of a parallel backward pass
+    struct ParallelBackwards {
+        ThreadPool &pool;
+        std::atomic<std::size_t> remaining;
+        // First exception thrown by a backward function, rethrown once the pass is over
+        std::exception_ptr error{};
+        std::mutex errorMutex{};
+        std::atomic<bool> failed{false};
+
+        // Run the backward function of a node and of the nodes it makes ready, continuing
+        // with one of them on this thread and handing the others to the pool
+        void process(InternalValue *node) {
+            const bool wasConcurrent = InternalValue::concurrentGrads;
+            InternalValue::concurrentGrads = true;
+            while (node != nullptr) {
+                // Once a backward function has thrown, the rest of the graph is only walked
+                // (without running anything) so that every node is still counted off
+                if (!this->failed.load(std::memory_order_relaxed)) {
+                    try {
+                        (node->backwardsInternal)();
+                    } catch (...) {
+                        std::lock_guard lock{this->errorMutex};
+                        if (!this->error) {
+                            this->error = std::current_exception();
+                        }
+                        this->failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+                InternalValue *next = nullptr;
+                for (const auto &child: node->children) {
+                    if (child->pendingConsumers.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                        continue;
+                    }
+                    if (next == nullptr) {
+                        next = child.get();
+                    } else {
+                        this->pool.submit([this, ready = child.get()]() { this->process(ready); });
+                    }
+                }
+                // Releases the gradients written so far to the thread waiting for the pass
+                this->remaining.fetch_sub(1, std::memory_order_release);
+                node = next;
+            }
+            InternalValue::concurrentGrads = wasConcurrent;
+        }
+    };
+}
+
+void Value::backwards(ThreadPool &pool, const bool retainGraph) const {
+    std::vector<InternalValue *> nodes;
+    const Profiler::Span profile{"parallel backwards", "engine"};
+    {
+        const Profiler::Span sorting{"topo sort", "engine", Profiler::Phase::TopoSort};
+        Value::topoSort(this, nodes);
     }
+    if (Profiler::is_enabled()) [[unlikely]] {
+        Profiler::recordGraph(std::span<InternalValue *const>{nodes});
+    }
+    const Profiler::Span running{"backward pass", "engine", Profiler::Phase::Backward};
+
+    // Count the uses of every node within the graph, once per edge so repeated
+    // children (as in x * x) are released by each of their uses
+    for (InternalValue *v: nodes) {
+        v->pendingConsumers.store(0, std::memory_order_relaxed);
+    }
+    for (InternalValue *v: nodes) {
+        for (const auto &child: v->children) {
+            child->pendingConsumers.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    *this->val->grad = 1.0;
+
+    // The root is the only node without uses, and starts on the calling thread
+    ParallelBackwards state{pool, nodes.size()};
+    state.process(this->val.get());
+    pool.help_until([&state]() { return state.remaining.load(std::memory_order_acquire) == 0; });
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+
+    if (!retainGraph) {
+        // From the leaves up, so the children a node frees have already been released themselves
+        for (InternalValue *v: nodes) {
+            v->release();
+        }
+    }
+}
+
+std::vector<Value> checkpoint(const std::function<std::vector<Value>(const std::vector<Value> &)> &segment,
+                              const std::vector<Value> &inputs) {
+    if (!NoGradGuard::is_grad_enabled()) {
+        return segment(inputs);
+    }
+    std::vector<Value> outputs;
+    {
+        NoGradGuard guard{};
+        outputs = segment(inputs);
+    }
+
+    // A single node stands for the whole segment, its children are the inputs and its
+    // parents the outputs, which pass their gradients on through a shared buffer
+    const Profiler::Operation profile{"checkpoint"};
+    std::vector<std::shared_ptr<InternalValue> > children;
+    children.reserve(inputs.size());
+    for (const auto &input: inputs) {
+        children.push_back(input.val);
+    }
+    const auto segmentInternalValue = std::make_shared<InternalValue>(0., 0., std::move(children), []() {
+    }, std::string{"checkpoint"});
+    const auto outputGrads = std::make_shared<std::vector<double> >(outputs.size(), 0.);
+
+    InternalValue *segmentInt = segmentInternalValue.get();
+    segmentInternalValue->backwardsInternal = [segmentInt, segment, outputGrads]() -> void {
+        // Recompute the segment from fresh leaves holding the data of the inputs, and seed
+        // the recomputed outputs with their gradients through a dot product with constants
+        // (recording the graph even if backwards was called under a NoGradGuard)
+        const EnableGradGuard enableGrad{};
+        std::vector<Value> leaves;
+        leaves.reserve(segmentInt->children.size());
+        for (const auto &child: segmentInt->children) {
+            leaves.emplace_back(*child->data);
+        }
+        const std::vector<Value> recomputed = segment(leaves);
+        if (recomputed.size() != outputGrads->size()) {
+            throw std::runtime_error("checkpoint: the segment returned " + std::to_string(recomputed.size()) +
+                                     " outputs, expected " + std::to_string(outputGrads->size()));
+        }
+        std::vector<Value> seeds;
+        seeds.reserve(outputGrads->size());
+        for (const double grad: *outputGrads) {
+            seeds.emplace_back(grad);
+        }
+        dot(recomputed, seeds).backwards(false);
+        for (std::size_t idx = 0; idx < leaves.size(); ++idx) {
+            segmentInt->children[idx]->add_grad(leaves[idx].get_grad());
+        }
+        std::ranges::fill(*outputGrads, 0.);
+    };
+
+    for (std::size_t idx = 0; idx < outputs.size(); ++idx) {
+        const auto resInternalValue = std::make_shared<InternalValue>(
+            outputs[idx].get_data(), 0., std::vector<std::shared_ptr<InternalValue> >{segmentInternalValue},
+            []() {
+            }, std::string{"checkpoint"});
+        InternalValue *outInt = resInternalValue.get();
+        resInternalValue->backwardsInternal = [outInt, outputGrads, idx]() -> void {
+            (*outputGrads)[idx] += *outInt->grad;
+        };
+        outputs[idx] = Value{resInternalValue};
+    }
+    return outputs;
+}
+
+namespace {
+    // The power rule needs std::pow for doubles and the pow method of Values and Duals
+    double power(const double base, const double exponent) {
+        return std::pow(base, exponent);
+    }
+
+    template<typename T>
+    T power(const T &base, const double exponent) {
+        return base.pow(exponent);
+    }
+
+    // Derivatives of a node with respect to each of its children, computed from the children as
+    // any kind of number (Values to differentiate them again, Duals to get their derivatives too)
+    template<typename T>
+    void localPartials(const InternalValue &node, const std::vector<T> &children, std::vector<T> &partials) {
+        partials.clear();
+        switch (node.kind) {
+            case ValueOperation::Add:
+                partials.assign(2, T{1.});
+                break;
+            case ValueOperation::Mul:
+                partials.push_back(children[1]);
+                partials.push_back(children[0]);
+                break;
+            case ValueOperation::Pow:
+                partials.push_back(power(children[0], node.operand - 1.0) * node.operand);
+                break;
+            case ValueOperation::Affine:
+                partials.push_back(T{node.operand});
+                break;
+            case ValueOperation::ReLU:
+                partials.push_back(T{node.get_data() > 0. ? 1. : 0.});
+                break;
+            case ValueOperation::Sum:
+                partials.assign(children.size(), T{1.});
+                break;
+            case ValueOperation::Dot: {
+                // The children hold the left hand sides followed by the right hand sides
+                const std::size_t n = children.size() / 2;
+                partials.insert(partials.end(), children.begin() + static_cast<std::ptrdiff_t>(n), children.end());
+                partials.insert(partials.end(), children.begin(), children.begin() + static_cast<std::ptrdiff_t>(n));
+                break;
+            }
+            case ValueOperation::Custom:
+                throw std::runtime_error("grad: the derivatives of a " + node.operation +
+                                         " node can only be propagated by backwards");
+        }
+    }
+}
+
+std::vector<Value> grad(const Value &output, const std::vector<Value> &inputs, const bool createGraph) {
+    const Profiler::Span profile{"grad", "engine"};
+    std::vector<InternalValue *> nodes;
+    Value::topoSort(&output, nodes);
+
+    // Without createGraph the gradients are still computed as Values, but as leaves
+    std::optional<NoGradGuard> noGrad;
+    if (!createGraph) {
+        noGrad.emplace();
+    }
+
+    // Gradient of output with respect to every node reached so far, filled from output down to the leaves
+    std::unordered_map<const InternalValue *, Value> grads;
+    grads.reserve(nodes.size());
+    grads.emplace(output.val.get(), Value{1.0});
+    std::vector<Value> children;
+    std::vector<Value> partials;
+    for (const std::ranges::reverse_view reverseNodes{nodes}; InternalValue *node: reverseNodes) {
+        const auto found = grads.find(node);
+        if (node->children.empty() || found == grads.end()) {
+            continue;
+        }
+        const Value outGrad = found->second;
+        children.clear();
+        for (const auto &child: node->children) {
+            children.emplace_back(child);
+        }
+        localPartials(*node, children, partials);
+        for (std::size_t idx = 0; idx < partials.size(); ++idx) {
+            Value contribution = outGrad * partials[idx];
+            if (auto [entry, inserted] = grads.try_emplace(node->children[idx].get(), contribution); !inserted) {
+                entry->second = entry->second + contribution;
+            }
+        }
+    }
+
+    std::vector<Value> out;
+    out.reserve(inputs.size());
+    for (const auto &input: inputs) {
+        const auto found = grads.find(input.val.get());
+        out.push_back(found == grads.end() ? Value{0.} : found->second);
+    }
+    return out;
+}
+
+std::vector<double> hvp(const Value &output, const std::vector<Value> &inputs, const std::vector<double> &vector) {
+    if (inputs.size() != vector.size()) {
+        throw std::runtime_error("hvp: mismatched size, inputs is of size " + std::to_string(inputs.size()) +
+                                 " and vector is of size " + std::to_string(vector.size()));
+    }
+    const Profiler::Span profile{"hvp", "engine"};
+    std::vector<InternalValue *> nodes;
+    Value::topoSort(&output, nodes);
+    std::unordered_map<const InternalValue *, std::size_t> positions;
+    positions.reserve(nodes.size());
+    for (std::size_t idx = 0; idx < nodes.size(); ++idx) {
+        positions.emplace(nodes[idx], idx);
+    }
+    // The index of every child in the sorted nodes, looked up once for both sweeps
+    std::vector<std::size_t> childStarts(nodes.size() + 1, 0);
+    std::vector<std::size_t> childPositions;
+    for (std::size_t idx = 0; idx < nodes.size(); ++idx) {
+        for (const auto &child: nodes[idx]->children) {
+            childPositions.push_back(positions.at(child.get()));
+        }
+        childStarts[idx + 1] = childPositions.size();
+    }
+
+    // Forward sweep: derivative of every node along vector, children coming before their parents
+    std::vector<double> tangents(nodes.size(), 0.);
+    for (std::size_t idx = 0; idx < inputs.size(); ++idx) {
+        if (const auto found = positions.find(inputs[idx].val.get()); found != positions.end()) {
+            tangents[found->second] += vector[idx];
+        }
+    }
+    std::vector<double> childData;
+    std::vector<double> partials;
+    for (std::size_t idx = 0; idx < nodes.size(); ++idx) {
+        if (nodes[idx]->children.empty()) {
+            continue;
+        }
+        childData.clear();
+        for (const auto &child: nodes[idx]->children) {
+            childData.push_back(*child->data);
+        }
+        localPartials(*nodes[idx], childData, partials);
+        for (std::size_t child = 0; child < partials.size(); ++child) {
+            tangents[idx] += partials[child] * tangents[childPositions[childStarts[idx] + child]];
+        }
+    }
+
+    // Reverse sweep: the gradient of every node as a Dual, whose tangent is the derivative of the
+    // gradient along vector, since the local derivatives are computed from the children as Duals
+    std::vector<Dual> grads(nodes.size(), Dual{0.});
+    grads.back() = Dual{1.0};
+    std::vector<Dual> childDuals;
+    std::vector<Dual> dualPartials;
+    for (std::size_t idx = nodes.size(); idx-- > 0;) {
+        if (nodes[idx]->children.empty()) {
+            continue;
+        }
+        childDuals.clear();
+        for (std::size_t child = childStarts[idx]; child < childStarts[idx + 1]; ++child) {
+            childDuals.emplace_back(*nodes[childPositions[child]]->data, tangents[childPositions[child]]);
+        }
+        localPartials(*nodes[idx], childDuals, dualPartials);
+        for (std::size_t child = 0; child < dualPartials.size(); ++child) {
+            Dual &childGrad = grads[childPositions[childStarts[idx] + child]];
+            childGrad = childGrad + grads[idx] * dualPartials[child];
+        }
+    }
+
+    std::vector<double> out;
+    out.reserve(inputs.size());
+    for (const auto &input: inputs) {
+        const auto found = positions.find(input.val.get());
+        out.push_back(found == positions.end() ? 0. : grads[found->second].get_tangent());
+    }
+    return out;
 }
 
 std::ostream & operator<<(std::ostream &os, const Value &val) {
-    os << "Value(data=" << val.val->data << ", grad=" << val.val->grad << ")";
+    os << "Value(data=" << *val.val->data << ", grad=" << *val.val->grad << ")";
     return os;
 }
@@ -1,19 +1,110 @@
 #pragma once
 // Standard Library Includes
+#include <atomic>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <ostream>
 #include <memory>
 #include <ranges>
+#include <span>
 #include <string>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
 // Local Includes
+#include "profiler.h"
+#include "thread_pool.h"
 
 // External Includes
 
+/**
+ * @brief Turns off recording the graph on the current thread while it is alive.
+ *
+ * Under the guard, operations on Values and Tensors only compute their data:
+ * the results are leaves, without children or backward functions, so running
+ * a model for predictions costs no more than the arithmetic itself. Guards
+ * can be nested, and each one restores the previous mode when destroyed.
+ */
+class NoGradGuard {
+  friend class EnableGradGuard;
+  /**
+   * @brief Whether operations on the current thread record the graph.
+   */
+  static thread_local bool gradEnabled;
+  /**
+   * @brief Mode to restore when the guard is destroyed.
+   */
+  bool previous;
+
+public:
+  NoGradGuard() : previous(gradEnabled) {
+    gradEnabled = false;
+  }
+
+  ~NoGradGuard() {
+    gradEnabled = this->previous;
+  }
+
+  NoGradGuard(const NoGradGuard &) = delete;
+
+  NoGradGuard &operator=(const NoGradGuard &) = delete;
+
+  /**
+   * @brief Check whether operations on the current thread record the graph.
+   * @return False while a NoGradGuard is alive on the current thread
+   */
+  static bool is_grad_enabled() {
+    return gradEnabled;
+  }
+};
+
+/**
+ * @brief Turns recording the graph back on while it is alive, even under a
+ *     NoGradGuard.
+ *
+ * Used where a graph is needed regardless of the mode of the caller, such as
+ * recomputing a checkpoint segment during a backward pass.
+ */
+class EnableGradGuard {
+  /**
+   * @brief Mode to restore when the guard is destroyed.
+   */
+  bool previous;
+
+public:
+  EnableGradGuard() : previous(NoGradGuard::gradEnabled) {
+    NoGradGuard::gradEnabled = true;
+  }
+
+  ~EnableGradGuard() {
+    NoGradGuard::gradEnabled = this->previous;
+  }
+
+  EnableGradGuard(const EnableGradGuard &) = delete;
+
+  EnableGradGuard &operator=(const EnableGradGuard &) = delete;
+};
+
+/**
+ * @brief Kind of operation which produced a node of the graph.
+ *
+ * Lets grad and hvp recompute the local derivatives of a node with other
+ * kinds of numbers than doubles. Nodes with a Custom backward function (such
+ * as the outputs of a checkpoint) can only be differentiated by backwards.
+ */
+enum class ValueOperation : std::uint8_t {
+  Custom,
+  Add,
+  Mul,
+  Pow,
+  Affine,
+  ReLU,
+  Sum,
+  Dot
+};
+
 /**
  * @brief Represents a single scalar value and its gradient
  */
@@ -21,13 +112,30 @@ class InternalValue {
 public:
   /**
    * @brief The internal data associated with the Value.
+   *
+   * Points to localData, unless the Value is a view of an element of an
+   * external buffer (such as the weights of a Layer).
    */
-  double data;
+  double *data;
   /**
    * @brief The value of the current derivative of the Value.
    *
+   * Points to localGrad, unless the Value is a view of an element of an
+   * external buffer.
+   */
+  double *grad;
+  /**
+   * @brief Storage for the data of a Value which isn't a view.
+   */
+  double localData;
+  /**
+   * @brief Storage for the gradient of a Value which isn't a view.
    */
-  double grad;
+  double localGrad;
+  /**
+   * @brief Keeps the buffer viewed by the Value alive (empty if not a view).
+   */
+  std::shared_ptr<void> storage;
   /**
    * @brief Lambda expression used for calculating the
    * gradient during backpropagation.
@@ -37,12 +145,43 @@ public:
    * @brief Children of the current value node.
    *
    */
-  std::unordered_set<std::shared_ptr<InternalValue> > children;
+  std::vector<std::shared_ptr<InternalValue> > children;
   /**
    * @brief Operation that produced this node.
    *
    */
   std::string operation;
+  /**
+   * @brief Kind of operation that produced this node.
+   */
+  ValueOperation kind = ValueOperation::Custom;
+  /**
+   * @brief Constant operand of the operation (the exponent of pow, the scale
+   *     of affine), 0 otherwise.
+   */
+  double operand = 0.;
+  /**
+   * @brief Epoch of the last graph traversal which visited this node.
+   *
+   * Used in place of a visited set when sorting the graph, a node has been
+   * visited by a traversal if its epoch matches the one of the traversal.
+   * Atomic since checkpoint segments recomputed concurrently by a parallel
+   * backward pass can sort graphs sharing the same leaves; relaxed accesses
+   * suffice as each traversal only compares against its own epoch.
+   */
+  std::atomic<std::uint64_t> visitEpoch{0};
+  /**
+   * @brief Number of nodes whose gradient still has to be propagated into
+   *     this one, used to schedule a parallel backward pass.
+   */
+  std::atomic<std::uint32_t> pendingConsumers{0};
+  /**
+   * @brief Whether gradients accumulated by the current thread may be
+   *     accumulated concurrently by other threads too.
+   *
+   * Set while the thread runs part of a parallel backward pass.
+   */
+  static thread_local bool concurrentGrads;
   /**
    * @brief Construct a new Internal Value object
    *
@@ -54,9 +193,30 @@ public:
    * @param operation Operation which produced this node.
    */
   InternalValue(const double data, const double grad,
-                std::unordered_set<std::shared_ptr<InternalValue> > children,
+                std::vector<std::shared_ptr<InternalValue> > children,
                 std::function<void()> backwardsInternal,
                 std::string operation);;
+
+  // data and grad can point into the object itself, so it can't be copied
+  InternalValue(const InternalValue &) = delete;
+
+  InternalValue &operator=(const InternalValue &) = delete;
+
+  /**
+   * @brief Destroy the node, releasing the children it owns iteratively.
+   *
+   * Destroying the root of a long chain would otherwise recurse once per
+   * node and could overflow the call stack.
+   */
+  ~InternalValue();
+
+  /**
+   * @brief Drop the children and backward function of the node, turning it
+   *     into a leaf holding its current data and gradient (leaves are left
+   *     untouched).
+   */
+  void release();
+
   /**
    * @brief Create a new InternalObject from a literal float value.
    *
@@ -65,12 +225,22 @@ public:
    */
   static std::shared_ptr<InternalValue> valFromFloat(double data);;
 
+  /**
+   * @brief Create a new InternalObject viewing an element of an external buffer.
+   *
+   * @param data Location of the data of the new Value.
+   * @param grad Location of the gradient of the new Value.
+   * @param storage Owner of the buffer, kept alive as long as the view.
+   * @return std::shared_ptr<InternalValue>
+   */
+  static std::shared_ptr<InternalValue> viewOf(double *data, double *grad, std::shared_ptr<void> storage);
+
   /**
    * @brief Get the current value of the gradient.
    * @return grad, the current value of the gradient.
    */
   double get_grad() const {
-    return this->grad;
+    return *this->grad;
   }
 
   /**
@@ -78,7 +248,7 @@ public:
    * @param grad New value for grad
    */
   void set_grad(const double grad) {
-    this->grad = grad;
+    *this->grad = grad;
   }
 
   /**
@@ -86,7 +256,7 @@ public:
    * @return Current value of data
    */
   double get_data() const {
-    return this->data;
+    return *this->data;
   }
 
   /**
@@ -94,14 +264,30 @@ public:
    * @param data New value for data
    */
   void set_data(double data) {
-    this->data = data;
+    *this->data = data;
+  }
+
+  /**
+   * @brief Add to the gradient.
+   *
+   * The addition is atomic during a parallel backward pass, since several
+   * nodes using this one can then propagate their gradient at the same time.
+   *
+   * @param delta Amount added to the gradient
+   */
+  void add_grad(const double delta) {
+    if (concurrentGrads) [[unlikely]] {
+      std::atomic_ref<double>{*this->grad}.fetch_add(delta, std::memory_order_relaxed);
+    } else {
+      *this->grad += delta;
+    }
   }
 
   /**
    * @brief Set the value of grad to 0.0.
    */
   void zero_grad() {
-    this->grad = 0.0;
+    *this->grad = 0.0;
   }
 };
 
@@ -111,14 +297,39 @@ class Value {
    */
   std::shared_ptr<InternalValue> val;
 
+  /**
+   * @brief Source of the epochs used to mark nodes visited by a traversal.
+   */
+  static std::atomic<std::uint64_t> traversalEpoch;
+
   /**
    * @brief Topologically sort the expression graph starting from a given root.
    *
+   * The graph is walked with an explicit stack, so arbitrarily deep graphs can
+   * be sorted without overflowing the call stack. The nodes are only kept
+   * alive by the graph itself, so the root must outlive the returned order.
+   *
    * @param root Root Value to start the topological sort from.
-   * @return std::vector<InternalValue> Nodes in topological order
+   * @param topo Vector the nodes are written to in topological order, any
+   *     previous contents are discarded.
+   * @param owners If not null, filled with a counted reference to each node
+   *     of topo, so the nodes outlive edges dropped while walking the order.
    */
-  static std::vector<std::shared_ptr<InternalValue> >
-  topoSort(const Value *root);;
+  static void topoSort(const Value *root, std::vector<InternalValue *> &topo,
+                       std::vector<std::shared_ptr<InternalValue> > *owners = nullptr);
+
+  /**
+   * @brief Scale and shift the Value by constants.
+   *
+   * The constants are stored in the new node rather than as leaves of their
+   * own, so combining a Value with a double only creates a single node and
+   * no gradient is tracked for the constants.
+   *
+   * @param scale Constant the Value is multiplied by.
+   * @param shift Constant added after scaling.
+   * @return Value representing scale * this + shift
+   */
+  [[nodiscard]] Value affine(double scale, double shift) const;
 
 public:
   /**
@@ -139,6 +350,46 @@ public:
       InternalValue::valFromFloat(literalValue)
     }) {
   };
+
+  /**
+   * @brief Create a Value viewing an element of an external buffer.
+   *
+   * Reading or writing the data or gradient of the Value (including while
+   * computing gradients) reads or writes the buffer directly.
+   *
+   * @param data Location of the data of the new Value.
+   * @param grad Location of the gradient of the new Value.
+   * @param storage Owner of the buffer, kept alive as long as the Value.
+   * @return Value viewing the element
+   */
+  static Value view(double *data, double *grad, std::shared_ptr<void> storage) {
+    return Value{InternalValue::viewOf(data, grad, std::move(storage))};
+  }
+
+  /**
+   * @brief Move the data and gradient of the Value into an external buffer.
+   *
+   * The current data and gradient are copied to the new location, and from
+   * then on the Value (and every copy of it) reads and writes the buffer,
+   * as if it had been created by view. Values which already view a buffer
+   * (see is_view) can't be rebound, since the owner of that buffer would
+   * silently stop seeing them.
+   *
+   * @param data New location of the data of the Value.
+   * @param grad New location of the gradient of the Value.
+   * @param storage Owner of the buffer, kept alive as long as the Value.
+   * @throws std::runtime_error If the Value is already a view.
+   */
+  void rebind(double *data, double *grad, std::shared_ptr<void> storage) const;
+
+  /**
+   * @brief Check whether the Value views an external buffer
+   * @return true if the data and gradient live in a buffer owned elsewhere
+   * (e.g. a Module's parameters or a Tensor element)
+   */
+  [[nodiscard]] bool is_view() const {
+    return this->val->storage != nullptr;
+  }
   // region Access
   /**
    * @brief Get the current value of the gradient
@@ -190,11 +441,15 @@ public:
    * @return Value representing the two previous values being added
    */
   friend Value operator+(const Value &lhs, const Value &rhs) {
+    const Profiler::Operation profile{"+"};
+    if (!NoGradGuard::is_grad_enabled()) {
+      return Value{*lhs.val->data + *rhs.val->data};
+    }
     // Create a new internal value for the addition node
     auto resInternalValue = std::make_shared<InternalValue>(
-      lhs.val->data + rhs.val->data, // data
+      *lhs.val->data + *rhs.val->data, // data
       0., // grad
-      std::unordered_set<std::shared_ptr<InternalValue> >{
+      std::vector<std::shared_ptr<InternalValue> >{
         lhs.val,
         rhs.val
       }, // children
@@ -207,28 +462,29 @@ public:
     // Construct the Value to be returned
     Value out{resInternalValue};
 
-    // Get references to the internal values
-    const std::shared_ptr<InternalValue> lhsInt = lhs.val;
-    const std::shared_ptr<InternalValue> rhsInt = rhs.val;
-    const std::shared_ptr<InternalValue> outInt = out.val;
-
+    // The children are kept alive by the node, and the node owns the lambda,
+    // so plain pointers are enough (and avoid a reference cycle)
+    InternalValue *lhsInt = lhs.val.get();
+    InternalValue *rhsInt = rhs.val.get();
+    InternalValue *outInt = out.val.get();
 
     // Construct the backwards function for the Out Value
+    out.val->kind = ValueOperation::Add;
     out.val->backwardsInternal = [=]() -> void {
       // Compute the gradients
-      lhsInt->grad += outInt->grad;
-      rhsInt->grad += outInt->grad;
+      lhsInt->add_grad(*outInt->grad);
+      rhsInt->add_grad(*outInt->grad);
     };
 
     return out;
   }
 
   friend Value operator+(const Value &lhs, const double rhs) {
-    return lhs + Value{rhs};
+    return lhs.affine(1.0, rhs);
   }
 
   friend Value operator+(const double lhs, const Value &rhs) {
-    return Value{lhs} + rhs;
+    return rhs.affine(1.0, lhs);
   }
 
   /**
@@ -240,34 +496,37 @@ public:
 
    */
   friend Value operator*(const Value &lhs, const Value &rhs) {
+    const Profiler::Operation profile{"*"};
+    if (!NoGradGuard::is_grad_enabled()) {
+      return Value{*lhs.val->data * *rhs.val->data};
+    }
     const auto resInternalValue = std::make_shared<InternalValue>(
-      lhs.val->data * rhs.val->data, 0.,
-      std::unordered_set<std::shared_ptr<InternalValue> >{lhs.val, rhs.val},
+      *lhs.val->data * *rhs.val->data, 0.,
+      std::vector<std::shared_ptr<InternalValue> >{lhs.val, rhs.val},
       []() {
       }, std::string{"*"});
 
     Value out{resInternalValue};
-    // Get references to the internal values
-    std::shared_ptr<InternalValue> lhsInt = lhs.val;
-    std::shared_ptr<InternalValue> rhsInt = rhs.val;
-    std::shared_ptr<InternalValue> outInt = out.val;
+    InternalValue *lhsInt = lhs.val.get();
+    InternalValue *rhsInt = rhs.val.get();
+    InternalValue *outInt = out.val.get();
 
-    // copy by value so it holds a counted reference to the
+    out.val->kind = ValueOperation::Mul;
     out.val->backwardsInternal = [=]() -> void {
       // Compute the gradients
-      lhsInt->grad += rhsInt->data * outInt->grad;
-      rhsInt->grad += lhsInt->data * outInt->grad;
+      lhsInt->add_grad(*rhsInt->data * *outInt->grad);
+      rhsInt->add_grad(*lhsInt->data * *outInt->grad);
     };
 
     return out;
   }
 
   friend Value operator*(const Value &lhs, double rhs) {
-    return lhs * Value{rhs};
+    return lhs.affine(rhs, 0.);
   }
 
   friend Value operator*(double lhs, const Value &rhs) {
-    return Value{lhs} * rhs;
+    return rhs.affine(lhs, 0.);
   }
 
   /**
@@ -292,7 +551,7 @@ public:
    * @return Value
    */
   friend Value operator-(const Value &val) {
-    return val * -1.;
+    return val.affine(-1., 0.);
   };
 
   friend Value operator-(const Value &lhs, const Value &rhs) {
@@ -300,11 +559,11 @@ public:
   }
 
   friend Value operator-(const Value &lhs, const double rhs) {
-    return lhs - Value{rhs};
+    return lhs.affine(1.0, -rhs);
   }
 
   friend Value operator-(const double lhs, const Value &rhs) {
-    return Value{lhs} - rhs;
+    return rhs.affine(-1.0, lhs);
   }
 
   friend Value operator/(const Value &lhs, const Value &rhs) {
@@ -312,15 +571,99 @@ public:
   }
 
   friend Value operator/(const Value &lhs, const double rhs) {
-    return lhs / Value{rhs};
+    return lhs.affine(1.0 / rhs, 0.);
   }
 
   friend Value operator/(const double lhs, const Value &rhs) {
-    return Value{lhs} / rhs;
+    return rhs.pow(-1.0).affine(lhs, 0.);
   }
 
   friend std::ostream &operator<<(std::ostream &os, const Value &val);
 
+  /**
+   * @brief Add up any number of Values as a single node.
+   *
+   * A chain of binary additions creates a node per term (and a graph as deep
+   * as the number of terms), while this creates one node whose backward pass
+   * passes the gradient to every term in a single loop.
+   *
+   * @param values Values to add up.
+   * @return Value representing the sum of values (0 if there are none)
+   */
+  friend Value sum(std::span<const Value> values);
+
+  /**
+   * @brief Compute the dot product of two sequences of Values as a single node.
+   *
+   * The data is gathered into contiguous buffers and multiplied by a
+   * vectorized kernel, and the backward pass scatters the gradients of both
+   * sides in a single loop.
+   *
+   * @param lhs Values on the left hand side of the products.
+   * @param rhs Values on the right hand side of the products, must be the
+   *     same length as lhs.
+   * @return Value representing the sum of lhs[i] * rhs[i]
+   */
+  friend Value dot(std::span<const Value> lhs, std::span<const Value> rhs);
+
+  /**
+   * @brief Run part of a computation without keeping its intermediate nodes,
+   *     recomputing them when the gradient is needed.
+   *
+   * The segment first runs without recording the graph, so only its outputs
+   * are stored. When the backward pass reaches the outputs, the segment runs
+   * again from the data of the inputs, this time recording its graph, which
+   * is used to propagate the gradient and released right away. Checkpointing
+   * the segments of a deep computation bounds the memory held by its graph to
+   * the outputs of every segment plus the nodes of a single segment, at the
+   * cost of running the forward pass twice.
+   *
+   * @param segment Function computing the outputs of the segment from its
+   *     inputs, it must give the same results every time it's called and
+   *     must stay valid until the backward pass is done.
+   * @param inputs Inputs of the segment.
+   * @return Outputs of the segment
+   */
+  friend std::vector<Value> checkpoint(
+    const std::function<std::vector<Value>(const std::vector<Value> &)> &segment,
+    const std::vector<Value> &inputs);
+
+  /**
+   * @brief Compute the gradients of a Value with respect to some inputs, as Values.
+   *
+   * Unlike backwards, the gradients are returned rather than accumulated into
+   * the grad of the nodes, which are left untouched. With createGraph, the
+   * gradients are computed by operations on Values, so they are part of a
+   * graph themselves and can be differentiated again (e.g. to get second
+   * derivatives). The graph of output can't contain checkpoint nodes.
+   *
+   * @param output Value to differentiate.
+   * @param inputs Values to differentiate output with respect to.
+   * @param createGraph Whether to record the graph of the gradients, otherwise
+   *     they are leaves.
+   * @return Gradient of output with respect to every input (0 for inputs
+   *     output doesn't depend on)
+   */
+  friend std::vector<Value> grad(const Value &output, const std::vector<Value> &inputs, bool createGraph);
+
+  /**
+   * @brief Compute the product of the Hessian of a Value with a vector.
+   *
+   * Forward-over-reverse: a forward sweep propagates the derivatives of
+   * every node along vector, then a reverse sweep propagates the gradient as
+   * Duals, whose tangents hold the derivative of the gradient along vector.
+   * The cost is a small multiple of a backward pass, no node is created and
+   * the Hessian is never formed, so it scales to the parameters of a model.
+   * The graph of output can't contain checkpoint nodes.
+   *
+   * @param output Value whose Hessian is taken.
+   * @param inputs Values the Hessian is taken with respect to.
+   * @param vector Vector multiplied with the Hessian, of the same length as inputs.
+   * @return Product of the Hessian of output with respect to inputs with vector
+   */
+  friend std::vector<double> hvp(const Value &output, const std::vector<Value> &inputs,
+                                 const std::vector<double> &vector);
+
   /**
    * @brief Get a string representation of the Value.
    * @return String representing the Value
@@ -332,10 +675,57 @@ public:
 
   // region backpropagation
 
+  /**
+   * @brief Count the nodes of the graph leading to this Value.
+   *
+   * Walks the graph in the same way as backwards, so it also measures the
+   * cost of the traversal on its own.
+   *
+   * @return Number of distinct nodes, including this one and the leaves
+   */
+  [[nodiscard]] std::size_t count_nodes() const;
+
   /**
    * @brief Compute the Value of the gradients for the current Value
+   *
+   * @param retainGraph Whether to keep the graph so that backwards can be
+   *     called again. Otherwise every node is released as soon as its
+   *     gradient has been propagated, so a node no longer referenced outside
+   *     the graph is freed during the pass, and the nodes which are left
+   *     (such as this one) become leaves.
    */
-  void backwards() const;;
+  void backwards(bool retainGraph = true) const;
+
+  /**
+   * @brief Compute the Value of the gradients for the current Value, in parallel
+   *
+   * Every node counts the nodes which still have to propagate their gradient
+   * into it, and becomes ready to run once that count drops to 0, so
+   * independent parts of the graph (such as the neurons of a Layer) are
+   * processed by several threads at once. Chains of nodes run on a single
+   * thread without going through the pool. Gradients are accumulated
+   * atomically, so leaves shared by several parts of the graph get the same
+   * gradients as with the sequential pass (up to rounding). If a backward
+   * function throws, the remaining ones are skipped and the first exception
+   * is rethrown once every task of the pass has finished.
+   *
+   * @param pool Pool of threads to run the backward pass on, the calling
+   *     thread helps while waiting for it to finish.
+   * @param retainGraph Whether to keep the graph so that backwards can be
+   *     called again, otherwise it is released once the pass is done.
+   */
+  void backwards(ThreadPool &pool, bool retainGraph = true) const;
 
   // endregion backpropagation
 };
+
+Value sum(std::span<const Value> values);
+
+Value dot(std::span<const Value> lhs, std::span<const Value> rhs);
+
+std::vector<Value> checkpoint(const std::function<std::vector<Value>(const std::vector<Value> &)> &segment,
+                              const std::vector<Value> &inputs);
+
+std::vector<Value> grad(const Value &output, const std::vector<Value> &inputs, bool createGraph = false);
+
+std::vector<double> hvp(const Value &output, const std::vector<Value> &inputs, const std::vector<double> &vector);
@@ -0,0 +1,481 @@
+#include "kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+// Some AVX-512 intrinsics pass _mm512_undefined_pd()/_ps() (self-initialized
+// registers) to their builtins, which GCC reports as uninitialized once they
+// are inlined. The diagnostics point into the header, so they're silenced here
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+namespace {
+    // Thin wrappers around the widest SIMD instructions available, overloaded
+    // for float and double, so each kernel below is only written once.
+    // NANOGRAD_SIMD is left undefined when no supported instruction set is
+    // available, and the kernels then only run their scalar loops.
+#if defined(__AVX512F__)
+#define NANOGRAD_SIMD
+    namespace simd {
+        template<typename T>
+        struct registerOf;
+        template<>
+        struct registerOf<double> {
+            using type = __m512d;
+        };
+        template<>
+        struct registerOf<float> {
+            using type = __m512;
+        };
+
+        template<typename T>
+        using vec = typename registerOf<T>::type;
+        template<typename T>
+        constexpr std::size_t lanes = 64 / sizeof(T);
+
+        inline __m512d load(const double *p) { return _mm512_loadu_pd(p); }
+        inline void store(double *p, const __m512d v) { _mm512_storeu_pd(p, v); }
+        inline __m512d set1(const double x) { return _mm512_set1_pd(x); }
+        inline __m512d add(const __m512d a, const __m512d b) { return _mm512_add_pd(a, b); }
+        inline __m512d mul(const __m512d a, const __m512d b) { return _mm512_mul_pd(a, b); }
+        inline __m512d fmadd(const __m512d a, const __m512d b, const __m512d c) { return _mm512_fmadd_pd(a, b, c); }
+        inline __m512d div(const __m512d a, const __m512d b) { return _mm512_div_pd(a, b); }
+        inline __m512d sqrt(const __m512d a) { return _mm512_sqrt_pd(a); }
+        inline __m512d max(const __m512d a, const __m512d b) { return _mm512_max_pd(a, b); }
+        inline double hsum(const __m512d v) { return _mm512_reduce_add_pd(v); }
+
+        // Lanes of x where mask is positive, zero elsewhere
+        inline __m512d wherePositive(const __m512d mask, const __m512d x) {
+            return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(mask, _mm512_setzero_pd(), _CMP_GT_OQ), x);
+        }
+
+        inline __m512 load(const float *p) { return _mm512_loadu_ps(p); }
+        inline void store(float *p, const __m512 v) { _mm512_storeu_ps(p, v); }
+        inline __m512 set1(const float x) { return _mm512_set1_ps(x); }
+        inline __m512 add(const __m512 a, const __m512 b) { return _mm512_add_ps(a, b); }
+        inline __m512 mul(const __m512 a, const __m512 b) { return _mm512_mul_ps(a, b); }
+        inline __m512 fmadd(const __m512 a, const __m512 b, const __m512 c) { return _mm512_fmadd_ps(a, b, c); }
+        inline __m512 div(const __m512 a, const __m512 b) { return _mm512_div_ps(a, b); }
+        inline __m512 sqrt(const __m512 a) { return _mm512_sqrt_ps(a); }
+        inline __m512 max(const __m512 a, const __m512 b) { return _mm512_max_ps(a, b); }
+        inline float hsum(const __m512 v) { return _mm512_reduce_add_ps(v); }
+
+        inline __m512 wherePositive(const __m512 mask, const __m512 x) {
+            return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(mask, _mm512_setzero_ps(), _CMP_GT_OQ), x);
+        }
+
+        template<typename T>
+        vec<T> zero() { return set1(T{0}); }
+    }
+#elif defined(__AVX2__)
+#define NANOGRAD_SIMD
+    namespace simd {
+        template<typename T>
+        struct registerOf;
+        template<>
+        struct registerOf<double> {
+            using type = __m256d;
+        };
+        template<>
+        struct registerOf<float> {
+            using type = __m256;
+        };
+
+        template<typename T>
+        using vec = typename registerOf<T>::type;
+        template<typename T>
+        constexpr std::size_t lanes = 32 / sizeof(T);
+
+        inline __m256d load(const double *p) { return _mm256_loadu_pd(p); }
+        inline void store(double *p, const __m256d v) { _mm256_storeu_pd(p, v); }
+        inline __m256d set1(const double x) { return _mm256_set1_pd(x); }
+        inline __m256d add(const __m256d a, const __m256d b) { return _mm256_add_pd(a, b); }
+        inline __m256d mul(const __m256d a, const __m256d b) { return _mm256_mul_pd(a, b); }
+        inline __m256d div(const __m256d a, const __m256d b) { return _mm256_div_pd(a, b); }
+        inline __m256d sqrt(const __m256d a) { return _mm256_sqrt_pd(a); }
+        inline __m256d max(const __m256d a, const __m256d b) { return _mm256_max_pd(a, b); }
+
+        inline double hsum(const __m256d v) {
+            const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+        }
+
+        // Lanes of x where mask is positive, zero elsewhere
+        inline __m256d wherePositive(const __m256d mask, const __m256d x) {
+            return _mm256_and_pd(_mm256_cmp_pd(mask, _mm256_setzero_pd(), _CMP_GT_OQ), x);
+        }
+
+        inline __m256 load(const float *p) { return _mm256_loadu_ps(p); }
+        inline void store(float *p, const __m256 v) { _mm256_storeu_ps(p, v); }
+        inline __m256 set1(const float x) { return _mm256_set1_ps(x); }
+        inline __m256 add(const __m256 a, const __m256 b) { return _mm256_add_ps(a, b); }
+        inline __m256 mul(const __m256 a, const __m256 b) { return _mm256_mul_ps(a, b); }
+        inline __m256 div(const __m256 a, const __m256 b) { return _mm256_div_ps(a, b); }
+        inline __m256 sqrt(const __m256 a) { return _mm256_sqrt_ps(a); }
+        inline __m256 max(const __m256 a, const __m256 b) { return _mm256_max_ps(a, b); }
+
+        inline float hsum(const __m256 v) {
+            __m128 quad = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            quad = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+            return _mm_cvtss_f32(_mm_add_ss(quad, _mm_movehdup_ps(quad)));
+        }
+
+        inline __m256 wherePositive(const __m256 mask, const __m256 x) {
+            return _mm256_and_ps(_mm256_cmp_ps(mask, _mm256_setzero_ps(), _CMP_GT_OQ), x);
+        }
+
+#if defined(__FMA__) || defined(_MSC_VER)
+        inline __m256d fmadd(const __m256d a, const __m256d b, const __m256d c) { return _mm256_fmadd_pd(a, b, c); }
+        inline __m256 fmadd(const __m256 a, const __m256 b, const __m256 c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+        inline __m256d fmadd(const __m256d a, const __m256d b, const __m256d c) { return add(mul(a, b), c); }
+        inline __m256 fmadd(const __m256 a, const __m256 b, const __m256 c) { return add(mul(a, b), c); }
+#endif
+
+        template<typename T>
+        vec<T> zero() { return set1(T{0}); }
+    }
+#endif
+
+    // Sizes of the blocks the matrix products are split into, chosen so the
+    // block of the right hand matrix being reused stays in cache
+    constexpr std::size_t blockRows = 64;
+    constexpr std::size_t blockCols = 256;
+    constexpr std::size_t blockInner = 128;
+}
+
+namespace kernels {
+    template<typename T>
+    T dot(const T *x, const T *y, const std::size_t n) {
+        std::size_t i = 0;
+        T result = 0;
+#ifdef NANOGRAD_SIMD
+        // Two accumulators to hide the latency of the fused multiply-adds
+        simd::vec<T> acc0 = simd::zero<T>();
+        simd::vec<T> acc1 = simd::zero<T>();
+        for (; i + 2 * simd::lanes<T> <= n; i += 2 * simd::lanes<T>) {
+            acc0 = simd::fmadd(simd::load(x + i), simd::load(y + i), acc0);
+            acc1 = simd::fmadd(simd::load(x + i + simd::lanes<T>), simd::load(y + i + simd::lanes<T>), acc1);
+        }
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            acc0 = simd::fmadd(simd::load(x + i), simd::load(y + i), acc0);
+        }
+        result = simd::hsum(simd::add(acc0, acc1));
+#else
+        T partial[4] = {0, 0, 0, 0};
+        for (; i + 4 <= n; i += 4) {
+            partial[0] += x[i] * y[i];
+            partial[1] += x[i + 1] * y[i + 1];
+            partial[2] += x[i + 2] * y[i + 2];
+            partial[3] += x[i + 3] * y[i + 3];
+        }
+        result = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+#endif
+        for (; i < n; ++i) {
+            result += x[i] * y[i];
+        }
+        return result;
+    }
+
+    template<typename T>
+    T sum(const T *x, const std::size_t n) {
+        std::size_t i = 0;
+        T result = 0;
+#ifdef NANOGRAD_SIMD
+        simd::vec<T> acc0 = simd::zero<T>();
+        simd::vec<T> acc1 = simd::zero<T>();
+        for (; i + 2 * simd::lanes<T> <= n; i += 2 * simd::lanes<T>) {
+            acc0 = simd::add(simd::load(x + i), acc0);
+            acc1 = simd::add(simd::load(x + i + simd::lanes<T>), acc1);
+        }
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            acc0 = simd::add(simd::load(x + i), acc0);
+        }
+        result = simd::hsum(simd::add(acc0, acc1));
+#else
+        T partial[4] = {0, 0, 0, 0};
+        for (; i + 4 <= n; i += 4) {
+            partial[0] += x[i];
+            partial[1] += x[i + 1];
+            partial[2] += x[i + 2];
+            partial[3] += x[i + 3];
+        }
+        result = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+#endif
+        for (; i < n; ++i) {
+            result += x[i];
+        }
+        return result;
+    }
+
+    template<typename T>
+    void axpy(const std::type_identity_t<T> alpha, const T *x, T *y, const std::size_t n) {
+        std::size_t i = 0;
+#ifdef NANOGRAD_SIMD
+        const simd::vec<T> alphaVec = simd::set1(alpha);
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            simd::store(y + i, simd::fmadd(alphaVec, simd::load(x + i), simd::load(y + i)));
+        }
+#endif
+        for (; i < n; ++i) {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    template<typename T>
+    void add(const T *x, const T *y, T *out, const std::size_t n) {
+        std::size_t i = 0;
+#ifdef NANOGRAD_SIMD
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            simd::store(out + i, simd::add(simd::load(x + i), simd::load(y + i)));
+        }
+#endif
+        for (; i < n; ++i) {
+            out[i] = x[i] + y[i];
+        }
+    }
+
+    template<typename T>
+    void mul(const T *x, const T *y, T *out, const std::size_t n) {
+        std::size_t i = 0;
+#ifdef NANOGRAD_SIMD
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            simd::store(out + i, simd::mul(simd::load(x + i), simd::load(y + i)));
+        }
+#endif
+        for (; i < n; ++i) {
+            out[i] = x[i] * y[i];
+        }
+    }
+
+    template<typename T>
+    void mulAdd(const T *x, const T *y, T *out, const std::size_t n) {
+        std::size_t i = 0;
+#ifdef NANOGRAD_SIMD
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            simd::store(out + i, simd::fmadd(simd::load(x + i), simd::load(y + i), simd::load(out + i)));
+        }
+#endif
+        for (; i < n; ++i) {
+            out[i] += x[i] * y[i];
+        }
+    }
+
+    template<typename T>
+    void relu(const T *x, T *out, const std::size_t n) {
+        std::size_t i = 0;
+#ifdef NANOGRAD_SIMD
+        const simd::vec<T> zeroVec = simd::zero<T>();
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            simd::store(out + i, simd::max(simd::load(x + i), zeroVec));
+        }
+#endif
+        for (; i < n; ++i) {
+            out[i] = x[i] < 0 ? T{0} : x[i];
+        }
+    }
+
+    template<typename T>
+    void reluBackwards(const T *out, const T *gradOut, T *gradIn, const std::size_t n) {
+        std::size_t i = 0;
+#ifdef NANOGRAD_SIMD
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            const simd::vec<T> passed = simd::wherePositive(simd::load(out + i), simd::load(gradOut + i));
+            simd::store(gradIn + i, simd::add(simd::load(gradIn + i), passed));
+        }
+#endif
+        for (; i < n; ++i) {
+            gradIn[i] += out[i] > 0 ? gradOut[i] : T{0};
+        }
+    }
+
+    template<typename T>
+    void sgdStep(T *data, T *grad, const std::size_t n, const std::type_identity_t<T> learningRate,
+                 const bool zeroGrad) {
+        std::size_t i = 0;
+#ifdef NANOGRAD_SIMD
+        const simd::vec<T> stepVec = simd::set1(-learningRate);
+        const simd::vec<T> zeroVec = simd::zero<T>();
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            simd::store(data + i, simd::fmadd(stepVec, simd::load(grad + i), simd::load(data + i)));
+            if (zeroGrad) {
+                simd::store(grad + i, zeroVec);
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            data[i] -= learningRate * grad[i];
+            if (zeroGrad) {
+                grad[i] = 0;
+            }
+        }
+    }
+
+    template<typename T>
+    void momentumStep(T *data, T *grad, T *velocity, const std::size_t n,
+                      const std::type_identity_t<T> learningRate, const std::type_identity_t<T> momentum,
+                      const bool zeroGrad) {
+        std::size_t i = 0;
+#ifdef NANOGRAD_SIMD
+        const simd::vec<T> momentumVec = simd::set1(momentum);
+        const simd::vec<T> stepVec = simd::set1(-learningRate);
+        const simd::vec<T> zeroVec = simd::zero<T>();
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            const simd::vec<T> v = simd::fmadd(momentumVec, simd::load(velocity + i), simd::load(grad + i));
+            simd::store(velocity + i, v);
+            simd::store(data + i, simd::fmadd(stepVec, v, simd::load(data + i)));
+            if (zeroGrad) {
+                simd::store(grad + i, zeroVec);
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            velocity[i] = momentum * velocity[i] + grad[i];
+            data[i] -= learningRate * velocity[i];
+            if (zeroGrad) {
+                grad[i] = 0;
+            }
+        }
+    }
+
+    template<typename T>
+    void adamStep(T *data, T *grad, T *m, T *v, const std::size_t n,
+                  const std::type_identity_t<T> beta1, const std::type_identity_t<T> beta2,
+                  const std::type_identity_t<T> stepSize, const std::type_identity_t<T> epsilon,
+                  const bool zeroGrad) {
+        std::size_t i = 0;
+#ifdef NANOGRAD_SIMD
+        const simd::vec<T> beta1Vec = simd::set1(beta1);
+        const simd::vec<T> beta2Vec = simd::set1(beta2);
+        const simd::vec<T> oneMinusBeta1Vec = simd::set1(1 - beta1);
+        const simd::vec<T> oneMinusBeta2Vec = simd::set1(1 - beta2);
+        const simd::vec<T> stepVec = simd::set1(-stepSize);
+        const simd::vec<T> epsilonVec = simd::set1(epsilon);
+        const simd::vec<T> zeroVec = simd::zero<T>();
+        for (; i + simd::lanes<T> <= n; i += simd::lanes<T>) {
+            const simd::vec<T> g = simd::load(grad + i);
+            const simd::vec<T> mNew = simd::fmadd(beta1Vec, simd::load(m + i), simd::mul(oneMinusBeta1Vec, g));
+            const simd::vec<T> vNew = simd::fmadd(beta2Vec, simd::load(v + i),
+                                                  simd::mul(oneMinusBeta2Vec, simd::mul(g, g)));
+            simd::store(m + i, mNew);
+            simd::store(v + i, vNew);
+            const simd::vec<T> update = simd::div(mNew, simd::add(simd::sqrt(vNew), epsilonVec));
+            simd::store(data + i, simd::fmadd(stepVec, update, simd::load(data + i)));
+            if (zeroGrad) {
+                simd::store(grad + i, zeroVec);
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            const T g = grad[i];
+            m[i] = beta1 * m[i] + (1 - beta1) * g;
+            v[i] = beta2 * v[i] + (1 - beta2) * (g * g);
+            data[i] -= stepSize * (m[i] / (std::sqrt(v[i]) + epsilon));
+            if (zeroGrad) {
+                grad[i] = 0;
+            }
+        }
+    }
+
+    template<typename T>
+    void gemv(const std::size_t m, const std::size_t k, const T *a, const T *x, T *y) {
+        for (std::size_t i = 0; i < m; ++i) {
+            y[i] += dot(a + i * k, x, k);
+        }
+    }
+
+    template<typename T>
+    void gemvT(const std::size_t m, const std::size_t k, const T *a, const T *x, T *y) {
+        for (std::size_t i = 0; i < m; ++i) {
+            axpy(x[i], a + i * k, y, k);
+        }
+    }
+
+    template<typename T>
+    void ger(const std::size_t m, const std::size_t k, const T *x, const T *y, T *a) {
+        for (std::size_t i = 0; i < m; ++i) {
+            axpy(x[i], y, a + i * k, k);
+        }
+    }
+
+    template<typename T>
+    void gemmNN(const std::size_t m, const std::size_t n, const std::size_t k,
+                const T *a, const T *b, T *c) {
+        // Each row of C is built from rows of B scaled by the matching row of A,
+        // blocked so the panel of B in use stays in cache across the rows of A
+        for (std::size_t jj = 0; jj < n; jj += blockCols) {
+            const std::size_t cols = std::min(blockCols, n - jj);
+            for (std::size_t pp = 0; pp < k; pp += blockInner) {
+                const std::size_t pEnd = std::min(pp + blockInner, k);
+                for (std::size_t i = 0; i < m; ++i) {
+                    for (std::size_t p = pp; p < pEnd; ++p) {
+                        axpy(a[i * k + p], b + p * n + jj, c + i * n + jj, cols);
+                    }
+                }
+            }
+        }
+    }
+
+    template<typename T>
+    void gemmNT(const std::size_t m, const std::size_t n, const std::size_t k,
+                const T *a, const T *b, T *c) {
+        // Every entry of C is the dot product of a row of A with a row of B,
+        // blocked over the rows of B so they are reused from cache
+        for (std::size_t jj = 0; jj < n; jj += blockRows) {
+            const std::size_t jEnd = std::min(jj + blockRows, n);
+            for (std::size_t i = 0; i < m; ++i) {
+                for (std::size_t j = jj; j < jEnd; ++j) {
+                    c[i * n + j] += dot(a + i * k, b + j * k, k);
+                }
+            }
+        }
+    }
+
+    template<typename T>
+    void gemmTN(const std::size_t m, const std::size_t n, const std::size_t k,
+                const T *a, const T *b, T *c) {
+        // Row p of A and B contribute the outer product of the two rows to C,
+        // blocked over the rows of C so they stay in cache across p
+        for (std::size_t ii = 0; ii < m; ii += blockRows) {
+            const std::size_t iEnd = std::min(ii + blockRows, m);
+            for (std::size_t p = 0; p < k; ++p) {
+                for (std::size_t i = ii; i < iEnd; ++i) {
+                    axpy(a[p * m + i], b + p * n, c + i * n, n);
+                }
+            }
+        }
+    }
+
+    // Explicit instantiations for the supported scalar types
+#define NANOGRAD_INSTANTIATE_KERNELS(T) \
+    template T dot<T>(const T *, const T *, std::size_t); \
+    template T sum<T>(const T *, std::size_t); \
+    template void axpy<T>(T, const T *, T *, std::size_t); \
+    template void add<T>(const T *, const T *, T *, std::size_t); \
+    template void mul<T>(const T *, const T *, T *, std::size_t); \
+    template void mulAdd<T>(const T *, const T *, T *, std::size_t); \
+    template void relu<T>(const T *, T *, std::size_t); \
+    template void reluBackwards<T>(const T *, const T *, T *, std::size_t); \
+    template void sgdStep<T>(T *, T *, std::size_t, T, bool); \
+    template void momentumStep<T>(T *, T *, T *, std::size_t, T, T, bool); \
+    template void adamStep<T>(T *, T *, T *, T *, std::size_t, T, T, T, T, bool); \
+    template void gemv<T>(std::size_t, std::size_t, const T *, const T *, T *); \
+    template void gemvT<T>(std::size_t, std::size_t, const T *, const T *, T *); \
+    template void ger<T>(std::size_t, std::size_t, const T *, const T *, T *); \
+    template void gemmNN<T>(std::size_t, std::size_t, std::size_t, const T *, const T *, T *); \
+    template void gemmNT<T>(std::size_t, std::size_t, std::size_t, const T *, const T *, T *); \
+    template void gemmTN<T>(std::size_t, std::size_t, std::size_t, const T *, const T *, T *);
+
+    NANOGRAD_INSTANTIATE_KERNELS(float)
+    NANOGRAD_INSTANTIATE_KERNELS(double)
+#undef NANOGRAD_INSTANTIATE_KERNELS
+}
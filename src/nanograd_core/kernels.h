@@ -0,0 +1,234 @@
+#pragma once
+// Standard Library Includes
+#include <cstddef>
+#include <type_traits>
+
+// Local Includes
+
+// External Includes
+
+/**
+ * @brief Dense numeric kernels used by the Tensor operations.
+ *
+ * Every kernel works on raw, contiguous, row-major buffers. When the library
+ * is compiled for a machine supporting AVX-512 or AVX2 (for example with the
+ * NANOGRAD_NATIVE CMake option) the kernels use the matching SIMD
+ * instructions, otherwise they fall back to plain loops.
+ *
+ * The kernels are templates over the scalar type, instantiated for float and
+ * double. The float kernels process twice as many elements per instruction
+ * and accumulate in float. Scalar parameters (such as the scale of axpy)
+ * take the scalar type of the buffers, so they can be passed as doubles.
+ */
+namespace kernels {
+  /**
+   * @brief Compute the dot product of two vectors.
+   *
+   * @param x First vector.
+   * @param y Second vector.
+   * @param n Length of the vectors.
+   * @return Sum of x[i] * y[i]
+   */
+  template<typename T>
+  T dot(const T *x, const T *y, std::size_t n);
+
+  /**
+   * @brief Compute the sum of the elements of a vector.
+   *
+   * @param x Vector to sum.
+   * @param n Length of the vector.
+   * @return Sum of x[i]
+   */
+  template<typename T>
+  T sum(const T *x, std::size_t n);
+
+  /**
+   * @brief Add a scaled vector to another (y += alpha * x).
+   *
+   * @param alpha Scale applied to x.
+   * @param x Vector being added.
+   * @param y Vector being added to.
+   * @param n Length of the vectors.
+   */
+  template<typename T>
+  void axpy(std::type_identity_t<T> alpha, const T *x, T *y, std::size_t n);
+
+  /**
+   * @brief Add two vectors elementwise (out = x + y).
+   *
+   * @param x First vector.
+   * @param y Second vector.
+   * @param out Output vector, can alias x or y.
+   * @param n Length of the vectors.
+   */
+  template<typename T>
+  void add(const T *x, const T *y, T *out, std::size_t n);
+
+  /**
+   * @brief Multiply two vectors elementwise (out = x * y).
+   *
+   * @param x First vector.
+   * @param y Second vector.
+   * @param out Output vector, can alias x or y.
+   * @param n Length of the vectors.
+   */
+  template<typename T>
+  void mul(const T *x, const T *y, T *out, std::size_t n);
+
+  /**
+   * @brief Accumulate an elementwise product into a vector (out += x * y).
+   *
+   * @param x First vector.
+   * @param y Second vector.
+   * @param out Vector being added to.
+   * @param n Length of the vectors.
+   */
+  template<typename T>
+  void mulAdd(const T *x, const T *y, T *out, std::size_t n);
+
+  /**
+   * @brief Apply a ReLU elementwise (out = max(x, 0)).
+   *
+   * @param x Input vector.
+   * @param out Output vector, can alias x.
+   * @param n Length of the vectors.
+   */
+  template<typename T>
+  void relu(const T *x, T *out, std::size_t n);
+
+  /**
+   * @brief Accumulate the gradient of a ReLU (gradIn += out > 0 ? gradOut : 0).
+   *
+   * @param out Output of the ReLU.
+   * @param gradOut Gradient with respect to the output of the ReLU.
+   * @param gradIn Gradient with respect to the input of the ReLU, added to.
+   * @param n Length of the vectors.
+   */
+  template<typename T>
+  void reluBackwards(const T *out, const T *gradOut, T *gradIn, std::size_t n);
+
+  /**
+   * @brief Take a gradient descent step (data -= learningRate * grad).
+   *
+   * @param data Parameters being updated.
+   * @param grad Gradient of the parameters.
+   * @param n Number of parameters.
+   * @param learningRate Step size.
+   * @param zeroGrad Whether to set grad to 0 in the same pass.
+   */
+  template<typename T>
+  void sgdStep(T *data, T *grad, std::size_t n, std::type_identity_t<T> learningRate, bool zeroGrad);
+
+  /**
+   * @brief Take a gradient descent step with momentum
+   * (velocity = momentum * velocity + grad, data -= learningRate * velocity).
+   *
+   * @param data Parameters being updated.
+   * @param grad Gradient of the parameters.
+   * @param velocity Running velocity of the parameters, updated.
+   * @param n Number of parameters.
+   * @param learningRate Step size.
+   * @param momentum Decay of the velocity.
+   * @param zeroGrad Whether to set grad to 0 in the same pass.
+   */
+  template<typename T>
+  void momentumStep(T *data, T *grad, T *velocity, std::size_t n, std::type_identity_t<T> learningRate,
+                    std::type_identity_t<T> momentum, bool zeroGrad);
+
+  /**
+   * @brief Take an Adam step, with the bias corrections folded into stepSize and epsilon.
+   *
+   * Computes m = beta1 * m + (1 - beta1) * grad, v = beta2 * v + (1 - beta2) * grad^2
+   * and data -= stepSize * m / (sqrt(v) + epsilon).
+   *
+   * @param data Parameters being updated.
+   * @param grad Gradient of the parameters.
+   * @param m Running mean of the gradient, updated.
+   * @param v Running mean of the squared gradient, updated.
+   * @param n Number of parameters.
+   * @param beta1 Decay of the mean of the gradient.
+   * @param beta2 Decay of the mean of the squared gradient.
+   * @param stepSize Step size, including the bias corrections.
+   * @param epsilon Term keeping the denominator away from 0, including the bias correction.
+   * @param zeroGrad Whether to set grad to 0 in the same pass.
+   */
+  template<typename T>
+  void adamStep(T *data, T *grad, T *m, T *v, std::size_t n, std::type_identity_t<T> beta1,
+                std::type_identity_t<T> beta2, std::type_identity_t<T> stepSize, std::type_identity_t<T> epsilon,
+                bool zeroGrad);
+
+  /**
+   * @brief Accumulate a matrix-vector product (y += A * x).
+   *
+   * @param m Number of rows of A and length of y.
+   * @param k Number of columns of A and length of x.
+   * @param a Row-major m by k matrix.
+   * @param x Vector of length k.
+   * @param y Vector of length m being added to.
+   */
+  template<typename T>
+  void gemv(std::size_t m, std::size_t k, const T *a, const T *x, T *y);
+
+  /**
+   * @brief Accumulate a transposed matrix-vector product (y += A^T * x).
+   *
+   * @param m Number of rows of A and length of x.
+   * @param k Number of columns of A and length of y.
+   * @param a Row-major m by k matrix.
+   * @param x Vector of length m.
+   * @param y Vector of length k being added to.
+   */
+  template<typename T>
+  void gemvT(std::size_t m, std::size_t k, const T *a, const T *x, T *y);
+
+  /**
+   * @brief Accumulate an outer product (A += x * y^T).
+   *
+   * @param m Length of x and number of rows of A.
+   * @param k Length of y and number of columns of A.
+   * @param x Vector of length m.
+   * @param y Vector of length k.
+   * @param a Row-major m by k matrix being added to.
+   */
+  template<typename T>
+  void ger(std::size_t m, std::size_t k, const T *x, const T *y, T *a);
+
+  /**
+   * @brief Accumulate a matrix product (C += A * B).
+   *
+   * @param m Number of rows of A and C.
+   * @param n Number of columns of B and C.
+   * @param k Number of columns of A and rows of B.
+   * @param a Row-major m by k matrix.
+   * @param b Row-major k by n matrix.
+   * @param c Row-major m by n matrix being added to.
+   */
+  template<typename T>
+  void gemmNN(std::size_t m, std::size_t n, std::size_t k, const T *a, const T *b, T *c);
+
+  /**
+   * @brief Accumulate a matrix product with the second matrix transposed (C += A * B^T).
+   *
+   * @param m Number of rows of A and C.
+   * @param n Number of rows of B and columns of C.
+   * @param k Number of columns of A and B.
+   * @param a Row-major m by k matrix.
+   * @param b Row-major n by k matrix.
+   * @param c Row-major m by n matrix being added to.
+   */
+  template<typename T>
+  void gemmNT(std::size_t m, std::size_t n, std::size_t k, const T *a, const T *b, T *c);
+
+  /**
+   * @brief Accumulate a matrix product with the first matrix transposed (C += A^T * B).
+   *
+   * @param m Number of columns of A and rows of C.
+   * @param n Number of columns of B and C.
+   * @param k Number of rows of A and B.
+   * @param a Row-major k by m matrix.
+   * @param b Row-major k by n matrix.
+   * @param c Row-major m by n matrix being added to.
+   */
+  template<typename T>
+  void gemmTN(std::size_t m, std::size_t n, std::size_t k, const T *a, const T *b, T *c);
+}
@@ -0,0 +1,60 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &path) {
+    std::shared_ptr<MappedFile> out{new MappedFile{}};
+#ifndef _WIN32
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("MappedFile::open: unable to open " + path);
+    }
+    struct stat status{};
+    if (::fstat(descriptor, &status) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error("MappedFile::open: unable to read the size of " + path);
+    }
+    out->length = static_cast<std::size_t>(status.st_size);
+    if (out->length > 0) {
+        // Private, so the pages can be written (e.g. by training) without touching the file
+        void *address = ::mmap(nullptr, out->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+        if (address == MAP_FAILED) {
+            ::close(descriptor);
+            throw std::runtime_error("MappedFile::open: unable to map " + path);
+        }
+        out->address = static_cast<std::byte *>(address);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(descriptor);
+#else
+    std::ifstream file{path, std::ios::binary | std::ios::ate};
+    if (!file) {
+        throw std::runtime_error("MappedFile::open: unable to open " + path);
+    }
+    out->buffer.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(out->buffer.data()), static_cast<std::streamsize>(out->buffer.size()))) {
+        throw std::runtime_error("MappedFile::open: unable to read " + path);
+    }
+    out->address = out->buffer.data();
+    out->length = out->buffer.size();
+#endif
+    return out;
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (this->address != nullptr) {
+        ::munmap(this->address, this->length);
+    }
+#endif
+}
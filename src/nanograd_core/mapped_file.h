@@ -0,0 +1,59 @@
+#pragma once
+// Standard Library Includes
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Local Includes
+
+// External Includes
+
+/**
+ * @brief The contents of a file, mapped into memory where the platform allows it.
+ *
+ * On POSIX systems the file is mapped copy-on-write: its pages are only read
+ * from disk when first touched, processes mapping the same file share them
+ * in the page cache, and writes to the bytes stay private to the process
+ * (the file itself is never modified). Elsewhere the file is read into a
+ * heap buffer, which behaves the same but is read up front.
+ */
+class MappedFile {
+  /**
+   * @brief Start of the contents of the file.
+   */
+  std::byte *address = nullptr;
+  /**
+   * @brief Size of the file in bytes.
+   */
+  std::size_t length = 0;
+  /**
+   * @brief Contents of the file when it couldn't be mapped.
+   */
+  std::vector<std::byte> buffer;
+
+  MappedFile() = default;
+
+public:
+  /**
+   * @brief Map a file into memory.
+   * @param path File to map.
+   * @return Mapping of the file, unmapped once the last owner releases it
+   */
+  static std::shared_ptr<MappedFile> open(const std::string &path);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * @brief Get the contents of the file.
+   * @return Writable view of the bytes of the file, starting on a page boundary when mapped
+   */
+  [[nodiscard]] std::span<std::byte> bytes() const {
+    return {this->address, this->length};
+  }
+};
@@ -3,29 +3,321 @@
 //
 #include <nn.h>
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
 #include <utility>
 
-Neuron::Neuron(const int nin, const bool nonlinear): b(Value{0.}), nonlinear(nonlinear) {
-    // create a random number generator
-    std::random_device rd;
-    std::mt19937 rng{rd()};
-    std::uniform_real_distribution distribution(-1.0, 1.0);
+#include "kernels.h"
+#include "mapped_file.h"
+#include "philox.h"
+#include "profiler.h"
+#include "thread_pool.h"
 
-    for (int i = 0; i < nin; i++) {
-        double newWeight = distribution(rng);
-        this->w.emplace_back(newWeight);
+namespace {
+    // Number of weights initialized by a single task
+    constexpr std::size_t initializationChunk = 1 << 14;
+
+    // Half the width of the range the weights of a Layer are drawn from
+    double weightBound(const Initialization initialization, const std::size_t nin, const std::size_t nout) {
+        switch (initialization) {
+            case Initialization::Xavier:
+                return std::sqrt(6.0 / static_cast<double>(nin + nout));
+            case Initialization::He:
+                return std::sqrt(6.0 / static_cast<double>(nin));
+            case Initialization::Uniform:
+            default:
+                return 1.0;
+        }
+    }
+
+    // Layout of the files written by MultiLayerPerceptron::save, every number little-endian:
+    //   the magic bytes "NGRADMLP", the version (u32), flags (u32), the number of
+    //   inputs, of Layers, of parameters and of optimizer state values (u64 each),
+    //   then the number of outputs and the nonlinearity (u64 each) of every Layer,
+    //   zero padding up to a multiple of modelAlignment, the parameters (f64) and
+    //   finally the optimizer state (f64).
+    constexpr char modelMagic[8] = {'N', 'G', 'R', 'A', 'D', 'M', 'L', 'P'};
+    constexpr std::uint32_t modelVersion = 1;
+    constexpr std::uint32_t hasOptimizerState = 1;
+    // Keeps the parameters of a mapped file aligned for the vectorized kernels
+    constexpr std::size_t modelAlignment = 64;
+    constexpr std::size_t fixedHeaderSize = sizeof(modelMagic) + 2 * sizeof(std::uint32_t) + 4 * sizeof(std::uint64_t);
+    constexpr bool littleEndian = std::endian::native == std::endian::little;
+
+    template<typename T>
+    T toLittleEndian(T value) {
+        if constexpr (!littleEndian) {
+            auto bytes = std::bit_cast<std::array<std::byte, sizeof(T)> >(value);
+            std::reverse(bytes.begin(), bytes.end());
+            value = std::bit_cast<T>(bytes);
+        }
+        return value;
+    }
+
+    template<typename T>
+    void appendLittleEndian(std::string &out, const T value) {
+        const T converted = toLittleEndian(value);
+        out.append(reinterpret_cast<const char *>(&converted), sizeof(T));
+    }
+
+    // Reads the header of a model file one number at a time, checking it stays within the file
+    class ModelReader {
+        std::span<const std::byte> bytes;
+        const std::string &path;
+        std::size_t position = 0;
+
+    public:
+        ModelReader(const std::span<const std::byte> bytes, const std::string &path) : bytes(bytes), path(path) {
+        }
+
+        template<typename T>
+        T read() {
+            if (this->bytes.size() - this->position < sizeof(T)) {
+                this->fail("truncated header");
+            }
+            T value;
+            std::memcpy(&value, this->bytes.data() + this->position, sizeof(T));
+            this->position += sizeof(T);
+            return toLittleEndian(value);
+        }
+
+        [[noreturn]] void fail(const std::string &reason) const {
+            throw std::runtime_error("MultiLayerPerceptron::load: " + reason + " in " + this->path);
+        }
+
+        [[nodiscard]] std::size_t get_position() const {
+            return this->position;
+        }
+    };
+
+    struct ModelHeader {
+        int nin = 0;
+        std::vector<int> nouts;
+        std::size_t parameterCount = 0;
+        std::size_t stateCount = 0;
+        bool hasState = false;
+        // Position of the parameters in the file
+        std::size_t dataOffset = 0;
+    };
+
+    std::size_t paddedHeaderSize(const std::size_t layerCount) {
+        const std::size_t size = fixedHeaderSize + 2 * sizeof(std::uint64_t) * layerCount;
+        return (size + modelAlignment - 1) / modelAlignment * modelAlignment;
+    }
+
+    ModelHeader readModelHeader(const std::span<const std::byte> bytes, const std::string &path) {
+        ModelReader reader{bytes, path};
+        char magic[sizeof(modelMagic)];
+        for (char &c: magic) {
+            c = reader.read<char>();
+        }
+        if (!std::equal(std::begin(magic), std::end(magic), std::begin(modelMagic))) {
+            reader.fail("not a MultiLayerPerceptron file");
+        }
+        const auto version = reader.read<std::uint32_t>();
+        if (version != modelVersion) {
+            reader.fail("unsupported version " + std::to_string(version));
+        }
+        const auto flags = reader.read<std::uint32_t>();
+        const auto nin = reader.read<std::uint64_t>();
+        const auto layerCount = reader.read<std::uint64_t>();
+        const auto parameterCount = reader.read<std::uint64_t>();
+        const auto stateCount = reader.read<std::uint64_t>();
+        if (nin == 0 || nin > std::numeric_limits<int>::max()) {
+            reader.fail("invalid number of inputs");
+        }
+        if (layerCount > (bytes.size() - reader.get_position()) / (2 * sizeof(std::uint64_t))) {
+            reader.fail("truncated header");
+        }
+
+        ModelHeader header;
+        header.nin = static_cast<int>(nin);
+        for (std::uint64_t idx = 0; idx < layerCount; ++idx) {
+            const auto nout = reader.read<std::uint64_t>();
+            const auto nonlinear = reader.read<std::uint64_t>();
+            if (nout == 0 || nout > std::numeric_limits<int>::max()) {
+                reader.fail("invalid number of outputs for Layer " + std::to_string(idx));
+            }
+            // Every Layer but the last applies a ReLU
+            if ((nonlinear != 0) != (idx + 1 != layerCount)) {
+                reader.fail("unsupported nonlinearity for Layer " + std::to_string(idx));
+            }
+            header.nouts.push_back(static_cast<int>(nout));
+        }
+        header.parameterCount = parameterCount;
+        header.stateCount = stateCount;
+        header.hasState = (flags & hasOptimizerState) != 0;
+        header.dataOffset = paddedHeaderSize(layerCount);
+
+        std::size_t expectedCount = 0;
+        int layerNin = header.nin;
+        for (const int nout: header.nouts) {
+            expectedCount += static_cast<std::size_t>(nout) * (static_cast<std::size_t>(layerNin) + 1);
+            layerNin = nout;
+        }
+        if (parameterCount != expectedCount) {
+            reader.fail("mismatched number of parameters");
+        }
+        const std::size_t available = bytes.size() >= header.dataOffset ? bytes.size() - header.dataOffset : 0;
+        if (available % sizeof(double) != 0 || available / sizeof(double) < parameterCount ||
+            available / sizeof(double) - parameterCount != stateCount) {
+            reader.fail("mismatched file size");
+        }
+        return header;
+    }
+
+    // Copy a block of little-endian numbers out of a file
+    std::vector<double> readDoubles(const std::span<const std::byte> bytes, const std::size_t offset,
+                                    const std::size_t count) {
+        std::vector<double> out(count);
+        std::memcpy(out.data(), bytes.data() + offset, count * sizeof(double));
+        if constexpr (!littleEndian) {
+            std::transform(out.begin(), out.end(), out.begin(), toLittleEndian<double>);
+        }
+        return out;
+    }
+
+    void writeDoubles(std::ofstream &file, const std::span<const double> values) {
+        if constexpr (littleEndian) {
+            file.write(reinterpret_cast<const char *>(values.data()),
+                       static_cast<std::streamsize>(values.size() * sizeof(double)));
+        } else {
+            std::vector<double> converted(values.size());
+            std::transform(values.begin(), values.end(), converted.begin(), toLittleEndian<double>);
+            file.write(reinterpret_cast<const char *>(converted.data()),
+                       static_cast<std::streamsize>(converted.size() * sizeof(double)));
+        }
+    }
+
+    // Model given to a DataParallelTrainer, which needs at least one Layer to know its number of outputs
+    const MultiLayerPerceptron &trainableModel(const MultiLayerPerceptron &mlp) {
+        if (mlp.get_layers().empty()) {
+            throw std::runtime_error("DataParallelTrainer::DataParallelTrainer: the MultiLayerPerceptron has no layers");
+        }
+        return mlp;
     }
 }
 
+template<typename T>
+BasicModule<T>::BasicModule(const std::vector<Value> &params) requires std::same_as<T, double> : params(params) {
+    // Checked up front so that no Value is moved if the constructor throws
+    for (const auto &param: this->params) {
+        if (param.is_view()) {
+            throw std::runtime_error("Module::Module: Value already belongs to another Module or Tensor");
+        }
+    }
+    this->bind_parameters(std::make_shared<ParameterBuffer>(params.size()), 0, params.size());
+    for (std::size_t idx = 0; idx < this->params.size(); ++idx) {
+        this->params[idx].rebind(this->parameter_data() + idx, this->parameter_grad() + idx, this->parameterBuffer);
+    }
+}
+
+template<typename T>
+void BasicModule<T>::bind_parameters(std::shared_ptr<BasicParameterBuffer<T> > buffer, const std::size_t offset,
+                                     const std::size_t count) {
+    this->parameterBuffer = std::move(buffer);
+    this->parameterOffset = offset;
+    this->parameterCount = count;
+}
+
+template<typename T>
+void BasicModule<T>::zero_grad() const {
+    if (this->parameterCount > 0) {
+        std::memset(this->parameter_grad(), 0, this->parameterCount * sizeof(T));
+    }
+}
+
+template<typename T>
+std::span<T> BasicModule<T>::get_parameter_data() const {
+    if (this->parameterCount == 0) {
+        return {};
+    }
+    return {this->parameter_data(), this->parameterCount};
+}
+
+template<typename T>
+std::span<T> BasicModule<T>::get_parameter_grads() const {
+    if (this->parameterCount == 0) {
+        return {};
+    }
+    return {this->parameter_grad(), this->parameterCount};
+}
+
+template<typename T>
+BasicTensor<T> BasicModule<T>::get_flat_parameters() const {
+    if (this->parameterCount == 0) {
+        return BasicTensor<T>::zeros({0});
+    }
+    return BasicTensor<T>::view({this->parameterCount}, this->parameter_data(), this->parameter_grad(),
+                                this->parameterBuffer);
+}
+
+Neuron::Neuron(const int nin, const bool nonlinear, const Initialization initialization,
+               const std::optional<std::uint64_t> seed): b(Value{0.}), nonlinear(nonlinear) {
+    const auto count = static_cast<std::size_t>(nin) + 1;
+    this->bind_parameters(std::make_shared<ParameterBuffer>(count), 0, count);
+
+    // The weights come first in the buffer, followed by the bias (left at 0)
+    const double bound = weightBound(initialization, static_cast<std::size_t>(nin), 1);
+    Philox::uniform(this->parameter_data(), count - 1, 0, -bound, bound, seed.value_or(Philox::random_seed()), 0);
+    this->params.reserve(count);
+    for (std::size_t idx = 0; idx < count; ++idx) {
+        this->params.push_back(Value::view(this->parameter_data() + idx, this->parameter_grad() + idx,
+                                           this->parameterBuffer));
+    }
+    this->w.assign(this->params.begin(), this->params.end() - 1);
+    this->b = this->params.back();
+}
+
 Value Neuron::operator()(const std::vector<Value> &x) const {
     if (x.size() != this->w.size()) {
         throw std::runtime_error(
             "Neuron::operator(): mismatched size, w is of size " + std::to_string(this->w.size()) +
             " and x is of size " + std::to_string(x.size()));
     }
-    Value activation = this->b;
-    for (int idx = 0; idx < this->w.size(); ++idx) {
-        activation = activation + (x[idx] * this->w[idx]);
+    Value activation = dot(x, this->w) + this->b;
+    if (this->nonlinear) {
+        activation = activation.relu();
+    }
+
+    return activation;
+}
+
+TapeValue Neuron::operator()(Tape &tape, const std::vector<TapeValue> &x) const {
+    if (x.size() != this->w.size()) {
+        throw std::runtime_error(
+            "Neuron::operator(): mismatched size, w is of size " + std::to_string(this->w.size()) +
+            " and x is of size " + std::to_string(x.size()));
+    }
+    TapeValue activation = tape.parameter(this->b);
+    for (std::size_t idx = 0; idx < this->w.size(); ++idx) {
+        activation = activation + (x[idx] * tape.parameter(this->w[idx]));
+    }
+    if (this->nonlinear) {
+        activation = activation.relu();
+    }
+
+    return activation;
+}
+
+Dual Neuron::operator()(const std::vector<Dual> &x) const {
+    if (x.size() != this->w.size()) {
+        throw std::runtime_error(
+            "Neuron::operator(): mismatched size, w is of size " + std::to_string(this->w.size()) +
+            " and x is of size " + std::to_string(x.size()));
+    }
+    // The weights come first in the buffer, followed by the bias
+    const double *weights = this->parameter_data();
+    Dual activation{weights[this->w.size()]};
+    for (std::size_t idx = 0; idx < x.size(); ++idx) {
+        activation = activation + x[idx] * weights[idx];
     }
     if (this->nonlinear) {
         activation = activation.relu();
@@ -34,44 +326,523 @@ Value Neuron::operator()(const std::vector<Value> &x) const {
     return activation;
 }
 
-std::vector<Value> Neuron::get_parameters() {
-    std::vector<Value> out = this->w;
-    out.push_back(this->b);
+template<typename T>
+BasicLayer<T>::BasicLayer(const std::shared_ptr<BasicParameterBuffer<T> > &buffer, const std::size_t offset,
+                          const std::size_t nin, const std::size_t nout, const bool nonlinear)
+    : weights(BasicTensor<T>::view({nout, nin}, buffer->data.get() + offset, buffer->grad.data() + offset, buffer)),
+      biases(BasicTensor<T>::view({nout}, buffer->data.get() + offset + nout * nin,
+                                  buffer->grad.data() + offset + nout * nin, buffer)),
+      nonlinear(nonlinear) {
+    this->bind_parameters(buffer, offset, parameterCountOf(nin, nout));
+    // Values hold doubles, so a Layer of floats has no Values viewing its parameters
+    if constexpr (std::same_as<T, double>) {
+        this->params.reserve(this->parameterCount);
+        for (std::size_t row = 0; row < nout; ++row) {
+            for (std::size_t col = 0; col < nin; ++col) {
+                this->params.push_back(this->weights.element(row * nin + col));
+            }
+            this->params.push_back(this->biases.element(row));
+        }
+    }
+}
+
+template<typename T>
+BasicLayer<T>::BasicLayer(const int nin, const int nout, const bool nonlinear, const Initialization initialization,
+                          const std::optional<std::uint64_t> seed)
+    : BasicLayer(std::make_shared<BasicParameterBuffer<T> >(parameterCountOf(nin, nout)), 0,
+                 static_cast<std::size_t>(nin), static_cast<std::size_t>(nout), nonlinear) {
+    initializeWeights(std::span{this, 1}, initialization, seed.value_or(Philox::random_seed()));
+}
+
+template<typename T>
+void BasicLayer<T>::initializeWeights(const std::span<const BasicLayer> layers, const Initialization initialization,
+                                      const std::uint64_t seed) {
+    // Split every Layer into chunks, so wide Layers are spread over several threads too
+    struct Chunk {
+        std::size_t layer;
+        std::size_t first;
+    };
+    std::vector<Chunk> chunks;
+    for (std::size_t layer = 0; layer < layers.size(); ++layer) {
+        for (std::size_t first = 0; first < layers[layer].weights.size(); first += initializationChunk) {
+            chunks.push_back({layer, first});
+        }
+    }
+    const auto initializeChunk = [&](const std::size_t idx) {
+        const BasicLayer &layer = layers[chunks[idx].layer];
+        const std::span<T> weights = layer.weights.get_data();
+        const double bound = weightBound(initialization, layer.weights.get_shape()[1], layer.weights.get_shape()[0]);
+        const std::size_t count = std::min(initializationChunk, weights.size() - chunks[idx].first);
+        if constexpr (std::same_as<T, double>) {
+            Philox::uniform(weights.data() + chunks[idx].first, count, chunks[idx].first, -bound, bound, seed,
+                            chunks[idx].layer);
+        } else {
+            // The generator gives doubles, rounded so a float model matches a double one of the same seed
+            std::vector<double> drawn(count);
+            Philox::uniform(drawn.data(), count, chunks[idx].first, -bound, bound, seed, chunks[idx].layer);
+            std::ranges::transform(drawn, weights.begin() + static_cast<std::ptrdiff_t>(chunks[idx].first),
+                                   [](const double x) { return static_cast<T>(x); });
+        }
+    };
+    if (chunks.size() > 1) {
+        ThreadPool::global().parallel_for(chunks.size(), initializeChunk);
+    } else if (chunks.size() == 1) {
+        initializeChunk(0);
+    }
+}
+
+template<typename T>
+BasicLayer<T> BasicLayer<T>::replicate() const {
+    return BasicLayer{
+        this->parameterBuffer->replicate(), this->parameterOffset, this->weights.get_shape()[1],
+        this->weights.get_shape()[0], this->nonlinear
+    };
+}
+
+template<typename T>
+std::vector<Value> BasicLayer<T>::operator()(const std::vector<Value> &x) const requires std::same_as<T, double> {
+    const std::size_t nin = this->weights.get_shape()[1];
+    if (x.size() != nin) {
+        throw std::runtime_error(
+            "Layer::operator(): mismatched size, expected " + std::to_string(nin) +
+            " inputs and x is of size " + std::to_string(x.size()));
+    }
+    const std::span<const Value> allParams{this->params};
+    std::vector<Value> out;
+    out.reserve(this->biases.size());
+    for (std::size_t row = 0; row < this->biases.size(); ++row) {
+        const std::size_t offset = row * (nin + 1);
+        Value activation = dot(x, allParams.subspan(offset, nin)) + this->params[offset + nin];
+        if (this->nonlinear) {
+            activation = activation.relu();
+        }
+        out.push_back(activation);
+    }
     return out;
 }
 
-auto Layer::get_parameters() -> std::vector<Value> {
-    std::deque<Value> outDeque;
-    for (auto& n: this->neurons) {
-        auto neuronParams = n.get_parameters();
-        outDeque.insert(outDeque.end(), neuronParams.begin(), neuronParams.end());
+template<typename T>
+std::vector<Dual> BasicLayer<T>::operator()(const std::vector<Dual> &x) const requires std::same_as<T, double> {
+    const std::size_t nin = this->weights.get_shape()[1];
+    if (x.size() != nin) {
+        throw std::runtime_error(
+            "Layer::operator(): mismatched size, expected " + std::to_string(nin) +
+            " inputs and x is of size " + std::to_string(x.size()));
+    }
+    // The weights are constants, so the data and the tangents each go through the weights on their own
+    std::vector<double> data(nin);
+    std::vector<double> tangents(nin);
+    for (std::size_t col = 0; col < nin; ++col) {
+        data[col] = x[col].get_data();
+        tangents[col] = x[col].get_tangent();
+    }
+    const double *weightData = this->weights.get_data().data();
+    const double *biasData = this->biases.get_data().data();
+    std::vector<Dual> out;
+    out.reserve(this->biases.size());
+    for (std::size_t row = 0; row < this->biases.size(); ++row) {
+        const double *rowWeights = weightData + row * nin;
+        Dual activation{
+            kernels::dot(rowWeights, data.data(), nin) + biasData[row], kernels::dot(rowWeights, tangents.data(), nin)
+        };
+        if (this->nonlinear) {
+            activation = activation.relu();
+        }
+        out.push_back(activation);
     }
-    std::vector<Value> out{outDeque.begin(), outDeque.end()};
     return out;
 }
 
-std::vector<Value> Layer::operator()(const std::vector<Value> &x) const {
-    std::vector<Value> out;
-    for (const auto &neuron: neurons) {
-        out.push_back(neuron(x));
+template<typename T>
+std::vector<TapeValue> BasicLayer<T>::operator()(Tape &tape, const std::vector<TapeValue> &x) const
+    requires std::same_as<T, double> {
+    const std::size_t nin = this->weights.get_shape()[1];
+    if (x.size() != nin) {
+        throw std::runtime_error(
+            "Layer::operator(): mismatched size, expected " + std::to_string(nin) +
+            " inputs and x is of size " + std::to_string(x.size()));
+    }
+    std::vector<TapeValue> out;
+    out.reserve(this->biases.size());
+    for (std::size_t row = 0; row < this->biases.size(); ++row) {
+        const std::size_t offset = row * (nin + 1);
+        TapeValue activation = tape.parameter(this->params[offset + nin]);
+        for (std::size_t idx = 0; idx < nin; ++idx) {
+            activation = activation + (x[idx] * tape.parameter(this->params[offset + idx]));
+        }
+        if (this->nonlinear) {
+            activation = activation.relu();
+        }
+        out.push_back(activation);
     }
     return out;
 }
 
-std::vector<Value> MultiLayerPerceptron::operator()(std::vector<Value> x) const {
+template<typename T>
+BasicTensor<T> BasicLayer<T>::operator()(const BasicTensor<T> &x) const {
+    // A batch holds one sample per row, so it is multiplied by the transposed weights
+    BasicTensor<T> activation = x.get_shape().size() == 2
+                                    ? x.matmul_transposed(this->weights) + this->biases
+                                    : this->weights.matmul(x) + this->biases;
+    if (this->nonlinear) {
+        activation = activation.relu();
+    }
+    return activation;
+}
+
+template<typename T>
+std::vector<Value> BasicMultiLayerPerceptron<T>::operator()(std::vector<Value> x) const
+    requires std::same_as<T, double> {
+    const Profiler::Span profile{"MultiLayerPerceptron", "nn"};
+    std::vector<Value> out = std::move(x);
+    for (auto& l : this->layers) {
+        out = l(out);
+    }
+    return out;
+}
+
+template<typename T>
+std::vector<Value> BasicMultiLayerPerceptron<T>::checkpointed(std::vector<Value> x, const std::size_t segmentLength) const
+    requires std::same_as<T, double> {
+    if (segmentLength == 0) {
+        throw std::runtime_error("MultiLayerPerceptron::checkpointed: segmentLength must be at least 1");
+    }
+    const Profiler::Span profile{"MultiLayerPerceptron::checkpointed", "nn"};
     std::vector<Value> out = std::move(x);
+    for (std::size_t first = 0; first < this->layers.size(); first += segmentLength) {
+        const std::size_t last = std::min(first + segmentLength, this->layers.size());
+        // The segment keeps copies of its Layers (sharing their parameters), since it is
+        // called again during the backward pass, which may outlive this MultiLayerPerceptron
+        std::vector<Layer> segmentLayers(this->layers.begin() + static_cast<std::ptrdiff_t>(first),
+                                         this->layers.begin() + static_cast<std::ptrdiff_t>(last));
+        out = checkpoint([segmentLayers = std::move(segmentLayers)](const std::vector<Value> &input) {
+            std::vector<Value> activation = input;
+            for (const auto &l: segmentLayers) {
+                activation = l(activation);
+            }
+            return activation;
+        }, out);
+    }
+    return out;
+}
+
+template<typename T>
+std::vector<Dual> BasicMultiLayerPerceptron<T>::operator()(std::vector<Dual> x) const
+    requires std::same_as<T, double> {
+    const Profiler::Span profile{"MultiLayerPerceptron", "nn"};
+    std::vector<Dual> out = std::move(x);
     for (auto& l : this->layers) {
         out = l(out);
     }
     return out;
 }
 
-std::vector<Value> MultiLayerPerceptron::get_parameters() {
-    std::deque<Value> outDeque;
-    for (auto& l: this->layers) {
-        auto layerParams = l.get_parameters();
-        outDeque.insert(outDeque.end(), layerParams.begin(), layerParams.end());
+template<typename T>
+std::vector<TapeValue> BasicMultiLayerPerceptron<T>::operator()(Tape &tape, std::vector<TapeValue> x) const
+    requires std::same_as<T, double> {
+    std::vector<TapeValue> out = std::move(x);
+    for (auto& l : this->layers) {
+        out = l(tape, out);
+    }
+    return out;
+}
+
+template<typename T>
+BasicTensor<T> BasicMultiLayerPerceptron<T>::operator()(const BasicTensor<T> &x) const {
+    const Profiler::Span profile{"MultiLayerPerceptron", "nn"};
+    BasicTensor<T> out = x;
+    for (auto& l : this->layers) {
+        out = l(out);
     }
-    std::vector<Value> out{outDeque.begin(), outDeque.end()};
     return out;
 }
+
+template<typename T>
+std::vector<int> BasicMultiLayerPerceptron<T>::layerSizes() const {
+    std::vector<int> nouts;
+    nouts.reserve(this->layers.size());
+    for (const auto &l: this->layers) {
+        nouts.push_back(static_cast<int>(l.get_biases().size()));
+    }
+    return nouts;
+}
+
+template<typename T>
+BasicMultiLayerPerceptron<T> BasicMultiLayerPerceptron<T>::replicate() const {
+    return BasicMultiLayerPerceptron{this->nin, this->layerSizes(), this->parameterBuffer->replicate()};
+}
+
+template<typename T>
+template<typename U>
+BasicMultiLayerPerceptron<U> BasicMultiLayerPerceptron<T>::cast() const {
+    auto buffer = std::make_shared<BasicParameterBuffer<U> >(this->parameterCount);
+    std::ranges::transform(this->get_parameter_data(), buffer->data.get(), [](const T x) { return static_cast<U>(x); });
+    return BasicMultiLayerPerceptron<U>{this->nin, this->layerSizes(), std::move(buffer)};
+}
+
+template<typename T>
+std::vector<BasicTensor<T> > BasicMultiLayerPerceptron<T>::get_parameter_tensors() const {
+    std::vector<BasicTensor<T> > out;
+    out.reserve(2 * this->layers.size());
+    for (const auto &l: this->layers) {
+        out.push_back(l.get_weights());
+        out.push_back(l.get_biases());
+    }
+    return out;
+}
+
+template<typename T>
+BasicMultiLayerPerceptron<T>::BasicMultiLayerPerceptron(const int nin, const std::vector<int> &nouts,
+                                                        std::shared_ptr<BasicParameterBuffer<T> > buffer) : nin(nin) {
+    this->bind_parameters(std::move(buffer), 0, parameterCountOf(nin, nouts));
+    std::size_t offset = 0;
+    int layerNin = nin;
+    for (std::size_t idx = 0; idx < nouts.size(); ++idx) {
+        this->layers.push_back(BasicLayer<T>{this->parameterBuffer, offset, static_cast<std::size_t>(layerNin),
+                                             static_cast<std::size_t>(nouts[idx]), idx != nouts.size() - 1});
+        offset += BasicLayer<T>::parameterCountOf(layerNin, nouts[idx]);
+        layerNin = nouts[idx];
+    }
+    if constexpr (std::same_as<T, double>) {
+        this->params.reserve(this->parameterCount);
+        for (const auto &l: this->layers) {
+            const auto &layerParams = l.get_parameters();
+            this->params.insert(this->params.end(), layerParams.begin(), layerParams.end());
+        }
+    }
+}
+
+template<typename T>
+BasicMultiLayerPerceptron<T>::BasicMultiLayerPerceptron(const int nin, const std::vector<int> &nouts,
+                                                        const Initialization initialization,
+                                                        const std::optional<std::uint64_t> seed)
+    : BasicMultiLayerPerceptron(nin, nouts,
+                                std::make_shared<BasicParameterBuffer<T> >(parameterCountOf(nin, nouts))) {
+    BasicLayer<T>::initializeWeights(this->layers, initialization, seed.value_or(Philox::random_seed()));
+}
+
+template<typename T>
+std::size_t BasicMultiLayerPerceptron<T>::parameterCountOf(const int nin, const std::vector<int> &nouts) {
+    std::size_t count = 0;
+    int layerNin = nin;
+    for (const int nout: nouts) {
+        count += BasicLayer<T>::parameterCountOf(layerNin, nout);
+        layerNin = nout;
+    }
+    return count;
+}
+
+template<typename T>
+void BasicMultiLayerPerceptron<T>::save(const std::string &path) const requires std::same_as<T, double> {
+    this->save(path, std::span<const double>{}, false);
+}
+
+template<typename T>
+void BasicMultiLayerPerceptron<T>::save(const std::string &path, const BasicOptimizer<T> &optimizer) const
+    requires std::same_as<T, double> {
+    const std::vector<double> state = optimizer.get_state();
+    this->save(path, state, true);
+}
+
+template<typename T>
+void BasicMultiLayerPerceptron<T>::save(const std::string &path, const std::span<const double> state,
+                                        const bool hasState) const requires std::same_as<T, double> {
+    std::string header;
+    header.append(modelMagic, sizeof(modelMagic));
+    appendLittleEndian(header, modelVersion);
+    appendLittleEndian(header, hasState ? hasOptimizerState : std::uint32_t{0});
+    appendLittleEndian(header, static_cast<std::uint64_t>(this->nin));
+    appendLittleEndian(header, static_cast<std::uint64_t>(this->layers.size()));
+    appendLittleEndian(header, static_cast<std::uint64_t>(this->parameterCount));
+    appendLittleEndian(header, static_cast<std::uint64_t>(state.size()));
+    for (std::size_t idx = 0; idx < this->layers.size(); ++idx) {
+        appendLittleEndian(header, static_cast<std::uint64_t>(this->layers[idx].get_biases().size()));
+        appendLittleEndian(header, static_cast<std::uint64_t>(this->layers[idx].nonlinear));
+    }
+    header.resize(paddedHeaderSize(this->layers.size()), '\0');
+
+    // Written next to the destination and moved over it, so that a model loaded
+    // from the destination (which maps the old file) can be saved back to it
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file{temporaryPath, std::ios::binary | std::ios::trunc};
+        if (!file) {
+            throw std::runtime_error("MultiLayerPerceptron::save: unable to open " + temporaryPath);
+        }
+        file.write(header.data(), static_cast<std::streamsize>(header.size()));
+        writeDoubles(file, this->get_parameter_data());
+        writeDoubles(file, state);
+        if (!file.flush()) {
+            throw std::runtime_error("MultiLayerPerceptron::save: unable to write " + temporaryPath);
+        }
+    }
+    std::filesystem::rename(temporaryPath, path);
+}
+
+template<typename T>
+BasicMultiLayerPerceptron<T> BasicMultiLayerPerceptron<T>::load(const std::string &path)
+    requires std::same_as<T, double> {
+    const std::shared_ptr<MappedFile> file = MappedFile::open(path);
+    const ModelHeader header = readModelHeader(file->bytes(), path);
+    std::shared_ptr<double[]> data;
+    if constexpr (littleEndian) {
+        // View the parameters in place, the buffer keeps the file mapped
+        data = std::shared_ptr<double[]>(
+            file, reinterpret_cast<double *>(file->bytes().data() + header.dataOffset));
+    } else {
+        const std::vector<double> values = readDoubles(file->bytes(), header.dataOffset, header.parameterCount);
+        data = std::make_shared<double[]>(values.size());
+        std::copy(values.begin(), values.end(), data.get());
+    }
+    return MultiLayerPerceptron{
+        header.nin, header.nouts, std::make_shared<ParameterBuffer>(std::move(data), header.parameterCount)
+    };
+}
+
+template<typename T>
+void BasicMultiLayerPerceptron<T>::load_optimizer_state(const std::string &path, BasicOptimizer<T> &optimizer)
+    requires std::same_as<T, double> {
+    const std::shared_ptr<MappedFile> file = MappedFile::open(path);
+    const ModelHeader header = readModelHeader(file->bytes(), path);
+    if (!header.hasState) {
+        throw std::runtime_error("MultiLayerPerceptron::load_optimizer_state: no optimizer state in " + path);
+    }
+    optimizer.set_state(readDoubles(file->bytes(), header.dataOffset + header.parameterCount * sizeof(double),
+                                    header.stateCount));
+}
+
+template<typename T>
+CompiledMultiLayerPerceptron BasicMultiLayerPerceptron<T>::compile() const requires std::same_as<T, double> {
+    return CompiledMultiLayerPerceptron{*this};
+}
+
+CompiledMultiLayerPerceptron::CompiledMultiLayerPerceptron(const MultiLayerPerceptron &mlp)
+    : tape(std::make_unique<Tape>()) {
+    for (int idx = 0; idx < mlp.get_nin(); ++idx) {
+        this->inputs.push_back(this->tape->value(0.));
+    }
+    this->outputs = mlp(*this->tape, this->inputs);
+    // Every neuron becomes a single Dot node (plus its ReLU)
+    this->tape->optimize(this->inputs, this->outputs);
+}
+
+std::vector<double> CompiledMultiLayerPerceptron::operator()(const std::vector<double> &x) {
+    const Profiler::Span profile{"CompiledMultiLayerPerceptron", "nn"};
+    if (x.size() != this->inputs.size()) {
+        throw std::runtime_error(
+            "CompiledMultiLayerPerceptron::operator(): mismatched size, expected " +
+            std::to_string(this->inputs.size()) + " inputs and x is of size " + std::to_string(x.size()));
+    }
+    for (std::size_t idx = 0; idx < x.size(); ++idx) {
+        this->inputs[idx].set_data(x[idx]);
+    }
+    this->tape->forward();
+
+    std::vector<double> out;
+    out.reserve(this->outputs.size());
+    for (const auto &output: this->outputs) {
+        out.push_back(output.get_data());
+    }
+    return out;
+}
+
+void CompiledMultiLayerPerceptron::backwards(const std::vector<double> &outputGrads) {
+    const Profiler::Span profile{"CompiledMultiLayerPerceptron::backwards", "nn"};
+    if (outputGrads.size() != this->outputs.size()) {
+        throw std::runtime_error(
+            "CompiledMultiLayerPerceptron::backwards: mismatched size, expected " +
+            std::to_string(this->outputs.size()) + " output gradients and got " +
+            std::to_string(outputGrads.size()));
+    }
+    this->tape->backwards(this->outputs, outputGrads);
+}
+
+DataParallelTrainer::DataParallelTrainer(const MultiLayerPerceptron &mlp, const std::size_t numWorkers,
+                                         Optimizer &optimizer, ThreadPool &pool)
+    : model(trainableModel(mlp)), optimizer(&optimizer), pool(pool) {
+    for (std::size_t idx = 0; idx < std::max<std::size_t>(numWorkers, 1); ++idx) {
+        this->replicas.push_back(this->model.replicate());
+    }
+}
+
+DataParallelTrainer::DataParallelTrainer(const MultiLayerPerceptron &mlp, const std::size_t numWorkers,
+                                         const double learningRate, ThreadPool &pool)
+    : model(trainableModel(mlp)), ownedOptimizer(std::make_unique<SGD>(std::vector{mlp.get_flat_parameters()}, learningRate)),
+      optimizer(ownedOptimizer.get()), pool(pool) {
+    for (std::size_t idx = 0; idx < std::max<std::size_t>(numWorkers, 1); ++idx) {
+        this->replicas.push_back(this->model.replicate());
+    }
+}
+
+double DataParallelTrainer::step(const Tensor &inputs, const Tensor &targets) {
+    const Profiler::Span profile{"DataParallelTrainer::step", "nn"};
+    const auto &inputShape = inputs.get_shape();
+    const auto &targetShape = targets.get_shape();
+    if (inputShape.size() != 2 || inputShape[0] == 0 || static_cast<int>(inputShape[1]) != this->model.get_nin()) {
+        throw std::runtime_error("DataParallelTrainer::step: inputs should be of shape (batch, " +
+                                 std::to_string(this->model.get_nin()) + ")");
+    }
+    const std::size_t batch = inputShape[0];
+    const std::size_t nin = inputShape[1];
+    const std::size_t nout = this->model.get_layers().back().get_biases().size();
+    if (targetShape.size() != 2 || targetShape[0] != batch || targetShape[1] != nout) {
+        throw std::runtime_error("DataParallelTrainer::step: targets should be of shape (" +
+                                 std::to_string(batch) + ", " + std::to_string(nout) + ")");
+    }
+
+    // Every shard runs its forward and backward pass with its own replica
+    const std::size_t numShards = std::min(this->replicas.size(), batch);
+    const double scale = 1.0 / static_cast<double>(batch);
+    std::vector<double> shardLosses(numShards, 0.);
+    this->pool.parallel_for(numShards, [&](const std::size_t shard) {
+        const Profiler::Span shardProfile{"shard", "nn"};
+        const std::size_t begin = batch * shard / numShards;
+        const std::size_t end = batch * (shard + 1) / numShards;
+        MultiLayerPerceptron &replica = this->replicas[shard];
+        replica.zero_grad();
+        // The shard views its rows of the batch, which outlives the step
+        const Tensor shardInputs = Tensor::view({end - begin, nin}, inputs.get_data().data() + begin * nin, {});
+        const Tensor outputs = replica(shardInputs);
+        const std::span<const double> expected = targets.get_data().subspan(begin * nout, (end - begin) * nout);
+        std::vector<double> outputGrads(outputs.size());
+        double loss = 0.;
+        for (std::size_t idx = 0; idx < outputGrads.size(); ++idx) {
+            const double error = outputs.get_data()[idx] - expected[idx];
+            loss += error * error;
+            outputGrads[idx] = 2.0 * error * scale;
+        }
+        shardLosses[shard] = loss * scale;
+        outputs.backwards(outputGrads);
+    });
+
+    // Sum the gradients of the replicas pairwise, so replica 0 ends up with the total
+    for (std::size_t stride = 1; stride < numShards; stride *= 2) {
+        const std::size_t numPairs = (numShards - stride + 2 * stride - 1) / (2 * stride);
+        this->pool.parallel_for(numPairs, [&](const std::size_t pair) {
+            const std::size_t target = pair * 2 * stride;
+            const std::span<double> to = this->replicas[target].get_parameter_grads();
+            const std::span<double> from = this->replicas[target + stride].get_parameter_grads();
+            kernels::axpy(1.0, from.data(), to.data(), to.size());
+        });
+    }
+
+    // Move the total into the model, then update it
+    std::ranges::copy(this->replicas[0].get_parameter_grads(), this->model.get_parameter_grads().begin());
+    this->optimizer->step();
+
+    double loss = 0.;
+    for (const double shardLoss: shardLosses) {
+        loss += shardLoss;
+    }
+    return loss;
+}
+
+template class BasicModule<float>;
+template class BasicModule<double>;
+template class BasicLayer<float>;
+template class BasicLayer<double>;
+template class BasicMultiLayerPerceptron<float>;
+template class BasicMultiLayerPerceptron<double>;
+
+template BasicMultiLayerPerceptron<double> BasicMultiLayerPerceptron<float>::cast<double>() const;
+template BasicMultiLayerPerceptron<float> BasicMultiLayerPerceptron<double>::cast<float>() const;
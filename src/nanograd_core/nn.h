@@ -1,48 +1,214 @@
 #pragma once
 
 // Standard Library Imports
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <utility>
 #include <vector>
-#include <deque>
-#include <random>
+#include <memory>
+#include <span>
+#include <string>
 
 // External Imports
 
 // Local Imports
+#include "dual.h"
 #include "engine.h"
+#include "optim.h"
+#include "tape.h"
+#include "tensor.h"
+
+/**
+ * @brief Flat buffers holding the data and the gradients of the parameters of a Module
+ *
+ * Every parameter of a Module views one element of these buffers, so
+ * operations over a whole model (zeroing the gradients, optimizer steps,
+ * summing the gradients of several replicas, saving the parameters) run over
+ * two contiguous arrays. Replicas of a Module share the data buffer, but each
+ * have a gradient buffer of their own. The data can also live in a file mapped
+ * into memory (see MultiLayerPerceptron::load).
+ *
+ * @tparam T Scalar type of the parameters, float or double.
+ */
+template<typename T>
+struct BasicParameterBuffer {
+    /**
+     * @brief Data of the parameters, shared with any replicas
+     */
+    std::shared_ptr<T[]> data;
+    /**
+     * @brief Gradients of the parameters
+     */
+    std::vector<T> grad;
+
+    /**
+     * @brief Create buffers for a number of parameters, all 0
+     * @param size Number of parameters
+     */
+    explicit BasicParameterBuffer(const std::size_t size)
+        : data(std::make_shared<T[]>(size)), grad(size, T{0}) {
+    }
+
+    /**
+     * @brief Create buffers over existing data, with gradients of their own, all 0
+     * @param data Data of the parameters, which can be owned by anything (such as a mapped file)
+     * @param size Number of parameters
+     */
+    BasicParameterBuffer(std::shared_ptr<T[]> data, const std::size_t size)
+        : data(std::move(data)), grad(size, T{0}) {
+    }
+
+    /**
+     * @brief Create buffers sharing the data of these ones, with gradients of their own
+     * @return Buffers of the replica
+     */
+    [[nodiscard]] std::shared_ptr<BasicParameterBuffer> replicate() const {
+        return std::make_shared<BasicParameterBuffer>(this->data, this->grad.size());
+    }
+};
+
+using ParameterBuffer = BasicParameterBuffer<double>;
 
 /**
  * @brief Base class for all neural network associated objects
+ *
+ * The parameters of a Module live in a slice of a ParameterBuffer (Modules
+ * nested in another one use a slice of the buffer of their parent), and the
+ * Values returned by get_parameters view that slice. Values hold doubles, so
+ * Modules of floats only expose their parameters as buffers and Tensors.
+ *
+ * @tparam T Scalar type of the parameters, float or double.
  */
-class Module {
+template<typename T>
+class BasicModule {
+protected:
+    /**
+     * @brief Buffers holding the parameters (empty for a Module without any)
+     */
+    std::shared_ptr<BasicParameterBuffer<T> > parameterBuffer;
+    /**
+     * @brief Position of the first parameter of the Module in the buffers
+     */
+    std::size_t parameterOffset = 0;
+    /**
+     * @brief Number of parameters of the Module
+     */
+    std::size_t parameterCount = 0;
+    /**
+     * @brief Values viewing the parameters, in the order returned by get_parameters
+     *     (empty for a Module of floats)
+     */
     std::vector<Value> params;
 
-public:
-    explicit Module(const std::vector<Value> &params) : params(params) {
+    /**
+     * @brief Place the parameters of the Module in a slice of a buffer
+     * @param buffer Buffers holding the parameters
+     * @param offset Position of the first parameter in the buffers
+     * @param count Number of parameters
+     */
+    void bind_parameters(std::shared_ptr<BasicParameterBuffer<T> > buffer, std::size_t offset, std::size_t count);
+
+    /**
+     * @brief Get the location of the data of the first parameter
+     * @return Pointer to parameterCount elements of data
+     */
+    [[nodiscard]] T *parameter_data() const {
+        return this->parameterBuffer->data.get() + this->parameterOffset;
     }
 
-    Module() = default;
+    /**
+     * @brief Get the location of the gradient of the first parameter
+     * @return Pointer to parameterCount elements of gradient
+     */
+    [[nodiscard]] T *parameter_grad() const {
+        return this->parameterBuffer->grad.data() + this->parameterOffset;
+    }
 
-    virtual ~Module() = default;
+public:
+    /**
+     * @brief Create a Module holding a set of parameters
+     *
+     * The data and gradient of the Values are moved into a new ParameterBuffer
+     * (see Value::rebind), so they keep working as before while being stored
+     * contiguously. Each Value should only appear once, and can't already be
+     * a view (e.g. a parameter of another Module or an element of a Tensor).
+     *
+     * @param params Parameters of the Module
+     * @throws std::runtime_error If one of the Values is already a view.
+     */
+    explicit BasicModule(const std::vector<Value> &params) requires std::same_as<T, double>;
+
+    BasicModule() = default;
+
+    virtual ~BasicModule() = default;
 
     /**
      * @brief Zero the gradients of parameters associated with the module.
      */
-    virtual void zero_grad() {
-        for (const auto &param: params) {
-            param.zero_grad();
-        }
-    }
+    void zero_grad() const;
 
     /**
      * @brief Get the parameters associated with the module
-     * @return The parameters associated with the module
+     * @return Values viewing the parameters associated with the module
      */
-    [[nodiscard]] virtual std::vector<Value> get_parameters() {
+    [[nodiscard]] const std::vector<Value> &get_parameters() const requires std::same_as<T, double> {
         return this->params;
     }
+
+    /**
+     * @brief Get the data of all the parameters as one contiguous block
+     * @return View of the data of the parameters, in the order of the buffer
+     */
+    [[nodiscard]] std::span<T> get_parameter_data() const;
+
+    /**
+     * @brief Get the gradients of all the parameters as one contiguous block
+     * @return View of the gradients of the parameters, in the order of the buffer
+     */
+    [[nodiscard]] std::span<T> get_parameter_grads() const;
+
+    /**
+     * @brief Get a 1-D Tensor viewing the data and gradients of all the parameters
+     *
+     * Passing it to an Optimizer updates every parameter of the Module in a
+     * single pass.
+     *
+     * @return Tensor of shape {number of parameters}
+     */
+    [[nodiscard]] BasicTensor<T> get_flat_parameters() const;
 };
 
+using Module = BasicModule<double>;
+
+// Defined and instantiated in nn.cpp
+extern template class BasicModule<float>;
+extern template class BasicModule<double>;
+
+
+/**
+ * @brief Distribution the initial weights of a Neuron or Layer are drawn from
+ *
+ * Every scheme draws the weights uniformly from a range symmetric around 0,
+ * and starts the biases at 0.
+ */
+enum class Initialization {
+    /**
+     * @brief Uniform in [-1, 1]
+     */
+    Uniform,
+    /**
+     * @brief Xavier/Glorot initialization, uniform in +-sqrt(6 / (nin + nout)),
+     *     which keeps the variance of the activations through linear layers
+     */
+    Xavier,
+    /**
+     * @brief He/Kaiming initialization, uniform in +-sqrt(6 / nin), which keeps
+     *     the variance of the activations through ReLU layers
+     */
+    He
+};
 
 /**
  * @brief Neuron represents a single neuron in a neural network
@@ -66,8 +232,11 @@ public:
      * @brief Construct a neuron with nin inputs
      * @param nin Number of inputs to the neuron
      * @param nonlinear Whether the neuron should use a non-linear activation function (ReLU)
+     * @param initialization Distribution of the initial weights
+     * @param seed Seed of the initial weights (see Philox), drawn from the system if not given
      */
-    explicit Neuron(const int nin, const bool nonlinear);;
+    explicit Neuron(int nin, bool nonlinear, Initialization initialization = Initialization::Uniform,
+                    std::optional<std::uint64_t> seed = std::nullopt);
 
     /**
      * @brief Determine the activation of the neuron given an input
@@ -77,102 +246,581 @@ public:
     Value operator()(const std::vector<Value> &x) const;;
 
     /**
-     * @brief Get the parameters of the neurone (weights and bias)
-     * @return Vector of parameters of the neuron
+     * @brief Record the activation of the neuron on a Tape
+     * @param tape Tape to record the computation on
+     * @param x Vector of values coming in to the neuron (must be the same length as w)
+     * @return Neuron activation
      */
-    std::vector<Value> get_parameters() override;
+    TapeValue operator()(Tape &tape, const std::vector<TapeValue> &x) const;
 
     /**
-     * @brief Zero the gradients of the parameters of the neuron
+     * @brief Determine the activation of the neuron and its derivative along the tangents of x
+     * @param x Vector of dual numbers coming in to the neuron (must be the same length as w)
+     * @return Neuron activation, whose tangent is the derivative along the tangents of x
      */
-    void zero_grad() override {
-        for (auto &param: this->w) {
-            param.zero_grad();
-        }
-        this->b.zero_grad();
-    };
+    Dual operator()(const std::vector<Dual> &x) const;
+
 };
 
 /**
  * @brief Represents a single layer of neurons in a neural network
+ *
+ * The weights of all the neurons are stored as a single row-major
+ * (nout by nin) matrix, and the biases as a single vector, so that the
+ * whole Layer can be run as one matrix-vector product. The individual
+ * parameters of a Layer of doubles are still available as Values viewing the
+ * elements of those tensors, ordered neuron by neuron (the weights of a
+ * neuron followed by its bias).
+ *
+ * A Layer of floats (FloatLayer) stores its parameters and their gradients as
+ * floats, so running it reads half the memory and uses the float kernels.
+ *
+ * @tparam T Scalar type of the parameters, float or double.
  */
-class Layer final : public Module {
-    std::vector<Neuron> neurons;
+template<typename T>
+class BasicLayer final : public BasicModule<T> {
+    /**
+     * @brief Weights of the Layer, row i holds the weights of neuron i
+     */
+    BasicTensor<T> weights;
+    /**
+     * @brief Biases of the Layer, one per neuron
+     */
+    BasicTensor<T> biases;
+    /**
+     * @brief Whether the output should be non-linear (via ReLU)
+     */
+    bool nonlinear;
+
+    template<typename>
+    friend class BasicMultiLayerPerceptron;
 
-public:
     /**
-     * @brief Create a layer of randomly initialized neurons
+     * @brief Create a layer over a slice of a parameter buffer, without initializing it
+     *
+     * The weights take up the first nout * nin parameters of the slice, in
+     * row-major order, followed by the biases.
+     *
+     * @param buffer Buffers holding the parameters
+     * @param offset Position of the first parameter of the layer in the buffers
      * @param nin Number of inputs to the layer
      * @param nout Number of outputs from the layer
      * @param nonlinear Whether the neurons should include a non-linear layer
      */
-    Layer(const int nin, const int nout, const bool nonlinear) {
-        for (int i = 0; i < nout; ++i) {
-            neurons.emplace_back(nin, nonlinear);
-        }
+    BasicLayer(const std::shared_ptr<BasicParameterBuffer<T> > &buffer, std::size_t offset, std::size_t nin,
+               std::size_t nout, bool nonlinear);
+
+    /**
+     * @brief Set the weights of several Layers to random values
+     *
+     * The weights of Layer i are drawn from stream i of a Philox generator, so
+     * each weight only depends on the seed, its Layer and its position. The
+     * weights are filled in chunks spread over the global ThreadPool, and are
+     * the same whatever the number of threads (and, rounded, whatever the
+     * scalar type).
+     *
+     * @param layers Layers to initialize
+     * @param initialization Distribution of the weights
+     * @param seed Seed of the generator
+     */
+    static void initializeWeights(std::span<const BasicLayer> layers, Initialization initialization,
+                                  std::uint64_t seed);
+
+    /**
+     * @brief Get the number of parameters of a Layer
+     * @param nin Number of inputs to the layer
+     * @param nout Number of outputs from the layer
+     * @return Number of weights and biases
+     */
+    static std::size_t parameterCountOf(const std::size_t nin, const std::size_t nout) {
+        return nout * (nin + 1);
     }
 
+public:
     /**
-     * @brief Find all the parameters of the Layer
-     * @return Parameters of the Layer
+     * @brief Create a layer of randomly initialized neurons
+     * @param nin Number of inputs to the layer
+     * @param nout Number of outputs from the layer
+     * @param nonlinear Whether the neurons should include a non-linear layer
+     * @param initialization Distribution of the initial weights
+     * @param seed Seed of the initial weights (see Philox), drawn from the system if not given
      */
-    std::vector<Value> get_parameters() override;;
+    BasicLayer(int nin, int nout, bool nonlinear, Initialization initialization = Initialization::Uniform,
+               std::optional<std::uint64_t> seed = std::nullopt);
 
     /**
      * @brief Calculate the neuron activations given an input x
      * @param x Input vector to this layer
      * @return Vector of neuron activations/outputs from this Layer
      */
-    std::vector<Value> operator()(const std::vector<Value> &x) const;
+    std::vector<Value> operator()(const std::vector<Value> &x) const requires std::same_as<T, double>;
+
+    /**
+     * @brief Record the neuron activations given an input x on a Tape
+     * @param tape Tape to record the computation on
+     * @param x Input vector to this layer
+     * @return Vector of neuron activations/outputs from this Layer
+     */
+    std::vector<TapeValue> operator()(Tape &tape, const std::vector<TapeValue> &x) const
+        requires std::same_as<T, double>;
 
     /**
-     * @brief Zero the gradients of all the neurons in the Layers.
+     * @brief Calculate the neuron activations given an input Tensor x
+     *
+     * A single sample runs as one matrix-vector product, and a batch of
+     * samples as one matrix product, so the weights are read once for the
+     * whole batch. The gradients flow back into the weights and biases of the
+     * Layer.
+     *
+     * @param x Input Tensor to this layer, either a 1-D sample of shape {nin}
+     *     or a 2-D batch of shape {batch, nin} with one sample per row
+     * @return Tensor of neuron activations/outputs from this Layer, of shape
+     *     {nout} or {batch, nout}
      */
-    void zero_grad() override {
-        for (auto &neuron: neurons) {
-            neuron.zero_grad();
-        }
+    BasicTensor<T> operator()(const BasicTensor<T> &x) const;
+
+    /**
+     * @brief Calculate the neuron activations and their derivatives along the tangents of x
+     *
+     * The weights and biases are treated as constants, so this computes the
+     * Jacobian-vector product of the Layer with respect to its input.
+     *
+     * @param x Input vector of dual numbers to this layer
+     * @return Vector of neuron activations/outputs from this Layer, with their tangents
+     */
+    std::vector<Dual> operator()(const std::vector<Dual> &x) const requires std::same_as<T, double>;
+
+    /**
+     * @brief Get the weights of the Layer
+     * @return Tensor of shape {nout, nin} holding the weights
+     */
+    [[nodiscard]] const BasicTensor<T> &get_weights() const {
+        return this->weights;
     }
+
+    /**
+     * @brief Get the biases of the Layer
+     * @return Tensor of shape {nout} holding the biases
+     */
+    [[nodiscard]] const BasicTensor<T> &get_biases() const {
+        return this->biases;
+    }
+
+    /**
+     * @brief Get the Tensors holding the parameters of the Layer
+     * @return The weights followed by the biases
+     */
+    [[nodiscard]] std::vector<BasicTensor<T> > get_parameter_tensors() const {
+        return {this->weights, this->biases};
+    }
+
+    /**
+     * @brief Create a Layer sharing the data of the parameters of this one,
+     *     but with gradients of its own
+     * @return Layer reading the same weights and biases
+     */
+    [[nodiscard]] BasicLayer replicate() const;
 };
 
+using Layer = BasicLayer<double>;
 
-class MultiLayerPerceptron final : public Module {
-    std::vector<Layer> layers;
+/**
+ * @brief Layer of floats, for models which can trade precision for speed.
+ */
+using FloatLayer = BasicLayer<float>;
+
+
+class CompiledMultiLayerPerceptron;
+
+/**
+ * @brief A stack of Layers, every one but the last followed by a ReLU
+ *
+ * The parameters of all the Layers are stored in a single buffer. A
+ * MultiLayerPerceptron of floats (FloatMultiLayerPerceptron) runs on
+ * FloatTensors and is trained with the float Optimizers; the graph-based
+ * interfaces (Values, Tapes, Duals) and saving only exist for doubles. Models
+ * can be converted between the two with cast.
+ *
+ * @tparam T Scalar type of the parameters, float or double.
+ */
+template<typename T>
+class BasicMultiLayerPerceptron final : public BasicModule<T> {
+    /**
+     * @brief Number of inputs to the MultiLayerPerceptron
+     */
+    int nin;
+    std::vector<BasicLayer<T> > layers;
+
+    // Casts build the MultiLayerPerceptron of the other scalar type over a new buffer
+    template<typename>
+    friend class BasicMultiLayerPerceptron;
+
+    /**
+     * @brief Create a MultiLayerPerceptron over a parameter buffer, without initializing it
+     *
+     * The Layers take up consecutive slices of the buffer, from the input to the output.
+     *
+     * @param nin Number of inputs to the Multilayer Perceptron
+     * @param nouts Vector of Layer sizes for the MultiLayerPerceptron
+     * @param buffer Buffers holding the parameters of every Layer
+     */
+    BasicMultiLayerPerceptron(int nin, const std::vector<int> &nouts,
+                              std::shared_ptr<BasicParameterBuffer<T> > buffer);
+
+    /**
+     * @brief Get the number of parameters of a MultiLayerPerceptron
+     * @param nin Number of inputs to the Multilayer Perceptron
+     * @param nouts Vector of Layer sizes for the MultiLayerPerceptron
+     * @return Number of weights and biases of all the Layers
+     */
+    static std::size_t parameterCountOf(int nin, const std::vector<int> &nouts);
+
+    /**
+     * @brief Get the size of every Layer
+     * @return Number of outputs of each Layer, from the input to the output
+     */
+    [[nodiscard]] std::vector<int> layerSizes() const;
+
+    /**
+     * @brief Save the MultiLayerPerceptron to a binary file, followed by a block of optimizer state
+     * @param path File to write, replaced if it exists
+     * @param state State of the optimizer
+     * @param hasState Whether the file records an optimizer (whose state can be empty)
+     */
+    void save(const std::string &path, std::span<const double> state, bool hasState) const
+        requires std::same_as<T, double>;
 
 public:
     /**
      * @brief Create a MultiLayerPerceptron
+     *
+     * The parameters of all the Layers are stored in a single buffer. The
+     * initial weights only depend on the seed, so two MultiLayerPerceptrons
+     * of the same sizes created with the same seed are identical.
+     *
      * @param nin Number of inputs to the Multilayer Perceptron
      * @param nouts Vector of Layer sizes for the MultiLayerPerceptron
+     * @param initialization Distribution of the initial weights
+     * @param seed Seed of the initial weights (see Philox), drawn from the system if not given
      */
-    MultiLayerPerceptron(int nin, std::vector<int> nouts) {
-        this->layers.emplace_back(nin, nouts[0], 0 != nouts.size() - 1);
-        for (int idx = 0; idx < nouts.size()-1; ++idx) {
-            this->layers.emplace_back(nouts[idx], nouts[idx + 1], idx != nouts.size() - 2);
-        }
-    }
+    BasicMultiLayerPerceptron(int nin, const std::vector<int> &nouts,
+                              Initialization initialization = Initialization::Uniform,
+                              std::optional<std::uint64_t> seed = std::nullopt);
 
     /**
      * @brief Run the MultiLayerPerceptron on a given input
      * @param x Input of vector of Values to the MultiLayerPerceptron
      * @return Activation values of the last layer of the MultiLayerPerceptron
      */
-    std::vector<Value> operator()(std::vector<Value> x) const;
+    std::vector<Value> operator()(std::vector<Value> x) const requires std::same_as<T, double>;
 
     /**
-     * @brief Get all the parameters associated with the MultiLayerPerceptron
-     * @return A vectors of the parameters for all Layers in the perceptron
+     * @brief Run the MultiLayerPerceptron on a given input, keeping only the
+     *     activations between segments of Layers
+     *
+     * Every segment of consecutive Layers runs through checkpoint, so the
+     * graph holds the activations at the end of each segment rather than every
+     * node of every Layer, and the nodes of a segment are recomputed (one
+     * segment at a time) during the backward pass. The outputs and gradients
+     * are the same as those of operator().
+     *
+     * @param x Input of vector of Values to the MultiLayerPerceptron
+     * @param segmentLength Number of Layers in each segment
+     * @return Activation values of the last layer of the MultiLayerPerceptron
      */
-    std::vector<Value> get_parameters() override;
+    std::vector<Value> checkpointed(std::vector<Value> x, std::size_t segmentLength) const
+        requires std::same_as<T, double>;
 
     /**
-     * @brief Zero the gradients of all the Layers in the MultiLayerPerceptron
+     * @brief Record the MultiLayerPerceptron run on a given input on a Tape
+     *
+     * The parameters are recorded as leaves bound to their Values, so calling
+     * Tape::backwards accumulates their gradients as usual.
+     *
+     * @param tape Tape to record the computation on
+     * @param x Input of vector of TapeValues to the MultiLayerPerceptron
+     * @return Activation values of the last layer of the MultiLayerPerceptron
      */
-    void zero_grad() override {
-        for (auto &l: this->layers) {
-            l.zero_grad();
-        }
+    std::vector<TapeValue> operator()(Tape &tape, std::vector<TapeValue> x) const requires std::same_as<T, double>;
+
+    /**
+     * @brief Run the MultiLayerPerceptron on a given input Tensor
+     *
+     * Every Layer runs as a single matrix-vector product (or matrix product
+     * for a batch), which is much faster than building a graph of Values for
+     * wide Layers. Calling backwards on (a function of) the output of a batch
+     * accumulates the gradients of every sample in a single pass.
+     *
+     * @param x Input Tensor to the MultiLayerPerceptron, either a 1-D sample
+     *     of shape {nin} or a 2-D batch of shape {batch, nin}
+     * @return Activation values of the last layer of the MultiLayerPerceptron,
+     *     one row per sample for a batch
+     */
+    BasicTensor<T> operator()(const BasicTensor<T> &x) const;
+
+    /**
+     * @brief Run the MultiLayerPerceptron on a given input of dual numbers
+     *
+     * A single forward pass computes the outputs along with their derivative
+     * along the tangents of x (treating the parameters as constants), without
+     * building a graph. Seeding the tangent of input i with 1 and the others
+     * with 0 gives the sensitivity of every output to input i.
+     *
+     * @param x Input of vector of Duals to the MultiLayerPerceptron
+     * @return Activation values of the last layer of the MultiLayerPerceptron, with their tangents
+     */
+    std::vector<Dual> operator()(std::vector<Dual> x) const requires std::same_as<T, double>;
+
+    /**
+     * @brief Trace the MultiLayerPerceptron once so that it can be replayed on new inputs
+     * @return CompiledMultiLayerPerceptron sharing the parameters of this MultiLayerPerceptron
+     */
+    [[nodiscard]] CompiledMultiLayerPerceptron compile() const requires std::same_as<T, double>;
+
+    /**
+     * @brief Get the number of inputs to the MultiLayerPerceptron
+     * @return Number of inputs
+     */
+    [[nodiscard]] int get_nin() const {
+        return this->nin;
     }
 
+    /**
+     * @brief Get the Layers of the MultiLayerPerceptron
+     * @return Layers, from the input to the output
+     */
+    [[nodiscard]] const std::vector<BasicLayer<T> > &get_layers() const {
+        return this->layers;
+    }
+
+    /**
+     * @brief Get the Tensors holding the parameters of the MultiLayerPerceptron
+     *
+     * These are the blocks an Optimizer updates, holding the same data as the
+     * Values returned by get_parameters.
+     *
+     * @return The weights and biases of every Layer in turn
+     */
+    [[nodiscard]] std::vector<BasicTensor<T> > get_parameter_tensors() const;
+
+    /**
+     * @brief Create a MultiLayerPerceptron sharing the data of the parameters
+     *     of this one, but with gradients of its own
+     *
+     * Updates to the parameters of either are seen by both, while gradients
+     * computed by one don't touch the other, so several threads can each
+     * compute gradients with their own replica.
+     *
+     * @return MultiLayerPerceptron reading the same parameters
+     */
+    [[nodiscard]] BasicMultiLayerPerceptron replicate() const;
+
+    /**
+     * @brief Create a MultiLayerPerceptron of another scalar type with the same parameters
+     *
+     * The parameters are converted once into a buffer of the new
+     * MultiLayerPerceptron, which is independent of this one from then on (for
+     * example to run a model trained in double as a float model).
+     *
+     * @tparam U Scalar type of the result, float or double (not T).
+     * @return MultiLayerPerceptron of the same sizes holding the converted parameters
+     */
+    template<typename U>
+    [[nodiscard]] BasicMultiLayerPerceptron<U> cast() const;
+
+    /**
+     * @brief Save the MultiLayerPerceptron to a binary file
+     *
+     * The file holds a small versioned header (the number of inputs, the size
+     * and nonlinearity of every Layer) followed by the parameters as one
+     * contiguous little-endian block, in the order of the parameter buffer, so
+     * it is written sequentially and can be mapped back by load without any
+     * parsing.
+     *
+     * @param path File to write, replaced if it exists
+     */
+    void save(const std::string &path) const requires std::same_as<T, double>;
+
+    /**
+     * @brief Save the MultiLayerPerceptron to a binary file along with the state of an Optimizer
+     *
+     * The state follows the parameters as a second contiguous block, and is
+     * restored by load_optimizer_state.
+     *
+     * @param path File to write, replaced if it exists
+     * @param optimizer Optimizer over the parameters of the MultiLayerPerceptron
+     */
+    void save(const std::string &path, const BasicOptimizer<T> &optimizer) const requires std::same_as<T, double>;
+
+    /**
+     * @brief Load a MultiLayerPerceptron saved by save
+     *
+     * The file is mapped into memory (see MappedFile) and the parameters view
+     * it directly, so loading takes the same time whatever the size of the
+     * model, pages are read as they are first used, and processes loading the
+     * same file share its pages. Updates to the parameters (such as training)
+     * copy the pages they touch, and never modify the file.
+     *
+     * @param path File written by save
+     * @return MultiLayerPerceptron with the saved parameters, and its gradients at 0
+     */
+    static BasicMultiLayerPerceptron load(const std::string &path) requires std::same_as<T, double>;
+
+    /**
+     * @brief Restore the state of an Optimizer saved along with a MultiLayerPerceptron
+     * @param path File written by save with an Optimizer
+     * @param optimizer Optimizer of the same kind as the saved one, over the
+     *     parameters of the loaded MultiLayerPerceptron
+     */
+    static void load_optimizer_state(const std::string &path, BasicOptimizer<T> &optimizer)
+        requires std::same_as<T, double>;
 };
 
+using MultiLayerPerceptron = BasicMultiLayerPerceptron<double>;
+
+/**
+ * @brief MultiLayerPerceptron of floats, for models which can trade precision for speed.
+ */
+using FloatMultiLayerPerceptron = BasicMultiLayerPerceptron<float>;
+
+// Defined and instantiated in nn.cpp
+extern template class BasicLayer<float>;
+extern template class BasicLayer<double>;
+extern template class BasicMultiLayerPerceptron<float>;
+extern template class BasicMultiLayerPerceptron<double>;
+
+/**
+ * @brief A MultiLayerPerceptron recorded once onto a Tape and replayed for every input.
+ *
+ * Calling a MultiLayerPerceptron builds a fresh graph for every input, even
+ * though the shape of the graph never changes. A CompiledMultiLayerPerceptron
+ * records the graph a single time, and afterwards only rewrites the data of the
+ * input leaves and recomputes the recorded instructions, so neither running it
+ * nor computing gradients creates any nodes. The recorded graph is optimized
+ * (see Tape::optimize), so the weighted sum of every neuron is evaluated by a
+ * single fused node. The parameters are shared with the
+ * MultiLayerPerceptron it was compiled from: updates to their data are picked
+ * up by the next call, and backwards accumulates into their gradients.
+ */
+class CompiledMultiLayerPerceptron {
+    /**
+     * @brief Tape holding the recorded graph (heap allocated so its address stays stable)
+     */
+    std::unique_ptr<Tape> tape;
+    /**
+     * @brief Input leaves of the recorded graph
+     */
+    std::vector<TapeValue> inputs;
+    /**
+     * @brief Outputs of the recorded graph
+     */
+    std::vector<TapeValue> outputs;
+
+public:
+    /**
+     * @brief Record a MultiLayerPerceptron
+     * @param mlp MultiLayerPerceptron to record
+     */
+    explicit CompiledMultiLayerPerceptron(const MultiLayerPerceptron &mlp);
+
+    /**
+     * @brief Run the recorded MultiLayerPerceptron on a given input
+     * @param x Input to the MultiLayerPerceptron
+     * @return Activation values of the last layer of the MultiLayerPerceptron
+     */
+    std::vector<double> operator()(const std::vector<double> &x);
+
+    /**
+     * @brief Accumulate the gradients of the parameters for the last input
+     * @param outputGrads Gradient of the loss with respect to each output
+     */
+    void backwards(const std::vector<double> &outputGrads);
+
+    /**
+     * @brief Get the number of nodes in the recorded graph
+     * @return Number of nodes
+     */
+    [[nodiscard]] std::size_t size() const {
+        return this->tape->size();
+    }
+};
+
+/**
+ * @brief Trains a MultiLayerPerceptron on several threads at once.
+ *
+ * Every step splits the batch into one shard per worker. Each worker runs the
+ * forward and backward pass of its shard with its own replica of the model,
+ * so the workers share the parameter data but accumulate gradients into
+ * separate buffers. The buffers are then summed pairwise in a tree (which
+ * takes log2(workers) rounds, each run in parallel), written into the
+ * gradients of the model, and used by an Optimizer to update it.
+ *
+ * The loss is the squared error, summed over the outputs and averaged over
+ * the samples of the batch.
+ */
+class DataParallelTrainer {
+    /**
+     * @brief Model being trained (sharing its parameters with the one passed in)
+     */
+    MultiLayerPerceptron model;
+    /**
+     * @brief One replica of the model per worker
+     */
+    std::vector<MultiLayerPerceptron> replicas;
+    /**
+     * @brief Optimizer created by the trainer, if it wasn't given one
+     */
+    std::unique_ptr<Optimizer> ownedOptimizer;
+    /**
+     * @brief Optimizer updating the parameters of the model
+     */
+    Optimizer *optimizer;
+    /**
+     * @brief Pool the workers run on
+     */
+    ThreadPool &pool;
+
+public:
+    /**
+     * @brief Create a trainer for a MultiLayerPerceptron
+     * @param mlp MultiLayerPerceptron to train, its parameters are updated in place
+     * @param numWorkers Number of shards each batch is split into, at least 1
+     * @param learningRate Step size of the gradient descent update
+     * @param pool Pool of threads the shards are processed on
+     * @throws std::runtime_error If mlp has no layers.
+     */
+    DataParallelTrainer(const MultiLayerPerceptron &mlp, std::size_t numWorkers, double learningRate,
+                        ThreadPool &pool = ThreadPool::global());
+
+    /**
+     * @brief Create a trainer for a MultiLayerPerceptron using a given Optimizer
+     * @param mlp MultiLayerPerceptron to train, its parameters are updated in place
+     * @param numWorkers Number of shards each batch is split into, at least 1
+     * @param optimizer Optimizer over the parameter tensors of mlp, which must
+     *     outlive the trainer
+     * @param pool Pool of threads the shards are processed on
+     * @throws std::runtime_error If mlp has no layers.
+     */
+    DataParallelTrainer(const MultiLayerPerceptron &mlp, std::size_t numWorkers, Optimizer &optimizer,
+                        ThreadPool &pool = ThreadPool::global());
+
+    /**
+     * @brief Run a single training step on a batch
+     *
+     * After the step, the gradients of the model hold the gradient of the loss
+     * of the batch (they are zeroed before it).
+     *
+     * @param inputs Inputs of the batch, of shape {batch, nin}
+     * @param targets Expected outputs of the batch, of shape {batch, nout}
+     * @return Loss of the batch before the update
+     */
+    double step(const Tensor &inputs, const Tensor &targets);
+
+    /**
+     * @brief Get the number of workers
+     * @return Number of shards each batch is split into
+     */
+    [[nodiscard]] std::size_t get_num_workers() const {
+        return this->replicas.size();
+    }
+};
@@ -0,0 +1,129 @@
+#include "optim.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "kernels.h"
+#include "profiler.h"
+
+template<typename T>
+BasicOptimizer<T>::BasicOptimizer(std::vector<BasicTensor<T> > params) : params(std::move(params)) {
+    std::size_t offset = 0;
+    for (const auto &param: this->params) {
+        this->offsets.push_back(offset);
+        offset += param.size();
+    }
+    this->offsets.push_back(offset);
+}
+
+template<typename T>
+void BasicOptimizer<T>::zero_grad() const {
+    for (const auto &param: this->params) {
+        param.zero_grad();
+    }
+}
+
+template<typename T>
+void BasicOptimizer<T>::set_state(const std::span<const double> state) {
+    if (!state.empty()) {
+        throw std::runtime_error("Optimizer::set_state: expected an empty state, got " +
+                                 std::to_string(state.size()) + " values");
+    }
+}
+
+template<typename T>
+BasicSGD<T>::BasicSGD(std::vector<BasicTensor<T> > params, const double learningRate, const double momentum)
+    : BasicOptimizer<T>(std::move(params)), learningRate(learningRate), momentum(momentum) {
+    if (this->momentum != 0.) {
+        this->velocity.assign(this->offsets.back(), 0.);
+    }
+}
+
+template<typename T>
+void BasicSGD<T>::step(const bool zeroGrad) {
+    const Profiler::Span profile{"SGD::step", "optim"};
+    for (std::size_t idx = 0; idx < this->params.size(); ++idx) {
+        const BasicTensor<T> &param = this->params[idx];
+        if (this->velocity.empty()) {
+            kernels::sgdStep(param.get_data().data(), param.get_grad().data(), param.size(),
+                             static_cast<T>(this->learningRate), zeroGrad);
+        } else {
+            kernels::momentumStep(param.get_data().data(), param.get_grad().data(),
+                                  this->velocity.data() + this->offsets[idx], param.size(),
+                                  static_cast<T>(this->learningRate), static_cast<T>(this->momentum), zeroGrad);
+        }
+    }
+}
+
+template<typename T>
+std::vector<double> BasicSGD<T>::get_state() const {
+    return {this->velocity.begin(), this->velocity.end()};
+}
+
+template<typename T>
+void BasicSGD<T>::set_state(const std::span<const double> state) {
+    if (state.size() != this->velocity.size()) {
+        throw std::runtime_error("SGD::set_state: expected " + std::to_string(this->velocity.size()) +
+                                 " values, got " + std::to_string(state.size()));
+    }
+    std::ranges::transform(state, this->velocity.begin(), [](const double x) { return static_cast<T>(x); });
+}
+
+template<typename T>
+BasicAdam<T>::BasicAdam(std::vector<BasicTensor<T> > params, const double learningRate, const double beta1,
+                        const double beta2, const double epsilon)
+    : BasicOptimizer<T>(std::move(params)), learningRate(learningRate), beta1(beta1), beta2(beta2), epsilon(epsilon),
+      m(this->offsets.back(), 0.), v(this->offsets.back(), 0.) {
+}
+
+template<typename T>
+void BasicAdam<T>::step(const bool zeroGrad) {
+    const Profiler::Span profile{"Adam::step", "optim"};
+    ++this->steps;
+    // Dividing m by (1 - beta1^t) and v by (1 - beta2^t) is the same as scaling
+    // the step and epsilon, which keeps the per-element work to the update itself
+    const double correction1 = 1.0 - std::pow(this->beta1, static_cast<double>(this->steps));
+    const double correction2 = std::sqrt(1.0 - std::pow(this->beta2, static_cast<double>(this->steps)));
+    const double stepSize = this->learningRate * correction2 / correction1;
+    const double epsilonHat = this->epsilon * correction2;
+    for (std::size_t idx = 0; idx < this->params.size(); ++idx) {
+        const BasicTensor<T> &param = this->params[idx];
+        kernels::adamStep(param.get_data().data(), param.get_grad().data(), this->m.data() + this->offsets[idx],
+                          this->v.data() + this->offsets[idx], param.size(), static_cast<T>(this->beta1),
+                          static_cast<T>(this->beta2), static_cast<T>(stepSize), static_cast<T>(epsilonHat),
+                          zeroGrad);
+    }
+}
+
+template<typename T>
+std::vector<double> BasicAdam<T>::get_state() const {
+    // The number of steps, followed by m and v
+    std::vector<double> out;
+    out.reserve(1 + this->m.size() + this->v.size());
+    out.push_back(static_cast<double>(this->steps));
+    out.insert(out.end(), this->m.begin(), this->m.end());
+    out.insert(out.end(), this->v.begin(), this->v.end());
+    return out;
+}
+
+template<typename T>
+void BasicAdam<T>::set_state(const std::span<const double> state) {
+    if (state.size() != 1 + this->m.size() + this->v.size()) {
+        throw std::runtime_error("Adam::set_state: expected " + std::to_string(1 + this->m.size() + this->v.size()) +
+                                 " values, got " + std::to_string(state.size()));
+    }
+    const auto toT = [](const double x) { return static_cast<T>(x); };
+    this->steps = static_cast<std::uint64_t>(state[0]);
+    std::transform(state.begin() + 1, state.begin() + 1 + this->m.size(), this->m.begin(), toT);
+    std::transform(state.begin() + 1 + this->m.size(), state.end(), this->v.begin(), toT);
+}
+
+template class BasicOptimizer<float>;
+template class BasicOptimizer<double>;
+template class BasicSGD<float>;
+template class BasicSGD<double>;
+template class BasicAdam<float>;
+template class BasicAdam<double>;
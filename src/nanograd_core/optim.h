@@ -0,0 +1,225 @@
+#pragma once
+// Standard Library Includes
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Local Includes
+#include "tensor.h"
+
+// External Includes
+
+/**
+ * @brief Base class for the optimizers updating a set of parameter Tensors.
+ *
+ * Any state kept per parameter (such as a velocity) is stored in a single
+ * contiguous buffer covering every parameter Tensor, and each step updates
+ * the data, gradient and state of a Tensor in a single vectorized pass.
+ *
+ * @tparam T Scalar type of the parameters, float or double. The state is
+ *     kept in the same type, so a float model is updated with float kernels.
+ */
+template<typename T>
+class BasicOptimizer {
+protected:
+  /**
+   * @brief Parameters being updated.
+   */
+  std::vector<BasicTensor<T> > params;
+  /**
+   * @brief Offset of each parameter in the state buffers, followed by the
+   *     total number of elements.
+   */
+  std::vector<std::size_t> offsets;
+
+public:
+  /**
+   * @brief Create an optimizer for a set of parameters.
+   * @param params Parameters to update, their data is updated in place.
+   */
+  explicit BasicOptimizer(std::vector<BasicTensor<T> > params);
+
+  virtual ~BasicOptimizer() = default;
+
+  /**
+   * @brief Update the parameters using their current gradients.
+   * @param zeroGrad Whether to also set the gradients to 0, in the same pass.
+   */
+  virtual void step(bool zeroGrad = false) = 0;
+
+  /**
+   * @brief Set the gradients of all the parameters to 0.
+   */
+  void zero_grad() const;
+
+  /**
+   * @brief Get the state kept by the optimizer, such as the velocities.
+   * @return State flattened into a single array of doubles, whatever the
+   *     scalar type (empty for a stateless optimizer)
+   */
+  [[nodiscard]] virtual std::vector<double> get_state() const {
+    return {};
+  }
+
+  /**
+   * @brief Restore the state of the optimizer.
+   * @param state State returned by get_state, for an optimizer of the same kind over
+   *     parameters of the same sizes.
+   */
+  virtual void set_state(std::span<const double> state);
+
+  /**
+   * @brief Get the parameters being updated.
+   * @return Parameters of the optimizer
+   */
+  [[nodiscard]] const std::vector<BasicTensor<T> > &get_parameters() const {
+    return this->params;
+  }
+};
+
+/**
+ * @brief Stochastic gradient descent, optionally with momentum.
+ *
+ * @tparam T Scalar type of the parameters, float or double.
+ */
+template<typename T>
+class BasicSGD final : public BasicOptimizer<T> {
+  /**
+   * @brief Step size.
+   */
+  double learningRate;
+  /**
+   * @brief Decay of the velocity, 0 for plain gradient descent.
+   */
+  double momentum;
+  /**
+   * @brief Velocity of every parameter (empty without momentum).
+   */
+  std::vector<T> velocity;
+
+public:
+  /**
+   * @brief Create a gradient descent optimizer.
+   * @param params Parameters to update.
+   * @param learningRate Step size.
+   * @param momentum Decay of the velocity, 0 for plain gradient descent.
+   */
+  BasicSGD(std::vector<BasicTensor<T> > params, double learningRate, double momentum = 0.);
+
+  void step(bool zeroGrad = false) override;
+
+  [[nodiscard]] std::vector<double> get_state() const override;
+
+  void set_state(std::span<const double> state) override;
+
+  /**
+   * @brief Get the step size.
+   * @return Learning rate
+   */
+  [[nodiscard]] double get_learning_rate() const {
+    return this->learningRate;
+  }
+
+  /**
+   * @brief Set the step size, for example from a schedule.
+   * @param learningRate New learning rate
+   */
+  void set_learning_rate(const double learningRate) {
+    this->learningRate = learningRate;
+  }
+};
+
+/**
+ * @brief The Adam optimizer, scaling each step by running estimates of the
+ *     mean and variance of the gradients.
+ *
+ * @tparam T Scalar type of the parameters, float or double.
+ */
+template<typename T>
+class BasicAdam final : public BasicOptimizer<T> {
+  /**
+   * @brief Step size.
+   */
+  double learningRate;
+  /**
+   * @brief Decay of the running mean of the gradient.
+   */
+  double beta1;
+  /**
+   * @brief Decay of the running mean of the squared gradient.
+   */
+  double beta2;
+  /**
+   * @brief Term keeping the denominator of the update away from 0.
+   */
+  double epsilon;
+  /**
+   * @brief Number of steps taken so far.
+   */
+  std::uint64_t steps = 0;
+  /**
+   * @brief Running mean of the gradient of every parameter.
+   */
+  std::vector<T> m;
+  /**
+   * @brief Running mean of the squared gradient of every parameter.
+   */
+  std::vector<T> v;
+
+public:
+  /**
+   * @brief Create an Adam optimizer.
+   * @param params Parameters to update.
+   * @param learningRate Step size.
+   * @param beta1 Decay of the running mean of the gradient.
+   * @param beta2 Decay of the running mean of the squared gradient.
+   * @param epsilon Term keeping the denominator of the update away from 0.
+   */
+  explicit BasicAdam(std::vector<BasicTensor<T> > params, double learningRate = 0.001, double beta1 = 0.9,
+                     double beta2 = 0.999, double epsilon = 1e-8);
+
+  void step(bool zeroGrad = false) override;
+
+  [[nodiscard]] std::vector<double> get_state() const override;
+
+  void set_state(std::span<const double> state) override;
+
+  /**
+   * @brief Get the step size.
+   * @return Learning rate
+   */
+  [[nodiscard]] double get_learning_rate() const {
+    return this->learningRate;
+  }
+
+  /**
+   * @brief Set the step size, for example from a schedule.
+   * @param learningRate New learning rate
+   */
+  void set_learning_rate(const double learningRate) {
+    this->learningRate = learningRate;
+  }
+};
+
+/**
+ * @brief Optimizer over Tensors of doubles, the scalar type used by the rest of the engine.
+ */
+using Optimizer = BasicOptimizer<double>;
+using SGD = BasicSGD<double>;
+using Adam = BasicAdam<double>;
+
+/**
+ * @brief Optimizers over the parameters of float models.
+ */
+using FloatOptimizer = BasicOptimizer<float>;
+using FloatSGD = BasicSGD<float>;
+using FloatAdam = BasicAdam<float>;
+
+// Defined and instantiated in optim.cpp
+extern template class BasicOptimizer<float>;
+extern template class BasicOptimizer<double>;
+extern template class BasicSGD<float>;
+extern template class BasicSGD<double>;
+extern template class BasicAdam<float>;
+extern template class BasicAdam<double>;
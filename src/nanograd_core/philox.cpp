@@ -0,0 +1,60 @@
+#include "philox.h"
+
+#include <random>
+
+namespace {
+    // Constants of Philox4x32 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+    constexpr std::uint32_t multiplier0 = 0xD2511F53;
+    constexpr std::uint32_t multiplier1 = 0xCD9E8D57;
+    constexpr std::uint32_t keyIncrement0 = 0x9E3779B9;
+    constexpr std::uint32_t keyIncrement1 = 0xBB67AE85;
+    constexpr int rounds = 10;
+
+    // Map 64 random bits to [0, 1), keeping the 53 bits a double can hold
+    double toUnit(const std::uint32_t high, const std::uint32_t low) {
+        const std::uint64_t bits = (static_cast<std::uint64_t>(high) << 32) | low;
+        return static_cast<double>(bits >> 11) * 0x1.0p-53;
+    }
+}
+
+std::array<std::uint32_t, 4> Philox::block(std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key) {
+    for (int round = 0; round < rounds; ++round) {
+        const std::uint64_t product0 = static_cast<std::uint64_t>(multiplier0) * counter[0];
+        const std::uint64_t product1 = static_cast<std::uint64_t>(multiplier1) * counter[2];
+        counter = {
+            static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+            static_cast<std::uint32_t>(product1),
+            static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+            static_cast<std::uint32_t>(product0)
+        };
+        key[0] += keyIncrement0;
+        key[1] += keyIncrement1;
+    }
+    return counter;
+}
+
+void Philox::uniform(double *out, const std::size_t count, const std::uint64_t first, const double low,
+                     const double high, const std::uint64_t seed, const std::uint64_t stream) {
+    const std::array key{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+    const double scale = high - low;
+    // Every block gives two numbers, block b holding numbers 2b and 2b + 1 of the stream
+    std::size_t idx = 0;
+    while (idx < count) {
+        const std::uint64_t position = first + idx;
+        const std::uint64_t blockIndex = position / 2;
+        const auto bits = block({
+                                    static_cast<std::uint32_t>(blockIndex),
+                                    static_cast<std::uint32_t>(blockIndex >> 32),
+                                    static_cast<std::uint32_t>(stream),
+                                    static_cast<std::uint32_t>(stream >> 32)
+                                }, key);
+        for (std::uint64_t half = position % 2; half < 2 && idx < count; ++half, ++idx) {
+            out[idx] = low + scale * toUnit(bits[2 * half], bits[2 * half + 1]);
+        }
+    }
+}
+
+std::uint64_t Philox::random_seed() {
+    std::random_device device;
+    return (static_cast<std::uint64_t>(device()) << 32) | device();
+}
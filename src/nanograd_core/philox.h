@@ -0,0 +1,55 @@
+#pragma once
+// Standard Library Includes
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Local Includes
+
+// External Includes
+
+/**
+ * @brief The Philox4x32-10 counter-based random number generator.
+ *
+ * Rather than stepping a hidden state, Philox turns a counter into random
+ * bits with a keyed bijection, so the n-th number of a stream can be computed
+ * directly. Any part of a stream can be generated on any thread, in any order,
+ * and the numbers only depend on the key (the seed), the stream and their
+ * position.
+ */
+class Philox {
+public:
+  /**
+   * @brief Compute one block of random bits.
+   * @param counter Counter of the block, the first two words hold the position
+   *     and the last two the stream.
+   * @param key Key of the generator, usually the seed.
+   * @return 128 random bits
+   */
+  static std::array<std::uint32_t, 4> block(std::array<std::uint32_t, 4> counter,
+                                            std::array<std::uint32_t, 2> key);
+
+  /**
+   * @brief Fill a buffer with numbers uniform in [low, high).
+   *
+   * Element i of the buffer gets number first + i of the stream, so a large
+   * buffer can be split between threads and filled chunk by chunk with the
+   * same result.
+   *
+   * @param out Buffer to fill.
+   * @param count Number of elements to fill.
+   * @param first Position in the stream of the first element.
+   * @param low Lower bound of the numbers.
+   * @param high Upper bound of the numbers.
+   * @param seed Seed of the generator.
+   * @param stream Stream of the generator, independent streams can share a seed.
+   */
+  static void uniform(double *out, std::size_t count, std::uint64_t first, double low, double high,
+                      std::uint64_t seed, std::uint64_t stream);
+
+  /**
+   * @brief Draw a seed from the random device of the system.
+   * @return Unpredictable seed
+   */
+  static std::uint64_t random_seed();
+};
@@ -0,0 +1,209 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    // A finished span of the Chrome trace, with times in microseconds since the profiler started
+    struct TraceEvent {
+        const char *name;
+        const char *category;
+        double start;
+        double duration;
+    };
+
+    std::mutex registryMutex;
+    // Time the profiler last started, the trace is relative to it
+    std::atomic<std::chrono::steady_clock::rep> originTicks{
+        std::chrono::steady_clock::now().time_since_epoch().count()
+    };
+
+    double microsecondsSinceOrigin(const std::chrono::steady_clock::time_point time) {
+        const std::chrono::steady_clock::time_point origin{
+            std::chrono::steady_clock::duration{originTicks.load(std::memory_order_relaxed)}
+        };
+        return std::chrono::duration<double, std::micro>(time - origin).count();
+    }
+}
+
+// Everything recorded by a single thread, the thread locks it while recording
+// (which is uncontended) so that it can be read from other threads
+struct Profiler::ThreadRecord {
+    std::mutex mutex;
+    std::size_t index = 0;
+    // Keyed by the string literals naming the operations, so lookups don't compare strings.
+    // Entries are only ever zeroed, so running Operations can keep pointers to them
+    std::unordered_map<const char *, ProfileReport::OperationStats> operations;
+    ProfileReport::OperationStats *current = nullptr;
+    std::vector<TraceEvent> events;
+    double topoSortSeconds = 0.;
+    double backwardSeconds = 0.;
+    std::uint64_t backwardPasses = 0;
+    std::size_t maxDepth = 0;
+    std::size_t maxWidth = 0;
+};
+
+std::atomic<bool> Profiler::enabled{false};
+
+std::vector<std::shared_ptr<Profiler::ThreadRecord> > &Profiler::threadRecords() {
+    static std::vector<std::shared_ptr<ThreadRecord> > records;
+    return records;
+}
+
+Profiler::ThreadRecord &Profiler::threadRecord() {
+    // Kept alive by the registry after the thread exits, so its records can still be reported
+    thread_local const std::shared_ptr<ThreadRecord> record = []() {
+        auto newRecord = std::make_shared<ThreadRecord>();
+        std::lock_guard lock{registryMutex};
+        newRecord->index = threadRecords().size();
+        threadRecords().push_back(newRecord);
+        return newRecord;
+    }();
+    return *record;
+}
+
+void Profiler::start() {
+    reset();
+    originTicks.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::stop() {
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+void Profiler::reset() {
+    std::lock_guard registryLock{registryMutex};
+    for (const auto &record: threadRecords()) {
+        std::lock_guard lock{record->mutex};
+        for (auto &stats: record->operations | std::views::values) {
+            stats = ProfileReport::OperationStats{};
+        }
+        record->events.clear();
+        record->topoSortSeconds = 0.;
+        record->backwardSeconds = 0.;
+        record->backwardPasses = 0;
+        record->maxDepth = 0;
+        record->maxWidth = 0;
+    }
+}
+
+ProfileReport Profiler::report() {
+    ProfileReport out;
+    std::lock_guard registryLock{registryMutex};
+    for (const auto &record: threadRecords()) {
+        std::lock_guard lock{record->mutex};
+        for (const auto &[name, stats]: record->operations) {
+            if (stats.nodes == 0 && stats.seconds == 0.) {
+                continue;
+            }
+            ProfileReport::OperationStats &total = out.operations[name];
+            total.nodes += stats.nodes;
+            total.seconds += stats.seconds;
+            total.bytes += stats.bytes;
+            out.forwardSeconds += stats.seconds;
+            out.nodes += stats.nodes;
+            out.nodeBytes += stats.bytes;
+        }
+        out.topoSortSeconds += record->topoSortSeconds;
+        out.backwardSeconds += record->backwardSeconds;
+        out.backwardPasses += record->backwardPasses;
+        out.maxDepth = std::max(out.maxDepth, record->maxDepth);
+        out.maxWidth = std::max(out.maxWidth, record->maxWidth);
+    }
+    return out;
+}
+
+std::string Profiler::chrome_trace() {
+    std::string out = "{\"traceEvents\":[";
+    bool first = true;
+    std::lock_guard registryLock{registryMutex};
+    for (const auto &record: threadRecords()) {
+        std::lock_guard lock{record->mutex};
+        for (const auto &event: record->events) {
+            if (!first) {
+                out += ",";
+            }
+            first = false;
+            // Names and categories are string literals of the library, so they need no escaping
+            out += "{\"name\":\"" + std::string{event.name} + "\",\"cat\":\"" + std::string{event.category} +
+                    "\",\"ph\":\"X\",\"ts\":" + std::to_string(event.start) + ",\"dur\":" +
+                    std::to_string(event.duration) + ",\"pid\":0,\"tid\":" + std::to_string(record->index) + "}";
+        }
+    }
+    out += "],\"displayTimeUnit\":\"ms\"}";
+    return out;
+}
+
+void Profiler::write_chrome_trace(const std::string &path) {
+    std::ofstream file{path};
+    if (!file) {
+        throw std::runtime_error("Profiler::write_chrome_trace: unable to open " + path);
+    }
+    file << chrome_trace();
+}
+
+void Profiler::recordNode(const std::size_t bytes, const char *leafOperation) {
+    ThreadRecord &record = threadRecord();
+    std::lock_guard lock{record.mutex};
+    ProfileReport::OperationStats &stats = record.current != nullptr
+                                               ? *record.current
+                                               : record.operations[leafOperation];
+    ++stats.nodes;
+    stats.bytes += bytes;
+}
+
+void Profiler::recordGraph(const std::size_t depth, const std::size_t width) {
+    ThreadRecord &record = threadRecord();
+    std::lock_guard lock{record.mutex};
+    ++record.backwardPasses;
+    record.maxDepth = std::max(record.maxDepth, depth);
+    record.maxWidth = std::max(record.maxWidth, width);
+}
+
+void Profiler::Operation::begin(const char *operationName) {
+    ThreadRecord &record = threadRecord();
+    {
+        std::lock_guard lock{record.mutex};
+        this->stats = &record.operations[operationName];
+        this->previous = record.current;
+        record.current = this->stats;
+    }
+    this->startTime = std::chrono::steady_clock::now();
+}
+
+void Profiler::Operation::end() const {
+    const auto endTime = std::chrono::steady_clock::now();
+    ThreadRecord &record = threadRecord();
+    std::lock_guard lock{record.mutex};
+    this->stats->seconds += std::chrono::duration<double>(endTime - this->startTime).count();
+    record.current = this->previous;
+}
+
+void Profiler::Span::begin(const char *spanName, const char *spanCategory, const Phase spanPhase) {
+    this->name = spanName;
+    this->category = spanCategory;
+    this->phase = spanPhase;
+    this->startTime = std::chrono::steady_clock::now();
+}
+
+void Profiler::Span::end() const {
+    const auto endTime = std::chrono::steady_clock::now();
+    ThreadRecord &record = threadRecord();
+    std::lock_guard lock{record.mutex};
+    const double seconds = std::chrono::duration<double>(endTime - this->startTime).count();
+    if (this->phase == Phase::TopoSort) {
+        record.topoSortSeconds += seconds;
+    } else if (this->phase == Phase::Backward) {
+        record.backwardSeconds += seconds;
+    }
+    record.events.push_back(TraceEvent{
+        this->name, this->category, microsecondsSinceOrigin(this->startTime), seconds * 1e6
+    });
+}
@@ -0,0 +1,298 @@
+#pragma once
+// Standard Library Includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Local Includes
+
+// External Includes
+
+/**
+ * @brief Summary of the work recorded by the Profiler.
+ */
+struct ProfileReport {
+  /**
+   * @brief Work recorded for a single kind of operation.
+   */
+  struct OperationStats {
+    /**
+     * @brief Number of nodes created by the operation.
+     */
+    std::uint64_t nodes = 0;
+    /**
+     * @brief Time spent in the operation, computing the data and building the nodes.
+     */
+    double seconds = 0.;
+    /**
+     * @brief Bytes allocated for the nodes, their children and their buffers.
+     */
+    std::uint64_t bytes = 0;
+  };
+
+  /**
+   * @brief Work recorded for every kind of operation, nodes created outside
+   *     of any operation are counted as "leaf" (or "Tensor leaf").
+   */
+  std::map<std::string, OperationStats> operations;
+  /**
+   * @brief Total time spent building nodes, over all operations.
+   */
+  double forwardSeconds = 0.;
+  /**
+   * @brief Time spent sorting graphs before backward passes.
+   */
+  double topoSortSeconds = 0.;
+  /**
+   * @brief Time spent running the backward functions of nodes.
+   */
+  double backwardSeconds = 0.;
+  /**
+   * @brief Total number of nodes created.
+   */
+  std::uint64_t nodes = 0;
+  /**
+   * @brief Total bytes allocated for nodes.
+   */
+  std::uint64_t nodeBytes = 0;
+  /**
+   * @brief Number of backward passes.
+   */
+  std::uint64_t backwardPasses = 0;
+  /**
+   * @brief Largest depth (longest path from the root to a leaf) of the
+   *     graphs of the backward passes.
+   */
+  std::size_t maxDepth = 0;
+  /**
+   * @brief Largest width (number of nodes at the same depth) of the graphs
+   *     of the backward passes.
+   */
+  std::size_t maxWidth = 0;
+};
+
+/**
+ * @brief Opt-in instrumentation of the engine.
+ *
+ * While the profiler runs, every node records the operation which created it
+ * and the memory it takes up, every operation its time, every backward pass
+ * the time spent sorting and running the graph along with its shape, and the
+ * larger steps (backward passes, Module calls, optimizer and trainer steps)
+ * are recorded as spans of a Chrome trace. Records are kept per thread, so
+ * instrumented code running on several threads doesn't contend. When the
+ * profiler isn't running, each instrumentation point only checks a flag.
+ */
+class Profiler {
+  /**
+   * @brief Whether the profiler is recording.
+   */
+  static std::atomic<bool> enabled;
+
+  struct ThreadRecord;
+
+  /**
+   * @brief Get the record of the calling thread, creating it on first use.
+   * @return Record of the calling thread
+   */
+  static ThreadRecord &threadRecord();
+
+  /**
+   * @brief Get the records of every thread which recorded anything.
+   * @return Records, only accessed under the registry mutex
+   */
+  static std::vector<std::shared_ptr<ThreadRecord> > &threadRecords();
+
+public:
+  /**
+   * @brief Phase of a backward pass a Span is accounted to.
+   */
+  enum class Phase {
+    Other,
+    TopoSort,
+    Backward
+  };
+
+  /**
+   * @brief Discard every record and start recording.
+   */
+  static void start();
+
+  /**
+   * @brief Stop recording, keeping the records made so far.
+   */
+  static void stop();
+
+  /**
+   * @brief Discard every record.
+   */
+  static void reset();
+
+  /**
+   * @brief Check whether the profiler is recording.
+   * @return Whether the profiler is recording
+   */
+  static bool is_enabled() {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Summarize the records of every thread.
+   * @return Summary of the recorded work
+   */
+  static ProfileReport report();
+
+  /**
+   * @brief Get the recorded spans as a Chrome trace.
+   *
+   * The trace can be opened in chrome://tracing or https://ui.perfetto.dev,
+   * with one track per thread.
+   *
+   * @return JSON document in the Trace Event Format
+   */
+  static std::string chrome_trace();
+
+  /**
+   * @brief Write the recorded spans to a file as a Chrome trace.
+   * @param path File to write the trace to.
+   */
+  static void write_chrome_trace(const std::string &path);
+
+  /**
+   * @brief Record a node, attributed to the innermost running Operation.
+   * @param bytes Bytes allocated for the node.
+   * @param leafOperation Operation to attribute the node to outside of any Operation.
+   */
+  static void recordNode(std::size_t bytes, const char *leafOperation);
+
+  /**
+   * @brief Record the shape of the graph of a backward pass.
+   * @param depth Longest path from the root to a leaf.
+   * @param width Largest number of nodes at the same depth.
+   */
+  static void recordGraph(std::size_t depth, std::size_t width);
+
+  /**
+   * @brief Measure and record the shape of the graph of a backward pass.
+   * @param topo Nodes of the graph in topological order, ending with the root.
+   */
+  template<typename Node>
+  static void recordGraph(std::span<Node *const> topo) {
+    if (topo.empty()) {
+      return;
+    }
+    // Parents come after their children, so walking backwards from the root
+    // settles the depth of every parent before it is passed on to the children
+    std::unordered_map<const Node *, std::size_t> depths;
+    depths.reserve(topo.size());
+    depths[topo.back()] = 0;
+    std::size_t maxDepth = 0;
+    for (auto node = topo.rbegin(); node != topo.rend(); ++node) {
+      const std::size_t depth = depths[*node];
+      maxDepth = std::max(maxDepth, depth);
+      for (const auto &child: (*node)->children) {
+        std::size_t &childDepth = depths[child.get()];
+        childDepth = std::max(childDepth, depth + 1);
+      }
+    }
+    std::vector<std::size_t> widths(maxDepth + 1, 0);
+    for (const std::size_t depth: depths | std::views::values) {
+      ++widths[depth];
+    }
+    recordGraph(maxDepth, *std::max_element(widths.begin(), widths.end()));
+  }
+
+  /**
+   * @brief Get the bytes a string allocates on the heap.
+   * @param value String to measure.
+   * @return Capacity of the string, or 0 if it is stored inline
+   */
+  static std::size_t heapBytesOf(const std::string &value) {
+    const auto *object = reinterpret_cast<const char *>(&value);
+    const bool isInline = value.data() >= object && value.data() < object + sizeof(value);
+    return isInline ? 0 : value.capacity() + 1;
+  }
+
+  /**
+   * @brief Times an operation building nodes, while it is alive.
+   *
+   * The nodes created while it is alive are attributed to the operation.
+   */
+  class Operation {
+    ProfileReport::OperationStats *stats = nullptr;
+    ProfileReport::OperationStats *previous = nullptr;
+    std::chrono::steady_clock::time_point startTime;
+
+  public:
+    /**
+     * @brief Start timing an operation.
+     * @param name Kind of the operation, must be a string literal.
+     */
+    explicit Operation(const char *name) {
+      if (is_enabled()) [[unlikely]] {
+        this->begin(name);
+      }
+    }
+
+    ~Operation() {
+      if (this->stats != nullptr) [[unlikely]] {
+        this->end();
+      }
+    }
+
+    Operation(const Operation &) = delete;
+
+    Operation &operator=(const Operation &) = delete;
+
+  private:
+    void begin(const char *operationName);
+
+    void end() const;
+  };
+
+  /**
+   * @brief Records a span of the Chrome trace, while it is alive.
+   */
+  class Span {
+    const char *name;
+    const char *category = nullptr;
+    Phase phase = Phase::Other;
+    std::chrono::steady_clock::time_point startTime;
+
+  public:
+    /**
+     * @brief Start a span.
+     * @param name Name of the span, must be a string literal.
+     * @param category Category of the span, must be a string literal.
+     * @param phase Phase of a backward pass the span is accounted to.
+     */
+    Span(const char *name, const char *category, const Phase phase = Phase::Other) : name(nullptr) {
+      if (is_enabled()) [[unlikely]] {
+        this->begin(name, category, phase);
+      }
+    }
+
+    ~Span() {
+      if (this->name != nullptr) [[unlikely]] {
+        this->end();
+      }
+    }
+
+    Span(const Span &) = delete;
+
+    Span &operator=(const Span &) = delete;
+
+  private:
+    void begin(const char *spanName, const char *spanCategory, Phase spanPhase);
+
+    void end() const;
+  };
+};
@@ -0,0 +1,422 @@
+#include "tape.h"
+
+#include <algorithm>
+#include <limits>
+
+TapeValue TapeValue::pow(const double other) const {
+    Tape *t = this->tape;
+    return t->push(OpCode::Pow, std::pow(t->data[this->index], other), this->index, this->index, other);
+}
+
+TapeValue TapeValue::relu() const {
+    Tape *t = this->tape;
+    const double data = t->data[this->index];
+    return t->push(OpCode::ReLU, data < 0. ? 0. : data, this->index, this->index, 0.);
+}
+
+std::string TapeValue::as_string() const {
+    return "TapeValue(data=" + std::to_string(this->get_data()) +
+           ", grad=" + std::to_string(this->get_grad()) + ")";
+}
+
+void TapeValue::backwards() const {
+    this->tape->backwards(*this);
+}
+
+std::ostream &operator<<(std::ostream &os, const TapeValue &val) {
+    os << "TapeValue(data=" << val.get_data() << ", grad=" << val.get_grad() << ")";
+    return os;
+}
+
+Tape::Tape(const std::size_t capacity) {
+    this->data.reserve(capacity);
+    this->grad.reserve(capacity);
+    this->operand.reserve(capacity);
+    this->ops.reserve(capacity);
+    this->lhs.reserve(capacity);
+    this->rhs.reserve(capacity);
+}
+
+TapeValue Tape::value(const double data) {
+    const auto index = static_cast<std::uint32_t>(this->ops.size());
+    return this->push(OpCode::Leaf, data, index, index, 0.);
+}
+
+TapeValue Tape::parameter(const Value &param) {
+    TapeValue leaf = this->value(param.get_data());
+    this->bindings.emplace_back(leaf.get_index(), param);
+    return leaf;
+}
+
+void Tape::backwards(const TapeValue &root) {
+    if (root.get_tape() != this) {
+        throw std::runtime_error("Tape::backwards: root was recorded on a different tape");
+    }
+    const std::uint32_t rootIndex = root.get_index();
+
+    // Nodes after the root can't contribute to its gradient, so only the
+    // prefix of the tape up to the root needs to be swept
+    std::fill_n(this->grad.data(), rootIndex + 1, 0.);
+    this->grad[rootIndex] = 1.0;
+    this->backwardsSweep(rootIndex);
+}
+
+void Tape::backwards(const std::span<const TapeValue> roots, const std::span<const double> seeds) {
+    if (roots.size() != seeds.size()) {
+        throw std::runtime_error(
+            "Tape::backwards: mismatched size, roots is of size " + std::to_string(roots.size()) +
+            " and seeds is of size " + std::to_string(seeds.size()));
+    }
+    if (roots.empty()) {
+        return;
+    }
+    std::uint32_t last = 0;
+    for (const auto &root: roots) {
+        if (root.get_tape() != this) {
+            throw std::runtime_error("Tape::backwards: root was recorded on a different tape");
+        }
+        last = std::max(last, root.get_index());
+    }
+
+    std::fill_n(this->grad.data(), last + 1, 0.);
+    for (std::size_t idx = 0; idx < roots.size(); ++idx) {
+        this->grad[roots[idx].get_index()] += seeds[idx];
+    }
+    this->backwardsSweep(last);
+}
+
+void Tape::backwardsSweep(const std::uint32_t last) {
+    const double *dataPtr = this->data.data();
+    double *gradPtr = this->grad.data();
+    const double *operandPtr = this->operand.data();
+    const OpCode *opsPtr = this->ops.data();
+    const std::uint32_t *lhsPtr = this->lhs.data();
+    const std::uint32_t *rhsPtr = this->rhs.data();
+    const std::uint32_t *argsPtr = this->args.data();
+
+    // The tape is in topological order, so walking it backwards visits every
+    // node after all the nodes which consume it
+    for (std::uint32_t idx = last + 1; idx-- > 0;) {
+        const double outGrad = gradPtr[idx];
+        switch (opsPtr[idx]) {
+            case OpCode::Leaf:
+                break;
+            case OpCode::Add:
+                gradPtr[lhsPtr[idx]] += outGrad;
+                gradPtr[rhsPtr[idx]] += outGrad;
+                break;
+            case OpCode::Mul:
+                gradPtr[lhsPtr[idx]] += dataPtr[rhsPtr[idx]] * outGrad;
+                gradPtr[rhsPtr[idx]] += dataPtr[lhsPtr[idx]] * outGrad;
+                break;
+            case OpCode::Pow: {
+                const double exponent = operandPtr[idx];
+                gradPtr[lhsPtr[idx]] += (exponent * std::pow(dataPtr[lhsPtr[idx]], exponent - 1.0)) * outGrad;
+                break;
+            }
+            case OpCode::ReLU:
+                gradPtr[lhsPtr[idx]] += (dataPtr[idx] > 0. ? outGrad : 0.);
+                break;
+            case OpCode::Sub:
+                gradPtr[lhsPtr[idx]] += outGrad;
+                gradPtr[rhsPtr[idx]] -= outGrad;
+                break;
+            case OpCode::Dot: {
+                const std::uint32_t *pairs = argsPtr + lhsPtr[idx];
+                for (std::uint32_t term = 0; term < rhsPtr[idx]; ++term) {
+                    const std::uint32_t a = pairs[2 * term];
+                    const std::uint32_t b = pairs[2 * term + 1];
+                    gradPtr[a] += dataPtr[b] * outGrad;
+                    gradPtr[b] += dataPtr[a] * outGrad;
+                }
+                break;
+            }
+        }
+    }
+
+    // Pass the gradients of the bound leaves back to their Values
+    for (const auto &[index, param]: this->bindings) {
+        if (index <= last) {
+            param.set_grad(param.get_grad() + gradPtr[index]);
+        }
+    }
+}
+
+void Tape::forward() {
+    double *dataPtr = this->data.data();
+    const double *operandPtr = this->operand.data();
+    const OpCode *opsPtr = this->ops.data();
+    const std::uint32_t *lhsPtr = this->lhs.data();
+    const std::uint32_t *rhsPtr = this->rhs.data();
+    const std::uint32_t *argsPtr = this->args.data();
+
+    // Pick up any changes made to the parameters since the last pass
+    for (const auto &[index, param]: this->bindings) {
+        dataPtr[index] = param.get_data();
+    }
+
+    // Children always come before their parents, so one pass in order suffices
+    const std::size_t count = this->ops.size();
+    for (std::size_t idx = 0; idx < count; ++idx) {
+        switch (opsPtr[idx]) {
+            case OpCode::Leaf:
+                break;
+            case OpCode::Add:
+                dataPtr[idx] = dataPtr[lhsPtr[idx]] + dataPtr[rhsPtr[idx]];
+                break;
+            case OpCode::Mul:
+                dataPtr[idx] = dataPtr[lhsPtr[idx]] * dataPtr[rhsPtr[idx]];
+                break;
+            case OpCode::Pow:
+                dataPtr[idx] = std::pow(dataPtr[lhsPtr[idx]], operandPtr[idx]);
+                break;
+            case OpCode::ReLU:
+                dataPtr[idx] = dataPtr[lhsPtr[idx]] < 0. ? 0. : dataPtr[lhsPtr[idx]];
+                break;
+            case OpCode::Sub:
+                dataPtr[idx] = dataPtr[lhsPtr[idx]] - dataPtr[rhsPtr[idx]];
+                break;
+            case OpCode::Dot: {
+                const std::uint32_t *pairs = argsPtr + lhsPtr[idx];
+                double sum = operandPtr[idx];
+                for (std::uint32_t term = 0; term < rhsPtr[idx]; ++term) {
+                    sum += dataPtr[pairs[2 * term]] * dataPtr[pairs[2 * term + 1]];
+                }
+                dataPtr[idx] = sum;
+                break;
+            }
+        }
+    }
+}
+
+void Tape::optimize(const std::span<TapeValue> inputs, const std::span<TapeValue> outputs) {
+    for (const auto &handles: {inputs, outputs}) {
+        for (const auto &handle: handles) {
+            if (handle.get_tape() != this) {
+                throw std::runtime_error("Tape::optimize: node was recorded on a different tape");
+            }
+        }
+    }
+    const std::size_t count = this->ops.size();
+
+    // Calls visit with the index of each child of a node
+    const auto forEachChild = [this](const std::size_t idx, const auto &visit) {
+        switch (this->ops[idx]) {
+            case OpCode::Leaf:
+                break;
+            case OpCode::Pow:
+            case OpCode::ReLU:
+                visit(this->lhs[idx]);
+                break;
+            case OpCode::Add:
+            case OpCode::Mul:
+            case OpCode::Sub:
+                visit(this->lhs[idx]);
+                visit(this->rhs[idx]);
+                break;
+            case OpCode::Dot:
+                for (std::uint32_t arg = 0; arg < 2 * this->rhs[idx]; ++arg) {
+                    visit(this->args[this->lhs[idx] + arg]);
+                }
+                break;
+        }
+    };
+
+    // Leaves whose data can change between replays, every other leaf is a constant
+    std::vector<std::uint8_t> isInput(count, 0);
+    std::vector<std::uint8_t> variable(count, 0);
+    for (const auto &input: inputs) {
+        isInput[input.get_index()] = 1;
+        variable[input.get_index()] = 1;
+    }
+    for (const auto &[index, param]: this->bindings) {
+        variable[index] = 1;
+    }
+
+    // A node only depending on constants is a constant too, and since the
+    // constants never change, the data it was recorded with is its value
+    std::vector<std::uint8_t> constant(count, 0);
+    for (std::size_t idx = 0; idx < count; ++idx) {
+        bool allConstant = this->ops[idx] != OpCode::Leaf || !variable[idx];
+        forEachChild(idx, [&](const std::uint32_t child) { allConstant = allConstant && constant[child]; });
+        constant[idx] = allConstant;
+    }
+
+    // Find the nodes the outputs depend on, counting how often each is used
+    // (and by which node, for the nodes only used once)
+    std::vector<std::uint8_t> live(count, 0);
+    std::vector<std::uint32_t> uses(count, 0);
+    std::vector<std::uint32_t> user(count, 0);
+    for (const auto &output: outputs) {
+        live[output.get_index()] = 1;
+        // Outputs must stay nodes of their own
+        uses[output.get_index()] += 2;
+    }
+    for (std::size_t idx = count; idx-- > 0;) {
+        if (!live[idx] || constant[idx]) {
+            continue;
+        }
+        forEachChild(idx, [&](const std::uint32_t child) {
+            live[child] = 1;
+            ++uses[child];
+            user[child] = static_cast<std::uint32_t>(idx);
+        });
+    }
+    // Sums and products only used by a sum are merged into it
+    const auto absorbed = [&](const std::uint32_t idx) {
+        return !constant[idx] && (this->ops[idx] == OpCode::Add || this->ops[idx] == OpCode::Mul) &&
+               uses[idx] == 1 && this->ops[user[idx]] == OpCode::Add;
+    };
+
+    // Record the rewritten tape, in the same (topological) order
+    std::vector<double> newData, newOperand;
+    std::vector<OpCode> newOps;
+    std::vector<std::uint32_t> newLhs, newRhs, newArgs;
+    constexpr std::uint32_t unmapped = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> remap(count, unmapped);
+    const auto emit = [&](const OpCode op, const double data, const std::uint32_t a, const std::uint32_t b,
+                          const double operand) {
+        const auto index = static_cast<std::uint32_t>(newOps.size());
+        newData.push_back(data);
+        newOperand.push_back(operand);
+        newOps.push_back(op);
+        // Leaves refer to themselves
+        newLhs.push_back(op == OpCode::Leaf ? index : a);
+        newRhs.push_back(op == OpCode::Leaf ? index : b);
+        return index;
+    };
+    // Constants are only recorded once something needs them as a leaf
+    const auto ref = [&](const std::uint32_t idx) {
+        if (remap[idx] == unmapped) {
+            remap[idx] = emit(OpCode::Leaf, this->data[idx], 0, 0, 0.);
+        }
+        return remap[idx];
+    };
+    std::uint32_t unit = unmapped;
+
+    std::vector<std::uint32_t> stack;
+    std::vector<std::uint32_t> terms;
+    for (std::size_t pos = 0; pos < count; ++pos) {
+        const auto idx = static_cast<std::uint32_t>(pos);
+        // Inputs are kept even if nothing uses them, since they are still set by the caller
+        if ((!live[idx] && !isInput[idx]) || constant[idx] || absorbed(idx)) {
+            continue;
+        }
+        const std::uint32_t a = this->lhs[idx];
+        const std::uint32_t b = this->rhs[idx];
+        switch (this->ops[idx]) {
+            case OpCode::Leaf:
+                remap[idx] = emit(OpCode::Leaf, this->data[idx], 0, 0, 0.);
+                break;
+            case OpCode::Add: {
+                // Flatten the chain of sums into its terms, left to right
+                double constantSum = 0.;
+                terms.clear();
+                stack.assign({b, a});
+                while (!stack.empty()) {
+                    const std::uint32_t term = stack.back();
+                    stack.pop_back();
+                    if (constant[term]) {
+                        constantSum += this->data[term];
+                    } else if (absorbed(term) && this->ops[term] == OpCode::Add) {
+                        stack.push_back(this->rhs[term]);
+                        stack.push_back(this->lhs[term]);
+                    } else {
+                        terms.push_back(term);
+                    }
+                }
+                const auto isProduct = [&](const std::uint32_t term) {
+                    return absorbed(term) && this->ops[term] == OpCode::Mul;
+                };
+                if (terms.size() == 2 && constantSum == 0. && !isProduct(terms[0]) && !isProduct(terms[1])) {
+                    remap[idx] = emit(OpCode::Add, this->data[idx], ref(terms[0]), ref(terms[1]), 0.);
+                    break;
+                }
+                // a + (-1 * b), in either order, is a - b
+                if (terms.size() == 2 && constantSum == 0. && isProduct(terms[0]) != isProduct(terms[1])) {
+                    const std::uint32_t product = isProduct(terms[0]) ? terms[0] : terms[1];
+                    const std::uint32_t other = isProduct(terms[0]) ? terms[1] : terms[0];
+                    const std::uint32_t factorA = this->lhs[product];
+                    const std::uint32_t factorB = this->rhs[product];
+                    const bool negatesA = constant[factorB] && this->data[factorB] == -1.;
+                    if (negatesA || (constant[factorA] && this->data[factorA] == -1.)) {
+                        remap[idx] = emit(OpCode::Sub, this->data[idx], ref(other), ref(negatesA ? factorA : factorB),
+                                          0.);
+                        break;
+                    }
+                }
+                const auto offset = static_cast<std::uint32_t>(newArgs.size());
+                for (const std::uint32_t term: terms) {
+                    if (isProduct(term)) {
+                        newArgs.push_back(ref(this->lhs[term]));
+                        newArgs.push_back(ref(this->rhs[term]));
+                    } else {
+                        // Single terms are multiplied by a leaf holding 1
+                        if (unit == unmapped) {
+                            unit = emit(OpCode::Leaf, 1.0, 0, 0, 0.);
+                        }
+                        newArgs.push_back(ref(term));
+                        newArgs.push_back(unit);
+                    }
+                }
+                remap[idx] = emit(OpCode::Dot, this->data[idx], offset, static_cast<std::uint32_t>(terms.size()),
+                                  constantSum);
+                break;
+            }
+            case OpCode::Mul:
+            case OpCode::Sub:
+                remap[idx] = emit(this->ops[idx], this->data[idx], ref(a), ref(b), 0.);
+                break;
+            case OpCode::Pow:
+            case OpCode::ReLU: {
+                const std::uint32_t child = ref(a);
+                remap[idx] = emit(this->ops[idx], this->data[idx], child, child, this->operand[idx]);
+                break;
+            }
+            case OpCode::Dot: {
+                // Already fused, only its arguments need renumbering
+                const auto offset = static_cast<std::uint32_t>(newArgs.size());
+                for (std::uint32_t arg = 0; arg < 2 * b; ++arg) {
+                    newArgs.push_back(ref(this->args[a + arg]));
+                }
+                remap[idx] = emit(OpCode::Dot, this->data[idx], offset, b, this->operand[idx]);
+                break;
+            }
+        }
+    }
+
+    // Outputs can be constants, which haven't been needed as a leaf yet
+    for (auto &output: outputs) {
+        output = TapeValue{this, ref(output.get_index())};
+    }
+    for (auto &input: inputs) {
+        input = TapeValue{this, remap[input.get_index()]};
+    }
+    std::vector<std::pair<std::uint32_t, Value> > newBindings;
+    for (auto &[index, param]: this->bindings) {
+        if (remap[index] != unmapped) {
+            newBindings.emplace_back(remap[index], std::move(param));
+        }
+    }
+
+    this->data = std::move(newData);
+    this->grad.assign(this->data.size(), 0.);
+    this->operand = std::move(newOperand);
+    this->ops = std::move(newOps);
+    this->lhs = std::move(newLhs);
+    this->rhs = std::move(newRhs);
+    this->args = std::move(newArgs);
+    this->bindings = std::move(newBindings);
+}
+
+void Tape::clear() {
+    // The node arrays only hold trivial types, so this just resets their sizes
+    this->data.clear();
+    this->grad.clear();
+    this->operand.clear();
+    this->ops.clear();
+    this->lhs.clear();
+    this->rhs.clear();
+    this->args.clear();
+    this->bindings.clear();
+}
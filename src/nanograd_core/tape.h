@@ -0,0 +1,453 @@
+#pragma once
+// Standard Library Includes
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Local Includes
+#include "engine.h"
+
+// External Includes
+
+class Tape;
+
+/**
+ * @brief Lightweight handle to a node recorded on a Tape.
+ *
+ * A TapeValue is only an index into the Tape which recorded it, so copying
+ * it is free and creating one never allocates. The handle is only valid
+ * until the owning Tape is cleared or destroyed.
+ */
+class TapeValue {
+  /**
+   * @brief Tape which owns the node.
+   */
+  Tape *tape;
+  /**
+   * @brief Index of the node on the tape.
+   */
+  std::uint32_t index;
+
+public:
+  /**
+   * @brief Construct a new handle to a node on a Tape.
+   *
+   * @param tape Tape owning the node.
+   * @param index Index of the node on the tape.
+   */
+  TapeValue(Tape *tape, const std::uint32_t index) : tape(tape), index(index) {
+  }
+
+  // region Access
+  /**
+   * @brief Get the Tape which owns this node.
+   * @return Pointer to the owning Tape
+   */
+  [[nodiscard]] Tape *get_tape() const {
+    return this->tape;
+  }
+
+  /**
+   * @brief Get the index of the node on its Tape.
+   * @return Index of the node
+   */
+  [[nodiscard]] std::uint32_t get_index() const {
+    return this->index;
+  }
+
+  /**
+   * @brief Get the current value of the gradient
+   * @return Current value of the gradient
+   */
+  [[nodiscard]] double get_grad() const;
+
+  /**
+   * @brief Set the value of the gradient
+   * @param grad New value of the gradient
+   */
+  void set_grad(double grad) const;
+
+  /**
+   * @brief Get the current value of data
+   * @return Current value of data
+   */
+  [[nodiscard]] double get_data() const;
+
+  /**
+   * @brief Set the value of data.
+   * @param data New value for underlying data value.
+   */
+  void set_data(double data) const;
+
+  /**
+   * @brief Set the value of grad to 0.
+   */
+  void zero_grad() const;
+
+  // endregion Access
+  // region Operators
+
+  friend TapeValue operator+(const TapeValue &lhs, const TapeValue &rhs);
+
+  friend TapeValue operator+(const TapeValue &lhs, double rhs);
+
+  friend TapeValue operator+(double lhs, const TapeValue &rhs);
+
+  friend TapeValue operator*(const TapeValue &lhs, const TapeValue &rhs);
+
+  friend TapeValue operator*(const TapeValue &lhs, double rhs);
+
+  friend TapeValue operator*(double lhs, const TapeValue &rhs);
+
+  /**
+   * @brief Raise a TapeValue to an exponent.
+   *
+   * @param other Double representing the exponent
+   * @return TapeValue representing the previous value raised to the power of other
+   */
+  [[nodiscard]] TapeValue pow(double other) const;
+
+  /**
+   * @brief Calculate a Rectified Linear Unit (ReLU) applied to the TapeValue.
+   *
+   * @return TapeValue representing the value after passing through the ReLU operation
+   */
+  [[nodiscard]] TapeValue relu() const;
+
+  friend TapeValue operator-(const TapeValue &val) {
+    return val * -1.;
+  }
+
+  friend TapeValue operator-(const TapeValue &lhs, const TapeValue &rhs) {
+    return lhs + (-rhs);
+  }
+
+  friend TapeValue operator-(const TapeValue &lhs, const double rhs) {
+    return lhs + (-rhs);
+  }
+
+  friend TapeValue operator-(const double lhs, const TapeValue &rhs) {
+    return lhs + (-rhs);
+  }
+
+  friend TapeValue operator/(const TapeValue &lhs, const TapeValue &rhs) {
+    return lhs * rhs.pow(-1.0);
+  }
+
+  friend TapeValue operator/(const TapeValue &lhs, const double rhs) {
+    return lhs * (1.0 / rhs);
+  }
+
+  friend TapeValue operator/(const double lhs, const TapeValue &rhs) {
+    return lhs * rhs.pow(-1.0);
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const TapeValue &val);
+
+  /**
+   * @brief Get a string representation of the TapeValue.
+   * @return String representing the TapeValue
+   */
+  [[nodiscard]] std::string as_string() const;
+
+  // endregion Operators
+
+  // region backpropagation
+
+  /**
+   * @brief Compute the gradients of every node on the tape with respect to this one.
+   */
+  void backwards() const;
+
+  // endregion backpropagation
+};
+
+/**
+ * @brief Operation which produced a node on a Tape.
+ */
+enum class OpCode : std::uint8_t {
+  Leaf,
+  Add,
+  Mul,
+  Pow,
+  ReLU,
+  /**
+   * @brief Difference of the first and second child.
+   */
+  Sub,
+  /**
+   * @brief Sum of products of pairs of nodes plus a constant, only created by Tape::optimize.
+   *
+   * The pairs are stored in the argument list of the tape, starting at the
+   * index held as the first child, and the number of pairs is held as the
+   * second child.
+   */
+  Dot,
+};
+
+/**
+ * @brief Graph context storing every node of an expression in one contiguous arena.
+ *
+ * Operations on TapeValues append a node to the end of the tape instead of
+ * allocating it on the heap, so recording an expression costs one bump of the
+ * arena per node. Since nodes are appended after their children, the tape is
+ * always in topological order and backpropagation is a single reverse sweep.
+ * Calling clear() releases every node at once while keeping the arena's
+ * memory around for the next expression.
+ */
+class Tape {
+  // Each node is stored as one entry in each of the arrays below (a
+  // struct-of-arrays layout), so the backwards sweep streams through dense
+  // arrays and dispatches on the opcode instead of calling through a pointer.
+
+  /**
+   * @brief Data associated with each node.
+   */
+  std::vector<double> data;
+  /**
+   * @brief Current derivative of each node.
+   */
+  std::vector<double> grad;
+  /**
+   * @brief Constant operand of each node's operation (the exponent for pow).
+   */
+  std::vector<double> operand;
+  /**
+   * @brief Operation which produced each node.
+   */
+  std::vector<OpCode> ops;
+  /**
+   * @brief Index of the first child of each node.
+   */
+  std::vector<std::uint32_t> lhs;
+  /**
+   * @brief Index of the second child of each node.
+   */
+  std::vector<std::uint32_t> rhs;
+  /**
+   * @brief Argument lists of the n-ary nodes, two indices per product.
+   */
+  std::vector<std::uint32_t> args;
+  /**
+   * @brief Leaves of the tape which mirror a Value, paired with that Value.
+   */
+  std::vector<std::pair<std::uint32_t, Value> > bindings;
+
+  /**
+   * @brief Append a node to the tape.
+   *
+   * @param op Operation which produced the node.
+   * @param data Data of the new node.
+   * @param lhs Index of the first child of the node.
+   * @param rhs Index of the second child of the node.
+   * @param operand Constant operand of the operation.
+   * @return TapeValue referring to the new node
+   */
+  TapeValue push(OpCode op, double data, std::uint32_t lhs, std::uint32_t rhs, double operand);
+
+  /**
+   * @brief Propagate the gradients already seeded on the tape back to its leaves.
+   *
+   * @param last Index of the last node which can hold a non-zero gradient.
+   */
+  void backwardsSweep(std::uint32_t last);
+
+  friend class TapeValue;
+
+  friend TapeValue operator+(const TapeValue &lhs, const TapeValue &rhs);
+
+  friend TapeValue operator*(const TapeValue &lhs, const TapeValue &rhs);
+
+public:
+  /**
+   * @brief Construct a new Tape.
+   *
+   * @param capacity Number of nodes to reserve space for up front.
+   */
+  explicit Tape(std::size_t capacity = 0);
+
+  // TapeValues refer back to their Tape, so it can't be copied or moved
+  Tape(const Tape &) = delete;
+
+  Tape &operator=(const Tape &) = delete;
+
+  /**
+   * @brief Record a new leaf on the tape.
+   *
+   * @param data Data of the new leaf.
+   * @return TapeValue referring to the new leaf
+   */
+  TapeValue value(double data);
+
+  /**
+   * @brief Record a leaf on the tape mirroring a Value.
+   *
+   * The leaf takes the current data of the Value, and backwards() adds the
+   * gradient found for the leaf into the Value's gradient, so parameters stored
+   * as Values can be trained through a Tape.
+   *
+   * @param param Value mirrored by the new leaf.
+   * @return TapeValue referring to the new leaf
+   */
+  TapeValue parameter(const Value &param);
+
+  /**
+   * @brief Compute the gradients of every node on the tape with respect to root.
+   *
+   * Gradients of nodes on the tape are recomputed from scratch by each call,
+   * while the gradients of the Values bound with parameter() accumulate.
+   *
+   * @param root Node to differentiate.
+   */
+  void backwards(const TapeValue &root);
+
+  /**
+   * @brief Compute the gradients of every node on the tape with respect to a
+   * weighted sum of several roots (a vector-Jacobian product).
+   *
+   * @param roots Nodes to differentiate.
+   * @param seeds Gradient of the final result with respect to each root.
+   */
+  void backwards(std::span<const TapeValue> roots, std::span<const double> seeds);
+
+  /**
+   * @brief Recompute the data of every node on the tape from its leaves.
+   *
+   * Leaves bound with parameter() first take the current data of their Value,
+   * so after changing the data of the leaves (or of the parameters) the whole
+   * recorded expression can be replayed without recording it again.
+   */
+  void forward();
+
+  /**
+   * @brief Rewrite the tape into an equivalent one with fewer nodes.
+   *
+   * Recording an expression node by node leaves long chains of scalar
+   * operations, which this pass rewrites before the tape is replayed:
+   *   - nodes which only depend on constant leaves are folded into a constant,
+   *   - chains of additions of products (such as the weighted sum of a neuron)
+   *     which aren't used anywhere else become a single Dot node,
+   *   - a + (-b) becomes a single Sub node,
+   *   - nodes which no output depends on are dropped.
+   * Leaves which are neither inputs nor bound with parameter() are treated as
+   * constants. All other TapeValues referring to this tape become invalid.
+   *
+   * @param inputs Leaves whose data may change before the next forward(),
+   *     updated to refer to the same leaves on the rewritten tape.
+   * @param outputs Nodes whose data and gradients are needed afterwards,
+   *     updated to refer to the same nodes on the rewritten tape.
+   */
+  void optimize(std::span<TapeValue> inputs, std::span<TapeValue> outputs);
+
+  /**
+   * @brief Release every node on the tape, keeping the memory for reuse.
+   *
+   * All TapeValues referring to this tape become invalid.
+   */
+  void clear();
+
+  /**
+   * @brief Get the number of nodes on the tape.
+   * @return Number of recorded nodes
+   */
+  [[nodiscard]] std::size_t size() const {
+    return this->ops.size();
+  }
+
+  /**
+   * @brief Get the number of nodes the tape can hold without growing.
+   * @return Capacity of the tape, in nodes
+   */
+  [[nodiscard]] std::size_t capacity() const {
+    return this->ops.capacity();
+  }
+};
+
+// region TapeValue inline definitions
+
+inline double TapeValue::get_grad() const {
+  return this->tape->grad[this->index];
+}
+
+inline void TapeValue::set_grad(const double grad) const {
+  this->tape->grad[this->index] = grad;
+}
+
+inline double TapeValue::get_data() const {
+  return this->tape->data[this->index];
+}
+
+inline void TapeValue::set_data(const double data) const {
+  this->tape->data[this->index] = data;
+}
+
+inline void TapeValue::zero_grad() const {
+  this->tape->grad[this->index] = 0.0;
+}
+
+inline TapeValue Tape::push(const OpCode op, const double data, const std::uint32_t lhs,
+                            const std::uint32_t rhs, const double operand) {
+  const auto index = static_cast<std::uint32_t>(this->ops.size());
+  this->data.push_back(data);
+  this->grad.push_back(0.);
+  this->operand.push_back(operand);
+  this->ops.push_back(op);
+  this->lhs.push_back(lhs);
+  this->rhs.push_back(rhs);
+  return TapeValue{this, index};
+}
+
+/**
+ * @brief Add two TapeValues.
+ *
+ * @param lhs TapeValue on the left hand side of the addition
+ * @param rhs TapeValue on the right hand side of the addition
+ * @return TapeValue representing the two previous values being added
+ */
+inline TapeValue operator+(const TapeValue &lhs, const TapeValue &rhs) {
+  if (lhs.tape != rhs.tape) {
+    throw std::runtime_error("TapeValue::operator+: operands were recorded on different tapes");
+  }
+  Tape *tape = lhs.tape;
+  return tape->push(OpCode::Add, tape->data[lhs.index] + tape->data[rhs.index],
+                    lhs.index, rhs.index, 0.);
+}
+
+inline TapeValue operator+(const TapeValue &lhs, const double rhs) {
+  return lhs + lhs.tape->value(rhs);
+}
+
+inline TapeValue operator+(const double lhs, const TapeValue &rhs) {
+  return rhs.tape->value(lhs) + rhs;
+}
+
+/**
+ * @brief Multiply two TapeValues.
+ *
+ * @param lhs TapeValue on the left hand side of the multiplication
+ * @param rhs TapeValue on the right hand side of the multiplication
+ * @return TapeValue representing the two previous values being multiplied
+ */
+inline TapeValue operator*(const TapeValue &lhs, const TapeValue &rhs) {
+  if (lhs.tape != rhs.tape) {
+    throw std::runtime_error("TapeValue::operator*: operands were recorded on different tapes");
+  }
+  Tape *tape = lhs.tape;
+  return tape->push(OpCode::Mul, tape->data[lhs.index] * tape->data[rhs.index],
+                    lhs.index, rhs.index, 0.);
+}
+
+inline TapeValue operator*(const TapeValue &lhs, const double rhs) {
+  return lhs * lhs.tape->value(rhs);
+}
+
+inline TapeValue operator*(const double lhs, const TapeValue &rhs) {
+  return rhs.tape->value(lhs) * rhs;
+}
+
+// endregion TapeValue inline definitions
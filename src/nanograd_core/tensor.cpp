@@ -0,0 +1,503 @@
+#include "tensor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+
+#include "kernels.h"
+
+namespace {
+    std::string shapeString(const std::vector<std::size_t> &shape) {
+        std::string out = "(";
+        for (std::size_t idx = 0; idx < shape.size(); ++idx) {
+            out += std::to_string(shape[idx]);
+            if (idx + 1 < shape.size()) {
+                out += ", ";
+            }
+        }
+        return out + ")";
+    }
+
+    std::size_t shapeSize(const std::vector<std::size_t> &shape) {
+        if (shape.empty() || shape.size() > 2) {
+            throw std::runtime_error("Tensor: only 1-D and 2-D tensors are supported, got shape " +
+                                     shapeString(shape));
+        }
+        std::size_t size = 1;
+        for (const std::size_t dim: shape) {
+            size *= dim;
+        }
+        return size;
+    }
+}
+
+template<typename T>
+BasicInternalTensor<T>::BasicInternalTensor(std::vector<std::size_t> shape, std::vector<T> data,
+                                            std::vector<std::shared_ptr<BasicInternalTensor> > children,
+                                            std::function<void()> backwardsInternal, std::string operation)
+    : shape(std::move(shape)), localData(std::move(data)), localGrad(this->localData.size(), 0.),
+      backwardsInternal(std::move(backwardsInternal)), children(std::move(children)),
+      operation(std::move(operation)) {
+    this->data = this->localData;
+    this->grad = this->localGrad;
+    if (Profiler::is_enabled()) [[unlikely]] {
+        Profiler::recordNode(sizeof(BasicInternalTensor) +
+                             (this->localData.capacity() + this->localGrad.capacity()) * sizeof(T) +
+                             this->children.capacity() * sizeof(this->children[0]) +
+                             Profiler::heapBytesOf(this->operation), "Tensor leaf");
+    }
+}
+
+template<typename T>
+BasicInternalTensor<T>::~BasicInternalTensor() {
+    // Release long chains of children in a loop rather than through nested destructors
+    std::vector<std::shared_ptr<BasicInternalTensor<T> > > pending = std::move(this->children);
+    while (!pending.empty()) {
+        std::shared_ptr<BasicInternalTensor<T> > node = std::move(pending.back());
+        pending.pop_back();
+        if (node.use_count() == 1) {
+            std::ranges::move(node->children, std::back_inserter(pending));
+            node->children.clear();
+        }
+    }
+}
+
+template<typename T>
+void BasicInternalTensor<T>::release() {
+    if (this->children.empty()) {
+        return;
+    }
+    this->backwardsInternal = []() {
+    };
+    this->children.clear();
+}
+
+template<typename T>
+std::shared_ptr<BasicInternalTensor<T> > BasicInternalTensor<T>::viewOf(std::vector<std::size_t> shape, T *data,
+                                                                        T *grad, std::shared_ptr<void> storage) {
+    auto out = std::make_shared<BasicInternalTensor>(std::move(shape), std::vector<T>{},
+                                                     std::vector<std::shared_ptr<BasicInternalTensor> >{},
+                                                     []() {
+                                                     }, std::string{});
+    std::size_t size = 1;
+    for (const std::size_t dim: out->shape) {
+        size *= dim;
+    }
+    out->data = std::span<T>{data, size};
+    if (grad != nullptr) {
+        out->grad = std::span<T>{grad, size};
+    } else {
+        out->localGrad.assign(size, 0.);
+        out->grad = out->localGrad;
+    }
+    out->storage = std::move(storage);
+    return out;
+}
+
+template<typename T>
+std::atomic<std::uint64_t> BasicTensor<T>::traversalEpoch{0};
+
+template<typename T>
+BasicTensor<T>::BasicTensor(std::vector<std::size_t> shape, std::vector<T> data) {
+    if (shapeSize(shape) != data.size()) {
+        throw std::runtime_error("Tensor::Tensor: shape " + shapeString(shape) + " needs " +
+                                 std::to_string(shapeSize(shape)) + " elements but data is of size " +
+                                 std::to_string(data.size()));
+    }
+    this->val = std::make_shared<BasicInternalTensor<T> >(std::move(shape), std::move(data),
+                                                          std::vector<std::shared_ptr<BasicInternalTensor<T> > >{},
+                                                          []() {
+                                                          }, std::string{});
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::zeros(std::vector<std::size_t> shape) {
+    const std::size_t size = shapeSize(shape);
+    return BasicTensor{std::move(shape), std::vector<T>(size, 0.)};
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::view(std::vector<std::size_t> shape, T *data, std::shared_ptr<void> storage) {
+    shapeSize(shape);
+    return BasicTensor{BasicInternalTensor<T>::viewOf(std::move(shape), data, nullptr, std::move(storage))};
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::view(std::vector<std::size_t> shape, T *data, T *grad, std::shared_ptr<void> storage) {
+    shapeSize(shape);
+    return BasicTensor{BasicInternalTensor<T>::viewOf(std::move(shape), data, grad, std::move(storage))};
+}
+
+template<typename T>
+Value BasicTensor<T>::element(const std::size_t index) const requires std::same_as<T, double> {
+    if (index >= this->size()) {
+        throw std::runtime_error("Tensor::element: index " + std::to_string(index) +
+                                 " is out of range for a tensor of size " + std::to_string(this->size()));
+    }
+    return Value::view(this->val->data.data() + index, this->val->grad.data() + index, this->val);
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::share_data() const {
+    return BasicTensor{BasicInternalTensor<T>::viewOf(this->val->shape, this->val->data.data(), nullptr, this->val)};
+}
+
+template<typename T>
+void BasicTensor<T>::zero_grad() const {
+    std::ranges::fill(this->val->grad, 0.);
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::add(const BasicTensor &lhs, const BasicTensor &rhs) {
+    const Profiler::Operation profile{"Tensor +"};
+    const auto &lhsShape = lhs.val->shape;
+    const auto &rhsShape = rhs.val->shape;
+    if (lhsShape != rhsShape) {
+        // A vector can be added to every row of a matrix, on either side
+        if (lhsShape.size() == 1 && rhsShape.size() == 2) {
+            return rhs + lhs;
+        }
+        if (!(lhsShape.size() == 2 && rhsShape.size() == 1 && lhsShape[1] == rhsShape[0])) {
+            throw std::runtime_error("Tensor::operator+: mismatched shapes " + shapeString(lhsShape) +
+                                     " and " + shapeString(rhsShape));
+        }
+    }
+
+    const std::size_t size = lhs.size();
+    const std::size_t cols = rhs.size();
+    std::vector<T> data(size);
+    for (std::size_t offset = 0; cols > 0 && offset < size; offset += cols) {
+        kernels::add(lhs.val->data.data() + offset, rhs.val->data.data(), data.data() + offset, cols);
+    }
+    if (!NoGradGuard::is_grad_enabled()) {
+        return BasicTensor{lhsShape, std::move(data)};
+    }
+    const auto resInternalTensor = std::make_shared<BasicInternalTensor<T> >(
+        lhsShape, std::move(data), std::vector<std::shared_ptr<BasicInternalTensor<T> > >{lhs.val, rhs.val},
+        []() {
+        }, std::string{"+"});
+
+    // The children are kept alive by the node, and the node owns the lambda,
+    // so plain pointers are enough (and avoid a reference cycle)
+    BasicInternalTensor<T> *lhsInt = lhs.val.get();
+    BasicInternalTensor<T> *rhsInt = rhs.val.get();
+    BasicInternalTensor<T> *outInt = resInternalTensor.get();
+    resInternalTensor->backwardsInternal = [=]() -> void {
+        kernels::axpy(1.0, outInt->grad.data(), lhsInt->grad.data(), size);
+        // Broadcast vectors collect the gradient of every row
+        for (std::size_t offset = 0; cols > 0 && offset < size; offset += cols) {
+            kernels::axpy(1.0, outInt->grad.data() + offset, rhsInt->grad.data(), cols);
+        }
+    };
+
+    return BasicTensor{resInternalTensor};
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::multiply(const BasicTensor &lhs, const BasicTensor &rhs) {
+    const Profiler::Operation profile{"Tensor *"};
+    if (lhs.val->shape != rhs.val->shape) {
+        throw std::runtime_error("Tensor::operator*: mismatched shapes " + shapeString(lhs.val->shape) +
+                                 " and " + shapeString(rhs.val->shape));
+    }
+    const std::size_t size = lhs.size();
+    std::vector<T> data(size);
+    kernels::mul(lhs.val->data.data(), rhs.val->data.data(), data.data(), size);
+    if (!NoGradGuard::is_grad_enabled()) {
+        return BasicTensor{lhs.val->shape, std::move(data)};
+    }
+    const auto resInternalTensor = std::make_shared<BasicInternalTensor<T> >(
+        lhs.val->shape, std::move(data), std::vector<std::shared_ptr<BasicInternalTensor<T> > >{lhs.val, rhs.val},
+        []() {
+        }, std::string{"*"});
+
+    BasicInternalTensor<T> *lhsInt = lhs.val.get();
+    BasicInternalTensor<T> *rhsInt = rhs.val.get();
+    BasicInternalTensor<T> *outInt = resInternalTensor.get();
+    resInternalTensor->backwardsInternal = [=]() -> void {
+        kernels::mulAdd(outInt->grad.data(), rhsInt->data.data(), lhsInt->grad.data(), size);
+        kernels::mulAdd(outInt->grad.data(), lhsInt->data.data(), rhsInt->grad.data(), size);
+    };
+
+    return BasicTensor{resInternalTensor};
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::matmul(const BasicTensor &other) const {
+    const Profiler::Operation profile{"Tensor @"};
+    const auto &lhsShape = this->val->shape;
+    const auto &rhsShape = other.val->shape;
+    if (lhsShape.size() != 2 || lhsShape[1] != rhsShape[0]) {
+        throw std::runtime_error("Tensor::matmul: mismatched shapes " + shapeString(lhsShape) +
+                                 " and " + shapeString(rhsShape));
+    }
+    const std::size_t m = lhsShape[0];
+    const std::size_t k = lhsShape[1];
+    BasicInternalTensor<T> *lhsInt = this->val.get();
+    BasicInternalTensor<T> *rhsInt = other.val.get();
+
+    if (rhsShape.size() == 1) {
+        // Matrix-vector product
+        std::vector<T> data(m, 0.);
+        kernels::gemv(m, k, lhsInt->data.data(), rhsInt->data.data(), data.data());
+        if (!NoGradGuard::is_grad_enabled()) {
+            return BasicTensor{{m}, std::move(data)};
+        }
+        const auto resInternalTensor = std::make_shared<BasicInternalTensor<T> >(
+            std::vector<std::size_t>{m}, std::move(data),
+            std::vector<std::shared_ptr<BasicInternalTensor<T> > >{this->val, other.val},
+            []() {
+            }, std::string{"@"});
+
+        BasicInternalTensor<T> *outInt = resInternalTensor.get();
+        resInternalTensor->backwardsInternal = [=]() -> void {
+            kernels::ger(m, k, outInt->grad.data(), rhsInt->data.data(), lhsInt->grad.data());
+            kernels::gemvT(m, k, lhsInt->data.data(), outInt->grad.data(), rhsInt->grad.data());
+        };
+        return BasicTensor{resInternalTensor};
+    }
+
+    // Matrix-matrix product
+    const std::size_t n = rhsShape[1];
+    std::vector<T> data(m * n, 0.);
+    kernels::gemmNN(m, n, k, lhsInt->data.data(), rhsInt->data.data(), data.data());
+    if (!NoGradGuard::is_grad_enabled()) {
+        return BasicTensor{{m, n}, std::move(data)};
+    }
+    const auto resInternalTensor = std::make_shared<BasicInternalTensor<T> >(
+        std::vector<std::size_t>{m, n}, std::move(data),
+        std::vector<std::shared_ptr<BasicInternalTensor<T> > >{this->val, other.val},
+        []() {
+        }, std::string{"@"});
+
+    BasicInternalTensor<T> *outInt = resInternalTensor.get();
+    resInternalTensor->backwardsInternal = [=]() -> void {
+        // dL/dA = dL/dC * B^T and dL/dB = A^T * dL/dC
+        kernels::gemmNT(m, k, n, outInt->grad.data(), rhsInt->data.data(), lhsInt->grad.data());
+        kernels::gemmTN(k, n, m, lhsInt->data.data(), outInt->grad.data(), rhsInt->grad.data());
+    };
+    return BasicTensor{resInternalTensor};
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::matmul_transposed(const BasicTensor &other) const {
+    const Profiler::Operation profile{"Tensor @T"};
+    const auto &lhsShape = this->val->shape;
+    const auto &rhsShape = other.val->shape;
+    if (lhsShape.size() != 2 || rhsShape.size() != 2 || lhsShape[1] != rhsShape[1]) {
+        throw std::runtime_error("Tensor::matmul_transposed: mismatched shapes " + shapeString(lhsShape) +
+                                 " and " + shapeString(rhsShape));
+    }
+    const std::size_t m = lhsShape[0];
+    const std::size_t n = rhsShape[0];
+    const std::size_t k = lhsShape[1];
+    BasicInternalTensor<T> *lhsInt = this->val.get();
+    BasicInternalTensor<T> *rhsInt = other.val.get();
+
+    std::vector<T> data(m * n, 0.);
+    kernels::gemmNT(m, n, k, lhsInt->data.data(), rhsInt->data.data(), data.data());
+    if (!NoGradGuard::is_grad_enabled()) {
+        return BasicTensor{{m, n}, std::move(data)};
+    }
+    const auto resInternalTensor = std::make_shared<BasicInternalTensor<T> >(
+        std::vector<std::size_t>{m, n}, std::move(data),
+        std::vector<std::shared_ptr<BasicInternalTensor<T> > >{this->val, other.val},
+        []() {
+        }, std::string{"@T"});
+
+    BasicInternalTensor<T> *outInt = resInternalTensor.get();
+    resInternalTensor->backwardsInternal = [=]() -> void {
+        // C = A B^T, so dL/dA = dL/dC * B and dL/dB = (dL/dC)^T * A
+        kernels::gemmNN(m, k, n, outInt->grad.data(), rhsInt->data.data(), lhsInt->grad.data());
+        kernels::gemmTN(n, k, m, outInt->grad.data(), lhsInt->data.data(), rhsInt->grad.data());
+    };
+    return BasicTensor{resInternalTensor};
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::pow(const double other) const {
+    const Profiler::Operation profile{"Tensor pow"};
+    const std::size_t size = this->size();
+    const T exponent = static_cast<T>(other);
+    std::vector<T> data(size);
+    for (std::size_t idx = 0; idx < size; ++idx) {
+        data[idx] = std::pow(this->val->data[idx], exponent);
+    }
+    if (!NoGradGuard::is_grad_enabled()) {
+        return BasicTensor{this->val->shape, std::move(data)};
+    }
+    const auto resInternalTensor = std::make_shared<BasicInternalTensor<T> >(
+        this->val->shape, std::move(data), std::vector<std::shared_ptr<BasicInternalTensor<T> > >{this->val},
+        []() {
+        }, std::string{"**" + std::to_string(other)});
+
+    BasicInternalTensor<T> *baseInt = this->val.get();
+    BasicInternalTensor<T> *outInt = resInternalTensor.get();
+    resInternalTensor->backwardsInternal = [=]() -> void {
+        for (std::size_t idx = 0; idx < size; ++idx) {
+            baseInt->grad[idx] += (exponent * std::pow(baseInt->data[idx], exponent - 1)) * outInt->grad[idx];
+        }
+    };
+
+    return BasicTensor{resInternalTensor};
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::relu() const {
+    const Profiler::Operation profile{"Tensor ReLU"};
+    const std::size_t size = this->size();
+    std::vector<T> data(size);
+    kernels::relu(this->val->data.data(), data.data(), size);
+    if (!NoGradGuard::is_grad_enabled()) {
+        return BasicTensor{this->val->shape, std::move(data)};
+    }
+    const auto resInternalTensor = std::make_shared<BasicInternalTensor<T> >(
+        this->val->shape, std::move(data), std::vector<std::shared_ptr<BasicInternalTensor<T> > >{this->val},
+        []() {
+        }, std::string{"ReLU"});
+
+    BasicInternalTensor<T> *selfInt = this->val.get();
+    BasicInternalTensor<T> *outInt = resInternalTensor.get();
+    resInternalTensor->backwardsInternal = [=]() -> void {
+        kernels::reluBackwards(outInt->data.data(), outInt->grad.data(), selfInt->grad.data(), size);
+    };
+
+    return BasicTensor{resInternalTensor};
+}
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::sum() const {
+    const Profiler::Operation profile{"Tensor sum"};
+    const std::size_t size = this->size();
+    if (!NoGradGuard::is_grad_enabled()) {
+        return BasicTensor{{1}, {kernels::sum(this->val->data.data(), size)}};
+    }
+    const auto resInternalTensor = std::make_shared<BasicInternalTensor<T> >(
+        std::vector<std::size_t>{1}, std::vector<T>{kernels::sum(this->val->data.data(), size)},
+        std::vector<std::shared_ptr<BasicInternalTensor<T> > >{this->val},
+        []() {
+        }, std::string{"sum"});
+
+    BasicInternalTensor<T> *selfInt = this->val.get();
+    BasicInternalTensor<T> *outInt = resInternalTensor.get();
+    resInternalTensor->backwardsInternal = [=]() -> void {
+        const T outGrad = outInt->grad[0];
+        for (std::size_t idx = 0; idx < size; ++idx) {
+            selfInt->grad[idx] += outGrad;
+        }
+    };
+
+    return BasicTensor{resInternalTensor};
+}
+
+template<typename T>
+template<typename U>
+BasicTensor<U> BasicTensor<T>::cast() const {
+    const Profiler::Operation profile{"Tensor cast"};
+    const std::size_t size = this->size();
+    std::vector<U> data(size);
+    std::ranges::transform(this->val->data, data.begin(), [](const T x) { return static_cast<U>(x); });
+    if (!NoGradGuard::is_grad_enabled()) {
+        return BasicTensor<U>{this->val->shape, std::move(data)};
+    }
+    // The node can't have this Tensor as a child, since it belongs to a graph of another scalar type,
+    // so it is a leaf of its own graph which holds on to this Tensor instead
+    const auto resInternalTensor = std::make_shared<BasicInternalTensor<U> >(
+        this->val->shape, std::move(data), std::vector<std::shared_ptr<BasicInternalTensor<U> > >{},
+        []() {
+        }, std::string{"cast"});
+
+    std::shared_ptr<BasicInternalTensor<T> > source = this->val;
+    BasicInternalTensor<U> *outInt = resInternalTensor.get();
+    resInternalTensor->backwardsInternal = [source, outInt, size]() -> void {
+        for (std::size_t idx = 0; idx < size; ++idx) {
+            source->grad[idx] += static_cast<T>(outInt->grad[idx]);
+        }
+    };
+
+    return BasicTensor<U>{resInternalTensor};
+}
+
+template<typename T>
+std::string BasicTensor<T>::as_string() const {
+    return "Tensor(shape=" + shapeString(this->val->shape) + ", operation=\"" + this->val->operation + "\")";
+}
+
+template<typename T>
+void BasicTensor<T>::topoSort(const BasicTensor *root, std::vector<BasicInternalTensor<T> *> &topo,
+                              std::vector<std::shared_ptr<BasicInternalTensor<T> > > *owners) {
+    topo.clear();
+    if (owners != nullptr) {
+        owners->clear();
+    }
+    const std::uint64_t epoch = traversalEpoch.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    std::vector<std::pair<const std::shared_ptr<BasicInternalTensor<T> > *, std::size_t> > stack;
+    root->val->visitEpoch = epoch;
+    stack.emplace_back(&root->val, 0);
+    while (!stack.empty()) {
+        auto &[currentTensor, nextChild] = stack.back();
+        if (nextChild < (*currentTensor)->children.size()) {
+            const std::shared_ptr<BasicInternalTensor<T> > &child = (*currentTensor)->children[nextChild++];
+            if (child->visitEpoch != epoch) {
+                child->visitEpoch = epoch;
+                stack.emplace_back(&child, 0);
+            }
+        } else {
+            topo.push_back(currentTensor->get());
+            if (owners != nullptr) {
+                owners->push_back(*currentTensor);
+            }
+            stack.pop_back();
+        }
+    }
+}
+
+template<typename T>
+void BasicTensor<T>::backwards(const bool retainGraph) const {
+    // Seed every element, so the gradients are those of the sum of the elements
+    const std::vector<T> seeds(this->size(), T{1});
+    this->backwards(seeds, retainGraph);
+}
+
+template<typename T>
+void BasicTensor<T>::backwards(const std::span<const T> seeds, const bool retainGraph) const {
+    if (seeds.size() != this->size()) {
+        throw std::runtime_error("Tensor::backwards: mismatched size, tensor is of size " +
+                                 std::to_string(this->size()) + " and seeds is of size " +
+                                 std::to_string(seeds.size()));
+    }
+    std::vector<BasicInternalTensor<T> *> nodes;
+    // Only filled when releasing the graph, to keep the children of a released node alive until their turn
+    std::vector<std::shared_ptr<BasicInternalTensor<T> > > owners;
+    const Profiler::Span profile{"Tensor backwards", "engine"};
+    {
+        const Profiler::Span sorting{"topo sort", "engine", Profiler::Phase::TopoSort};
+        BasicTensor::topoSort(this, nodes, retainGraph ? nullptr : &owners);
+    }
+    if (Profiler::is_enabled()) [[unlikely]] {
+        Profiler::recordGraph(std::span<BasicInternalTensor<T> *const>{nodes});
+    }
+
+    std::ranges::copy(seeds, this->val->grad.begin());
+    const Profiler::Span running{"backward pass", "engine", Profiler::Phase::Backward};
+
+    for (std::size_t idx = nodes.size(); idx-- > 0;) {
+        (nodes[idx]->backwardsInternal)();
+        if (!retainGraph) {
+            nodes[idx]->release();
+            owners[idx].reset();
+        }
+    }
+}
+
+template class BasicInternalTensor<float>;
+template class BasicInternalTensor<double>;
+template class BasicTensor<float>;
+template class BasicTensor<double>;
+
+template BasicTensor<double> BasicTensor<float>::cast<double>() const;
+template BasicTensor<float> BasicTensor<double>::cast<float>() const;
@@ -0,0 +1,432 @@
+#pragma once
+// Standard Library Includes
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+// Local Includes
+#include "engine.h"
+
+// External Includes
+
+/**
+ * @brief Represents a dense 1-D or 2-D array of values and its gradient
+ *
+ * @tparam T Scalar type of the elements, float or double.
+ */
+template<typename T>
+class BasicInternalTensor {
+public:
+  /**
+   * @brief Shape of the tensor, either {length} or {rows, columns}.
+   */
+  std::vector<std::size_t> shape;
+  /**
+   * @brief The internal data associated with the Tensor, in row-major order.
+   *
+   * Points into localData, or into a buffer owned by storage for a view of
+   * external memory.
+   */
+  std::span<T> data;
+  /**
+   * @brief The current derivative of each element of the Tensor.
+   */
+  std::span<T> grad;
+  /**
+   * @brief Buffer holding the data when it isn't viewing external memory.
+   */
+  std::vector<T> localData;
+  /**
+   * @brief Buffer holding the gradient.
+   */
+  std::vector<T> localGrad;
+  /**
+   * @brief Keeps external memory viewed by data alive, empty otherwise.
+   */
+  std::shared_ptr<void> storage;
+  /**
+   * @brief Lambda expression used for calculating the
+   * gradient during backpropagation.
+   */
+  std::function<void()> backwardsInternal;
+  /**
+   * @brief Children of the current tensor node.
+   */
+  std::vector<std::shared_ptr<BasicInternalTensor> > children;
+  /**
+   * @brief Operation that produced this node.
+   */
+  std::string operation;
+  /**
+   * @brief Epoch of the last graph traversal which visited this node.
+   */
+  std::uint64_t visitEpoch = 0;
+
+  /**
+   * @brief Construct a new Internal Tensor object
+   *
+   * @param shape Shape of the new tensor.
+   * @param data Internal data associated with the new tensor.
+   * @param children Children of the new tensor node.
+   * @param backwardsInternal Lambda expression for calculating the gradient
+   *     of the new Tensor.
+   * @param operation Operation which produced this node.
+   */
+  BasicInternalTensor(std::vector<std::size_t> shape, std::vector<T> data,
+                      std::vector<std::shared_ptr<BasicInternalTensor> > children,
+                      std::function<void()> backwardsInternal, std::string operation);
+
+  // data and grad point into the node itself, so it can't be copied
+  BasicInternalTensor(const BasicInternalTensor &) = delete;
+
+  BasicInternalTensor &operator=(const BasicInternalTensor &) = delete;
+
+  /**
+   * @brief Destroy the node, releasing the children it owns iteratively.
+   */
+  ~BasicInternalTensor();
+
+  /**
+   * @brief Drop the children and backward function of the node, turning it
+   *     into a leaf (leaves are left untouched).
+   */
+  void release();
+
+  /**
+   * @brief Create a leaf Internal Tensor viewing external memory.
+   *
+   * @param shape Shape of the new tensor.
+   * @param data Row-major data the tensor views, must hold as many elements
+   *     as the shape describes.
+   * @param grad Gradient the tensor views, or nullptr for the tensor to
+   *     store its own gradient.
+   * @param storage Owner of the data, kept alive as long as the tensor.
+   * @return Internal tensor reading and writing data directly
+   */
+  static std::shared_ptr<BasicInternalTensor> viewOf(std::vector<std::size_t> shape, T *data, T *grad,
+                                                     std::shared_ptr<void> storage);
+
+  /**
+   * @brief Get the number of elements in the tensor.
+   * @return Number of elements
+   */
+  [[nodiscard]] std::size_t size() const {
+    return this->data.size();
+  }
+};
+
+/**
+ * @brief A dense 1-D or 2-D array of values which can be used in computing gradients.
+ *
+ * A Tensor is a single node of the expression graph no matter how many
+ * elements it holds, and its operations run as vectorized kernels over whole
+ * buffers, so expressing a computation with a few Tensors instead of many
+ * Values removes most of the per-node overhead.
+ *
+ * Tensor holds doubles, like the rest of the engine. A float Tensor takes
+ * half the memory and bandwidth, and its kernels process twice as many
+ * elements per SIMD instruction, so it suits large dense computations which
+ * can afford the lower precision. Tensors of different scalar types are
+ * connected with cast.
+ *
+ * @tparam T Scalar type of the elements, float or double.
+ */
+template<typename T>
+class BasicTensor {
+  // Casts read the internal tensor of the other scalar type
+  template<typename>
+  friend class BasicTensor;
+
+  /**
+   * @brief Reference to the internal tensor.
+   */
+  std::shared_ptr<BasicInternalTensor<T> > val;
+
+  /**
+   * @brief Source of the epochs used to mark nodes visited by a traversal.
+   */
+  static std::atomic<std::uint64_t> traversalEpoch;
+
+  /**
+   * @brief Topologically sort the expression graph starting from a given root.
+   *
+   * @param root Root Tensor to start the topological sort from.
+   * @param topo Vector the nodes are written to in topological order, any
+   *     previous contents are discarded.
+   * @param owners If not null, filled with a counted reference to each node
+   *     of topo, so the nodes outlive edges dropped while walking the order.
+   */
+  static void topoSort(const BasicTensor *root, std::vector<BasicInternalTensor<T> *> &topo,
+                       std::vector<std::shared_ptr<BasicInternalTensor<T> > > *owners = nullptr);
+
+  /**
+   * @brief Add two tensors elementwise (see operator+).
+   */
+  static BasicTensor add(const BasicTensor &lhs, const BasicTensor &rhs);
+
+  /**
+   * @brief Multiply two tensors elementwise (see operator*).
+   */
+  static BasicTensor multiply(const BasicTensor &lhs, const BasicTensor &rhs);
+
+public:
+  /**
+   * @brief Construct a new Tensor object.
+   *
+   * @param val Internal tensor held by the Tensor object.
+   */
+  explicit BasicTensor(const std::shared_ptr<BasicInternalTensor<T> > &val) : val(val) {
+  }
+
+  /**
+   * @brief Construct a new Tensor from its shape and data.
+   *
+   * @param shape Shape of the tensor, either {length} or {rows, columns}.
+   * @param data Data of the tensor in row-major order, must hold as many
+   *     elements as the shape describes.
+   */
+  BasicTensor(std::vector<std::size_t> shape, std::vector<T> data);
+
+  /**
+   * @brief Create a Tensor filled with zeros.
+   *
+   * @param shape Shape of the tensor, either {length} or {rows, columns}.
+   * @return Tensor of the given shape holding only zeros
+   */
+  static BasicTensor zeros(std::vector<std::size_t> shape);
+
+  /**
+   * @brief Create a Tensor viewing external memory, without copying it.
+   *
+   * The Tensor reads (and, through get_data, writes) the external memory
+   * directly, while its gradient is stored by the Tensor.
+   *
+   * @param shape Shape of the tensor, either {length} or {rows, columns}.
+   * @param data Row-major data the tensor views, must hold as many elements
+   *     as the shape describes.
+   * @param storage Owner of the data, kept alive as long as the tensor.
+   * @return Tensor viewing data
+   */
+  static BasicTensor view(std::vector<std::size_t> shape, T *data, std::shared_ptr<void> storage);
+
+  /**
+   * @brief Create a Tensor viewing external memory for both its data and its gradient.
+   *
+   * @param shape Shape of the tensor, either {length} or {rows, columns}.
+   * @param data Row-major data the tensor views.
+   * @param grad Row-major gradient the tensor views, accumulated into by backwards.
+   * @param storage Owner of the data and gradient, kept alive as long as the tensor.
+   * @return Tensor viewing data and grad
+   */
+  static BasicTensor view(std::vector<std::size_t> shape, T *data, T *grad, std::shared_ptr<void> storage);
+
+  // region Access
+  /**
+   * @brief Get the shape of the Tensor.
+   * @return Shape of the tensor, either {length} or {rows, columns}
+   */
+  [[nodiscard]] const std::vector<std::size_t> &get_shape() const {
+    return this->val->shape;
+  }
+
+  /**
+   * @brief Get the number of elements in the Tensor.
+   * @return Number of elements
+   */
+  [[nodiscard]] std::size_t size() const {
+    return this->val->size();
+  }
+
+  /**
+   * @brief Get the data of the Tensor.
+   * @return View of the data, in row-major order
+   */
+  [[nodiscard]] std::span<T> get_data() const {
+    return this->val->data;
+  }
+
+  /**
+   * @brief Get the gradient of the Tensor.
+   * @return View of the gradient, in row-major order
+   */
+  [[nodiscard]] std::span<T> get_grad() const {
+    return this->val->grad;
+  }
+
+  /**
+   * @brief Get a Value viewing one element of the Tensor.
+   *
+   * The Value reads and writes the data and gradient of the Tensor directly,
+   * and keeps the Tensor's buffers alive. Values hold doubles, so only
+   * Tensors of doubles have elements.
+   *
+   * @param index Position of the element, in row-major order.
+   * @return Value viewing the element
+   */
+  [[nodiscard]] Value element(std::size_t index) const requires std::same_as<T, double>;
+
+  /**
+   * @brief Create a leaf Tensor sharing the data of this one, with its own gradient.
+   *
+   * Several threads can each compute gradients into their own Tensor sharing
+   * the same data (such as the weights of a model), without touching the
+   * gradient of the others.
+   *
+   * @return Tensor viewing the data of this Tensor
+   */
+  [[nodiscard]] BasicTensor share_data() const;
+
+  /**
+   * @brief Set every element of the gradient to 0.
+   */
+  void zero_grad() const;
+
+  // endregion Access
+  // region Operators
+
+  /**
+   * @brief Add two tensors elementwise.
+   *
+   * Both tensors must have the same shape, or one of them is 1-D with as many
+   * elements as the other has columns, in which case it is added to every row.
+   *
+   * @param lhs Tensor on the left hand side of the addition
+   * @param rhs Tensor on the right hand side of the addition
+   * @return Tensor representing the two previous tensors being added
+   */
+  friend BasicTensor operator+(const BasicTensor &lhs, const BasicTensor &rhs) {
+    return add(lhs, rhs);
+  }
+
+  /**
+   * @brief Multiply two tensors of the same shape elementwise.
+   *
+   * @param lhs Tensor on the left hand side of the multiplication
+   * @param rhs Tensor on the right hand side of the multiplication
+   * @return Tensor representing the two previous tensors being multiplied
+   */
+  friend BasicTensor operator*(const BasicTensor &lhs, const BasicTensor &rhs) {
+    return multiply(lhs, rhs);
+  }
+
+  /**
+   * @brief Compute the matrix product with another tensor.
+   *
+   * This Tensor must be 2-D, other can either be 2-D (giving a 2-D result)
+   * or 1-D (giving a 1-D result).
+   *
+   * @param other Right hand side of the product
+   * @return Tensor representing the matrix product
+   */
+  [[nodiscard]] BasicTensor matmul(const BasicTensor &other) const;
+
+  /**
+   * @brief Compute the matrix product with the transpose of another tensor.
+   *
+   * Both tensors must be 2-D with the same number of columns. This is the
+   * product of a batch of row vectors with a weight matrix stored one output
+   * per row, and runs without materializing the transpose.
+   *
+   * @param other Right hand side of the product, used transposed
+   * @return Tensor representing the matrix product
+   */
+  [[nodiscard]] BasicTensor matmul_transposed(const BasicTensor &other) const;
+
+  /**
+   * @brief Raise every element of the Tensor to an exponent.
+   *
+   * @param other Double representing the exponent
+   * @return Tensor representing the previous tensor raised to the power of other
+   */
+  [[nodiscard]] BasicTensor pow(double other) const;
+
+  /**
+   * @brief Apply a Rectified Linear Unit (ReLU) to every element of the Tensor.
+   *
+   * @return Tensor representing the previous tensor after passing through the ReLU
+   */
+  [[nodiscard]] BasicTensor relu() const;
+
+  /**
+   * @brief Sum all the elements of the Tensor.
+   *
+   * @return Tensor of shape {1} holding the sum
+   */
+  [[nodiscard]] BasicTensor sum() const;
+
+  /**
+   * @brief Convert the Tensor to another scalar type.
+   *
+   * The gradient of the result is converted back and accumulated into the
+   * gradient of this Tensor, but isn't propagated any further: the graphs of
+   * the two scalar types are separate, and this Tensor is a leaf of the
+   * graph of the result. Casting the (double) parameters of a model to float
+   * therefore runs the model in float while its gradients are accumulated in
+   * double, as in mixed-precision training.
+   *
+   * @tparam U Scalar type of the result, float or double (not T).
+   * @return Tensor of the same shape holding the converted data
+   */
+  template<typename U>
+  [[nodiscard]] BasicTensor<U> cast() const;
+
+  friend std::ostream &operator<<(std::ostream &os, const BasicTensor &val) {
+    os << val.as_string();
+    return os;
+  }
+
+  /**
+   * @brief Get a string representation of the Tensor.
+   * @return String representing the Tensor
+   */
+  [[nodiscard]] std::string as_string() const;
+
+  // endregion Operators
+
+  // region backpropagation
+
+  /**
+   * @brief Compute the gradients of the sum of the elements of this Tensor
+   *
+   * @param retainGraph Whether to keep the graph so that backwards can be
+   *     called again, otherwise every node is released (and freed, unless
+   *     referenced elsewhere) as soon as its gradient has been propagated.
+   */
+  void backwards(bool retainGraph = true) const;
+
+  /**
+   * @brief Compute the gradients of a weighted sum of the elements of this Tensor
+   *
+   * @param seeds Weight of each element, which is its gradient, in row-major order.
+   * @param retainGraph Whether to keep the graph so that backwards can be
+   *     called again.
+   */
+  void backwards(std::span<const T> seeds, bool retainGraph = true) const;
+
+  // endregion backpropagation
+};
+
+/**
+ * @brief Tensor of doubles, the scalar type used by the rest of the engine.
+ */
+using Tensor = BasicTensor<double>;
+
+/**
+ * @brief Tensor of floats, for dense computations which can trade precision for speed.
+ */
+using FloatTensor = BasicTensor<float>;
+
+using InternalTensor = BasicInternalTensor<double>;
+
+// Defined and instantiated in tensor.cpp
+extern template class BasicInternalTensor<float>;
+extern template class BasicInternalTensor<double>;
+extern template class BasicTensor<float>;
+extern template class BasicTensor<double>;
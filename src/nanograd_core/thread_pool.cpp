@@ -0,0 +1,133 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace {
+    // The pool and queue the current thread works for, if it is a worker
+    thread_local const ThreadPool *currentPool = nullptr;
+    thread_local std::size_t currentQueue = 0;
+}
+
+ThreadPool::ThreadPool(const std::size_t numThreads) {
+    const std::size_t count = std::max<std::size_t>(numThreads, 1);
+    for (std::size_t idx = 0; idx < count; ++idx) {
+        this->queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (std::size_t idx = 0; idx < count; ++idx) {
+        this->workers.emplace_back([this, idx]() { this->workerLoop(idx); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{this->sleepMutex};
+        this->stopping = true;
+    }
+    this->wakeUp.notify_all();
+    for (auto &worker: this->workers) {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::global() {
+    static ThreadPool pool{std::max(std::thread::hardware_concurrency(), 2u) - 1};
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    // Workers keep their own tasks, other threads spread them over the queues
+    const std::size_t index = currentPool == this
+                                  ? currentQueue
+                                  : this->nextQueue.fetch_add(1, std::memory_order_relaxed) % this->queues.size();
+    // Counted before it is queued, so the count never drops below the number of queued tasks
+    this->queued.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard lock{this->queues[index]->mutex};
+        this->queues[index]->tasks.push_back(std::move(task));
+    }
+    // Taking the lock makes sure a worker about to sleep sees the new task
+    { std::lock_guard lock{this->sleepMutex}; }
+    this->wakeUp.notify_one();
+}
+
+bool ThreadPool::takeTask(std::function<void()> &task) {
+    if (this->queued.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    const bool isWorker = currentPool == this;
+    const std::size_t start = isWorker ? currentQueue : 0;
+    for (std::size_t offset = 0; offset < this->queues.size(); ++offset) {
+        WorkQueue &queue = *this->queues[(start + offset) % this->queues.size()];
+        std::lock_guard lock{queue.mutex};
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        // A worker takes its newest task, everyone else steals the oldest one
+        if (isWorker && offset == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        this->queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::run_pending_task() {
+    std::function<void()> task;
+    if (!this->takeTask(task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::parallel_for(const std::size_t count, const std::function<void(std::size_t)> &body) {
+    std::atomic<std::size_t> remaining{count};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    const auto run = [&](const std::size_t index) {
+        try {
+            body(index);
+        } catch (...) {
+            std::lock_guard lock{errorMutex};
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        remaining.fetch_sub(1, std::memory_order_release);
+    };
+
+    for (std::size_t index = 1; index < count; ++index) {
+        this->submit([&run, index]() { run(index); });
+    }
+    if (count > 0) {
+        run(0);
+    }
+    this->help_until([&remaining]() { return remaining.load(std::memory_order_acquire) == 0; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop(const std::size_t index) {
+    currentPool = this;
+    currentQueue = index;
+    while (true) {
+        if (this->run_pending_task()) {
+            continue;
+        }
+        std::unique_lock lock{this->sleepMutex};
+        this->wakeUp.wait(lock, [this]() {
+            return this->stopping || this->queued.load(std::memory_order_acquire) > 0;
+        });
+        if (this->stopping && this->queued.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+// Standard Library Includes
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Local Includes
+
+// External Includes
+
+/**
+ * @brief A pool of worker threads which balance their load by stealing tasks.
+ *
+ * Every worker owns a queue of tasks. Tasks submitted from a worker go to
+ * the back of its own queue and are taken back from there (so related work
+ * stays on the same core), while idle workers steal from the front of the
+ * queues of the others. Threads which aren't part of the pool can help run
+ * tasks while they wait for some work to finish.
+ */
+class ThreadPool {
+  /**
+   * @brief Queue of tasks owned by a single worker.
+   */
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()> > tasks;
+  };
+
+  /**
+   * @brief One queue per worker.
+   */
+  std::vector<std::unique_ptr<WorkQueue> > queues;
+  /**
+   * @brief The worker threads.
+   */
+  std::vector<std::thread> workers;
+  /**
+   * @brief Number of tasks waiting in any of the queues.
+   */
+  std::atomic<std::size_t> queued{0};
+  /**
+   * @brief Queue that tasks submitted from outside the pool are added to next.
+   */
+  std::atomic<std::size_t> nextQueue{0};
+  /**
+   * @brief Whether the workers should exit.
+   */
+  bool stopping = false;
+  /**
+   * @brief Mutex and condition variable idle workers sleep on.
+   */
+  std::mutex sleepMutex;
+  std::condition_variable wakeUp;
+
+  /**
+   * @brief Main loop of a worker.
+   * @param index Index of the worker (and of its queue).
+   */
+  void workerLoop(std::size_t index);
+
+  /**
+   * @brief Take a task, from the queue of the calling worker first and then
+   *     from the others.
+   * @param task Set to the task, if one was found.
+   * @return Whether a task was found
+   */
+  bool takeTask(std::function<void()> &task);
+
+public:
+  /**
+   * @brief Start a pool of worker threads.
+   * @param numThreads Number of worker threads, at least 1.
+   */
+  explicit ThreadPool(std::size_t numThreads);
+
+  ThreadPool(const ThreadPool &) = delete;
+
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Finish the queued tasks and stop the worker threads.
+   */
+  ~ThreadPool();
+
+  /**
+   * @brief Get the pool shared by the library, with one worker per hardware
+   *     thread (except the one of the caller, which helps while waiting).
+   * @return The shared ThreadPool
+   */
+  static ThreadPool &global();
+
+  /**
+   * @brief Get the number of worker threads.
+   * @return Number of worker threads
+   */
+  [[nodiscard]] std::size_t size() const {
+    return this->workers.size();
+  }
+
+  /**
+   * @brief Queue a task to run on one of the workers.
+   *
+   * Tasks shouldn't throw, an exception escaping a task terminates the program.
+   *
+   * @param task Task to run.
+   */
+  void submit(std::function<void()> task);
+
+  /**
+   * @brief Run a single queued task on the calling thread, if there is one.
+   * @return Whether a task was run
+   */
+  bool run_pending_task();
+
+  /**
+   * @brief Run a function for every index in [0, count) on the pool, and wait for all of them.
+   *
+   * The calling thread runs part of the work too. If any call throws, the
+   * first exception is rethrown once every call has finished.
+   *
+   * @param count Number of indices.
+   * @param body Function called with each index.
+   */
+  void parallel_for(std::size_t count, const std::function<void(std::size_t)> &body);
+
+  /**
+   * @brief Run queued tasks on the calling thread until a condition holds.
+   * @param done Condition to wait for, checked between tasks.
+   */
+  template<typename Predicate>
+  void help_until(Predicate done) {
+    while (!done()) {
+      if (!this->run_pending_task()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+};
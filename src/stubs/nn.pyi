@@ -1,24 +1,111 @@
-from nanograd_bgriebel import engine
+from enum import Enum
+from typing import overload
+
+import numpy.typing as npt
+
+from nanograd_bgriebel import engine, optim
+
+class Initialization(Enum):
+    Uniform = ...
+    Xavier = ...
+    He = ...
 
 class Module:
     def __init__(self, params: list[engine.Value]): ...
     def zero_grad(self) -> None: ...
     def get_parameters(self) -> list[engine.Value]: ...
+    def get_flat_parameters(self) -> engine.Tensor: ...
 
 class Neuron(Module):
-    def __init__(self, nin: int, nonlinear: bool): ...
-    def __call__(self, x: list[engine.Value]): ...
+    def __init__(
+        self,
+        nin: int,
+        nonlinear: bool,
+        initialization: Initialization = Initialization.Uniform,
+        seed: int | None = None,
+    ): ...
+    @overload
+    def __call__(self, x: list[engine.Value]) -> engine.Value: ...
+    @overload
+    def __call__(self, x: list[engine.Dual]) -> engine.Dual: ...
     def zero_grad(self) -> None: ...
     def get_parameters(self) -> list[engine.Value]: ...
+    def get_flat_parameters(self) -> engine.Tensor: ...
 
 class Layer(Module):
-    def __init__(self, nin: int, nout: int, nonlienar: bool): ...
-    def __call__(self, x: list[engine.Value]): ...
+    def __init__(
+        self,
+        nin: int,
+        nout: int,
+        nonlinear: bool,
+        initialization: Initialization = Initialization.Uniform,
+        seed: int | None = None,
+    ): ...
+    @overload
+    def __call__(self, x: list[engine.Value]) -> list[engine.Value]: ...
+    @overload
+    def __call__(self, x: engine.Tensor | npt.ArrayLike) -> engine.Tensor: ...
+    @overload
+    def __call__(self, x: list[engine.Dual]) -> list[engine.Dual]: ...
+    def get_parameter_tensors(self) -> list[engine.Tensor]: ...
+    @property
+    def weights(self) -> engine.Tensor: ...
+    @property
+    def biases(self) -> engine.Tensor: ...
     def zero_grad(self) -> None: ...
     def get_parameters(self) -> list[engine.Value]: ...
+    def get_flat_parameters(self) -> engine.Tensor: ...
 
 class MultiLayerPerceptron(Module):
-    def __init__(self, nin: int, nouts: list[int]): ...
-    def __call__(self, x: list[engine.Value]): ...
+    def __init__(
+        self,
+        nin: int,
+        nouts: list[int],
+        initialization: Initialization = Initialization.Uniform,
+        seed: int | None = None,
+    ): ...
+    @overload
+    def __call__(self, x: list[engine.Value]) -> list[engine.Value]: ...
+    @overload
+    def __call__(self, x: engine.Tensor | npt.ArrayLike) -> engine.Tensor: ...
+    @overload
+    def __call__(self, x: list[engine.Dual]) -> list[engine.Dual]: ...
+    def checkpointed(self, x: list[engine.Value], segment_length: int) -> list[engine.Value]: ...
+    def get_parameter_tensors(self) -> list[engine.Tensor]: ...
+    @property
+    def layers(self) -> list[Layer]: ...
     def zero_grad(self) -> None: ...
     def get_parameters(self) -> list[engine.Value]: ...
+    def get_flat_parameters(self) -> engine.Tensor: ...
+    def compile(self) -> CompiledMultiLayerPerceptron: ...
+    @overload
+    def save(self, path: str) -> None: ...
+    @overload
+    def save(self, path: str, optimizer: optim.Optimizer) -> None: ...
+    @staticmethod
+    def load(path: str) -> MultiLayerPerceptron: ...
+    @staticmethod
+    def load_optimizer_state(path: str, optimizer: optim.Optimizer) -> None: ...
+
+class CompiledMultiLayerPerceptron:
+    def __init__(self, mlp: MultiLayerPerceptron): ...
+    def __call__(self, x: list[float]) -> list[float]: ...
+    def backwards(self, output_grads: list[float]) -> None: ...
+    def __len__(self) -> int: ...
+
+class DataParallelTrainer:
+    @overload
+    def __init__(
+        self, mlp: MultiLayerPerceptron, num_workers: int, learning_rate: float
+    ): ...
+    @overload
+    def __init__(
+        self, mlp: MultiLayerPerceptron, num_workers: int, optimizer: optim.Optimizer
+    ): ...
+    def step(
+        self,
+        inputs: engine.Tensor | npt.ArrayLike,
+        targets: engine.Tensor | npt.ArrayLike,
+    ) -> float: ...
+    @property
+    def num_workers(self) -> int: ...
@@ -0,0 +1,31 @@
+from nanograd_bgriebel import engine
+
+class Optimizer:
+    def step(self, zero_grad: bool = False) -> None: ...
+    def zero_grad(self) -> None: ...
+    def get_parameters(self) -> list[engine.Tensor]: ...
+    def get_state(self) -> list[float]: ...
+    def set_state(self, state: list[float]) -> None: ...
+
+class SGD(Optimizer):
+    def __init__(
+        self, params: list[engine.Tensor], learning_rate: float, momentum: float = 0.0
+    ): ...
+    @property
+    def learning_rate(self) -> float: ...
+    @learning_rate.setter
+    def learning_rate(self, new_learning_rate: float): ...
+
+class Adam(Optimizer):
+    def __init__(
+        self,
+        params: list[engine.Tensor],
+        learning_rate: float = 0.001,
+        beta1: float = 0.9,
+        beta2: float = 0.999,
+        epsilon: float = 1e-8,
+    ): ...
+    @property
+    def learning_rate(self) -> float: ...
+    @learning_rate.setter
+    def learning_rate(self, new_learning_rate: float): ...
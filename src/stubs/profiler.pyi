@@ -0,0 +1,25 @@
+from typing import TypedDict
+
+class _OperationReport(TypedDict):
+    nodes: int
+    seconds: float
+    bytes: int
+
+class _Report(TypedDict):
+    operations: dict[str, _OperationReport]
+    forward_seconds: float
+    topo_sort_seconds: float
+    backward_seconds: float
+    nodes: int
+    node_bytes: int
+    backward_passes: int
+    max_depth: int
+    max_width: int
+
+def start() -> None: ...
+def stop() -> None: ...
+def reset() -> None: ...
+def is_enabled() -> bool: ...
+def report() -> _Report: ...
+def chrome_trace() -> str: ...
+def write_chrome_trace(path: str) -> None: ...
@@ -0,0 +1,92 @@
+// Standard Library Includes
+#include <vector>
+
+// External Includes
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+
+// Local Includes
+#include "dual.h"
+#include "engine.h"
+#include "nn.h"
+
+TEST_CASE("Calculating Derivatives with Dual Numbers", "[dual]") {
+    SECTION("For Basic Operations") {
+        const Dual x{5., 1.};
+        const Dual y{3.};
+        const Dual z = x * y + x.pow(2.0) - y.relu();
+        double margin = 0.0000001;
+
+        CHECK_THAT(z.get_data(), Catch::Matchers::WithinAbs(37.0, margin));
+        // dz/dx = y + 2x
+        CHECK_THAT(z.get_tangent(), Catch::Matchers::WithinAbs(13.0, margin));
+        // Along y instead, dz/dy = x - 1
+        const Dual w = Dual{5.} * Dual{3., 1.} + Dual{5.}.pow(2.0) - Dual{3., 1.}.relu();
+        CHECK_THAT(w.get_tangent(), Catch::Matchers::WithinAbs(4.0, margin));
+    }
+
+    SECTION("More Complex Calculation") {
+        // Same calculation as in the engine tests, once along each input
+        const auto calculate = [](const std::vector<Dual> &inputs) {
+            const Dual &a = inputs[0];
+            const Dual &b = inputs[1];
+            Dual c = a + b;
+            Dual d = a * b + b.pow(3.0);
+            c = c + c + 1.0;
+            c = c + 1.0 + c + (-a);
+            d = d + d * 2.0 + (b + a).relu();
+            d = d + 3.0 * d + (b - a).relu();
+            const Dual e = c - d;
+            const Dual f = e.pow(2.0);
+            Dual g = f / 2.0;
+            g = g + 10.0 / f;
+            return std::vector{g};
+        };
+        const Dual alongA = jvp(calculate, {-4.0, 2.0}, {1.0, 0.0})[0];
+        const Dual alongB = jvp(calculate, {-4.0, 2.0}, {0.0, 1.0})[0];
+        CHECK_THAT(alongA.get_data(), Catch::Matchers::WithinAbs(24.7041, 0.0001));
+        CHECK_THAT(alongA.get_tangent(), Catch::Matchers::WithinAbs(138.8338, 0.0001));
+        CHECK_THAT(alongB.get_tangent(), Catch::Matchers::WithinAbs(645.5773, 0.0001));
+        // Along a combination of the inputs, the derivatives combine linearly
+        const Dual along = jvp(calculate, {-4.0, 2.0}, {2.0, -1.0})[0];
+        CHECK_THAT(along.get_tangent(), Catch::Matchers::WithinAbs(2 * 138.8338 - 645.5773, 0.001));
+        CHECK_THROWS(jvp(calculate, {-4.0, 2.0}, {1.0}));
+    }
+
+    SECTION("Division and Sums") {
+        const std::vector x{Dual{2., 1.}, Dual{-1., 0.5}, Dual{4.}};
+        const std::vector y{Dual{1.}, Dual{3., 1.}, Dual{0.5}};
+        double margin = 0.0000001;
+        const Dual quotient = x[0] / y[1];
+        // d(x0 / y1) = dx0 / y1 - x0 dy1 / y1^2
+        CHECK_THAT(quotient.get_tangent(), Catch::Matchers::WithinAbs(1.0 / 3.0 - 2.0 / 9.0, margin));
+        const Dual total = sum(x);
+        CHECK_THAT(total.get_data(), Catch::Matchers::WithinAbs(5.0, margin));
+        CHECK_THAT(total.get_tangent(), Catch::Matchers::WithinAbs(1.5, margin));
+        const Dual product = dot(x, y);
+        CHECK_THAT(product.get_data(), Catch::Matchers::WithinAbs(2.0 - 3.0 + 2.0, margin));
+        // 1 * 1 + (0.5 * 3 + -1 * 1) + 0
+        CHECK_THAT(product.get_tangent(), Catch::Matchers::WithinAbs(1.5, margin));
+    }
+
+    SECTION("Modules match the reverse mode") {
+        const MultiLayerPerceptron mlp{3, std::vector{5, 4, 2}, Initialization::Xavier, 11};
+        const std::vector<double> point{0.5, -1.0, 2.0};
+        const std::vector<Value> inputs{Value{point[0]}, Value{point[1]}, Value{point[2]}};
+        const std::vector<Value> outputs = mlp(inputs);
+        outputs[1].backwards();
+        for (std::size_t idx = 0; idx < point.size(); ++idx) {
+            std::vector<double> direction(point.size(), 0.);
+            direction[idx] = 1.;
+            const std::vector<Dual> duals = jvp([&](const std::vector<Dual> &x) { return mlp(x); }, point, direction);
+            CHECK_THAT(duals[0].get_data(), Catch::Matchers::WithinAbs(outputs[0].get_data(), 1e-12));
+            CHECK_THAT(duals[1].get_tangent(), Catch::Matchers::WithinAbs(inputs[idx].get_grad(), 1e-12));
+        }
+
+        const Neuron neuron{3, false, Initialization::He, 5};
+        const Value neuronOutput = neuron(inputs);
+        const Dual neuronDual = neuron({Dual{point[0]}, Dual{point[1], 1.}, Dual{point[2]}});
+        CHECK_THAT(neuronDual.get_data(), Catch::Matchers::WithinAbs(neuronOutput.get_data(), 1e-12));
+        CHECK_THAT(neuronDual.get_tangent(), Catch::Matchers::WithinAbs(neuron.get_parameters()[1].get_data(), 1e-12));
+    }
+}
@@ -1,5 +1,9 @@
 // Standard Library Includes
+#include <atomic>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
 
 // External Includes
 #include "catch2/catch_test_macros.hpp"
@@ -7,6 +11,7 @@
 
 // Local Includes
 #include "engine.h"
+#include "thread_pool.h"
 
 TEST_CASE("Calculating Gradients", "[engine]") {
     SECTION("Creating Values") {
@@ -170,4 +175,422 @@ TEST_CASE("Calculating Gradients", "[engine]") {
         CHECK_THAT(a.get_grad(), Catch::Matchers::WithinAbs(138.8338, 0.0001));
         CHECK_THAT(b.get_grad(), Catch::Matchers::WithinAbs(645.5773, 0.0001));
     }
+
+    SECTION("Deep Graphs") {
+        // A long running sum, deep enough to overflow a recursive traversal
+        const int chainLength = 100000;
+        Value x{0.5};
+        Value total{0.0};
+        for (int idx = 0; idx < chainLength; ++idx) {
+            total = total + x * 2.0;
+        }
+        CHECK_THAT(total.get_data(), Catch::Matchers::WithinAbs(chainLength, 0.0001));
+        total.backwards();
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(2.0 * chainLength, 0.0001));
+    }
+
+    SECTION("Shared Subexpressions") {
+        Value x{3.0};
+        Value y = x * x;
+        Value z = y + y;
+        double margin = 0.0000001;
+        z.backwards();
+        // dz/dx = 4x, with every node only visited once
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(12.0, margin));
+        CHECK_THAT(y.get_grad(), Catch::Matchers::WithinAbs(2.0, margin));
+    }
+
+    SECTION("For Constants") {
+        Value x{2.0};
+        double margin = 0.0000001;
+        // Every term combines x with a constant: 5 + 6 + 1 + 3 + 0.5 - 1
+        Value y = (x + 3.0) + (3.0 * x) + (3.0 - x) + (6.0 / x) + (x / 4.0) - (-x + 3.0);
+        CHECK_THAT(y.get_data(), Catch::Matchers::WithinAbs(14.5, margin));
+        y.backwards();
+        // 1 + 3 - 1 - 6/x^2 + 1/4 + 1
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(2.75, margin));
+    }
+
+    SECTION("For Sums") {
+        const std::vector values{Value{1.0}, Value{-2.0}, Value{3.5}};
+        Value total = sum(values);
+        double margin = 0.0000001;
+        CHECK_THAT(total.get_data(), Catch::Matchers::WithinAbs(2.5, margin));
+        (total * total).backwards();
+        for (const auto &value: values) {
+            CHECK_THAT(value.get_grad(), Catch::Matchers::WithinAbs(5.0, margin));
+        }
+        CHECK(sum(std::vector<Value>{}).get_data() == 0.0);
+    }
+
+    SECTION("For Dot Products") {
+        // Long enough to go through the vectorized loop and its remainder
+        std::vector<Value> x, w;
+        double expected = 0.;
+        for (int idx = 0; idx < 11; ++idx) {
+            x.emplace_back(0.5 * idx);
+            w.emplace_back(1.0 - idx);
+            expected += 0.5 * idx * (1.0 - idx);
+        }
+        double margin = 0.0000001;
+        Value out = dot(x, w);
+        CHECK_THAT(out.get_data(), Catch::Matchers::WithinAbs(expected, margin));
+        (out * 2.0).backwards();
+        for (int idx = 0; idx < 11; ++idx) {
+            CHECK_THAT(x[idx].get_grad(), Catch::Matchers::WithinAbs(2.0 * (1.0 - idx), margin));
+            CHECK_THAT(w[idx].get_grad(), Catch::Matchers::WithinAbs(2.0 * 0.5 * idx, margin));
+        }
+
+        // The same Value can appear on both sides
+        Value y{3.0};
+        const std::vector ys{y, y};
+        dot(ys, ys).backwards();
+        CHECK_THAT(y.get_grad(), Catch::Matchers::WithinAbs(12.0, margin));
+
+        CHECK_THROWS_AS(dot(x, ys), std::runtime_error);
+    }
+}
+
+TEST_CASE("Skipping the Graph", "[engine]") {
+    double margin = 0.0000001;
+
+    SECTION("Computing Data Only") {
+        Value x{2.0};
+        Value w{-3.0};
+        Value y{0.0};
+        {
+            NoGradGuard guard{};
+            CHECK_FALSE(NoGradGuard::is_grad_enabled());
+            y = (x * w + 1.0).relu() + x.pow(2.0) - dot(std::vector{x}, std::vector{w}) / 2.0;
+        }
+        CHECK(NoGradGuard::is_grad_enabled());
+        CHECK_THAT(y.get_data(), Catch::Matchers::WithinAbs(7.0, margin));
+        // The result is a leaf, so no gradient reaches x or w
+        y.backwards();
+        CHECK(x.get_grad() == 0.0);
+        CHECK(w.get_grad() == 0.0);
+    }
+
+    SECTION("Nesting Guards") {
+        {
+            NoGradGuard outer{};
+            {
+                NoGradGuard inner{};
+                CHECK_FALSE(NoGradGuard::is_grad_enabled());
+            }
+            CHECK_FALSE(NoGradGuard::is_grad_enabled());
+        }
+        CHECK(NoGradGuard::is_grad_enabled());
+    }
+}
+
+TEST_CASE("Releasing the Graph", "[engine]") {
+    double margin = 0.0000001;
+
+    SECTION("Freeing Nodes During Backwards") {
+        Value x{2.0};
+        Value w{-3.0};
+        Value y{0.0};
+        {
+            const Value hidden = x * w;
+            y = (hidden + 1.0).relu() + hidden * hidden;
+        }
+        y.backwards(false);
+        // dy/dx = 2 * x * w^2 (the ReLU is off), and the same for w
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(36.0, margin));
+        CHECK_THAT(w.get_grad(), Catch::Matchers::WithinAbs(-24.0, margin));
+        // The root is now a leaf, so another pass doesn't reach x or w
+        y.backwards(false);
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(36.0, margin));
+        CHECK_THAT(y.get_data(), Catch::Matchers::WithinAbs(36.0, margin));
+    }
+
+    SECTION("Freeing Nodes in Parallel") {
+        ThreadPool pool{2};
+        Value x{2.0};
+        Value y = x * x * x;
+        y.backwards(pool, false);
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(12.0, margin));
+        y.backwards(pool, false);
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(12.0, margin));
+    }
+
+    SECTION("Destroying Deep Graphs") {
+        // Dropping the root releases the whole chain, without recursing once per node
+        const int chainLength = 1000000;
+        Value x{0.5};
+        {
+            Value total{0.0};
+            for (int idx = 0; idx < chainLength; ++idx) {
+                total = total + x;
+            }
+            CHECK_THAT(total.get_data(), Catch::Matchers::WithinAbs(0.5 * chainLength, 0.0001));
+        }
+        CHECK(x.get_grad() == 0.0);
+    }
+
+    SECTION("Checkpointing Segments") {
+        const auto segment = [](const std::vector<Value> &in) {
+            return std::vector{(in[0] * in[1]).relu() + in[0], in[1].pow(2.0)};
+        };
+        Value a{1.5};
+        Value b{-2.0};
+        Value c{3.0};
+        const std::vector<Value> direct = segment(segment({a, b}));
+        const Value expected = direct[0] * c + direct[1];
+        expected.backwards();
+        const double aGrad = a.get_grad();
+        const double bGrad = b.get_grad();
+        const double cGrad = c.get_grad();
+        a.zero_grad();
+        b.zero_grad();
+        c.zero_grad();
+
+        const std::vector<Value> checkpointed = checkpoint(segment, checkpoint(segment, {a, b}));
+        const Value out = checkpointed[0] * c + checkpointed[1];
+        CHECK_THAT(out.get_data(), Catch::Matchers::WithinAbs(expected.get_data(), margin));
+        out.backwards();
+        CHECK_THAT(a.get_grad(), Catch::Matchers::WithinAbs(aGrad, margin));
+        CHECK_THAT(b.get_grad(), Catch::Matchers::WithinAbs(bGrad, margin));
+        CHECK_THAT(c.get_grad(), Catch::Matchers::WithinAbs(cGrad, margin));
+
+        // The segment is recomputed with a graph even if backwards runs under a NoGradGuard
+        Value x{3.0};
+        const Value squared = checkpoint([](const std::vector<Value> &in) {
+            return std::vector{in[0] * in[0]};
+        }, {x})[0];
+        {
+            NoGradGuard guard{};
+            squared.backwards();
+        }
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(6.0, margin));
+        CHECK(NoGradGuard::is_grad_enabled());
+    }
+}
+
+TEST_CASE("Calculating Gradients in Parallel", "[engine]") {
+    ThreadPool pool{4};
+    double margin = 0.0000001;
+
+    SECTION("Running Tasks") {
+        std::atomic<int> counter{0};
+        for (int idx = 0; idx < 1000; ++idx) {
+            pool.submit([&counter]() { counter.fetch_add(1); });
+        }
+        pool.help_until([&counter]() { return counter.load() == 1000; });
+        CHECK(counter.load() == 1000);
+    }
+
+    SECTION("Wide Graphs") {
+        // Many independent sums of products sharing the same inputs, like the neurons of a Layer
+        std::vector<Value> inputs, weights;
+        for (int idx = 0; idx < 64; ++idx) {
+            inputs.emplace_back(std::sin(idx * 0.3));
+        }
+        for (int idx = 0; idx < 256 * 64; ++idx) {
+            weights.emplace_back(std::cos(idx * 0.7));
+        }
+        // The graph is built twice, since the inner nodes keep their gradients
+        const auto buildLoss = [&]() {
+            Value loss{0.0};
+            for (int row = 0; row < 256; ++row) {
+                Value activation{0.1};
+                for (int col = 0; col < 64; ++col) {
+                    activation = activation + weights[row * 64 + col] * inputs[col];
+                }
+                loss = loss + activation.relu().pow(2.0);
+            }
+            return loss;
+        };
+
+        buildLoss().backwards();
+        std::vector<double> expected;
+        for (auto &v: inputs) {
+            expected.push_back(v.get_grad());
+            v.zero_grad();
+        }
+        for (auto &v: weights) {
+            expected.push_back(v.get_grad());
+            v.zero_grad();
+        }
+
+        buildLoss().backwards(pool);
+        std::size_t idx = 0;
+        for (auto &v: inputs) {
+            CHECK_THAT(v.get_grad(), Catch::Matchers::WithinAbs(expected[idx++], margin));
+        }
+        for (auto &v: weights) {
+            CHECK_THAT(v.get_grad(), Catch::Matchers::WithinAbs(expected[idx++], margin));
+        }
+    }
+
+    SECTION("Shared Subexpressions") {
+        Value x{3.0};
+        Value y = x * x;
+        Value z = y + y;
+        z.backwards(pool);
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(12.0, margin));
+        CHECK_THAT(y.get_grad(), Catch::Matchers::WithinAbs(2.0, margin));
+    }
+
+    SECTION("Deep Graphs") {
+        const int chainLength = 100000;
+        Value x{0.5};
+        Value total{0.0};
+        for (int idx = 0; idx < chainLength; ++idx) {
+            total = total + x * 2.0;
+        }
+        total.backwards(pool);
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(2.0 * chainLength, 0.0001));
+    }
+
+    SECTION("Checkpointed Segments Sharing Parameters") {
+        // Independent segments are recomputed concurrently, and each sorts a graph reaching the same weights
+        std::vector<Value> weights;
+        for (int idx = 0; idx < 16; ++idx) {
+            weights.emplace_back(std::cos(idx * 0.7));
+        }
+        const auto segment = [&weights](const std::vector<Value> &in) {
+            Value activation{0.0};
+            for (const Value &weight: weights) {
+                activation = activation + weight * in[0];
+            }
+            return std::vector{activation.pow(2.0)};
+        };
+        double expected = 0.0;
+        double weightSum = 0.0;
+        for (const Value &weight: weights) {
+            weightSum += weight.get_data();
+        }
+        std::vector<Value> outputs;
+        for (int idx = 0; idx < 64; ++idx) {
+            const double input = std::sin(idx * 0.3);
+            outputs.push_back(checkpoint(segment, {Value{input}})[0]);
+            expected += 2.0 * weightSum * input * input;
+        }
+        sum(outputs).backwards(pool);
+        for (const Value &weight: weights) {
+            CHECK_THAT(weight.get_grad(), Catch::Matchers::WithinAbs(expected, 1e-9));
+        }
+    }
+
+    SECTION("Errors in Backward Functions") {
+        // One branch of a wide graph fails when its segment is recomputed
+        std::atomic<int> calls{0};
+        Value x{2.0};
+        std::vector<Value> branches;
+        for (int idx = 0; idx < 64; ++idx) {
+            branches.push_back(x * static_cast<double>(idx));
+        }
+        branches.push_back(checkpoint([&calls](const std::vector<Value> &in) {
+            if (calls.fetch_add(1) > 0) {
+                throw std::runtime_error("segment failed");
+            }
+            return std::vector<Value>{in[0] * in[0]};
+        }, {x})[0]);
+        const Value total = sum(branches);
+        CHECK_THROWS_AS(total.backwards(pool), std::runtime_error);
+        // The pool is still usable afterwards
+        Value y{2.0};
+        std::vector<Value> fresh;
+        for (int idx = 0; idx < 64; ++idx) {
+            fresh.push_back(y * static_cast<double>(idx));
+        }
+        sum(fresh).backwards(pool);
+        CHECK_THAT(y.get_grad(), Catch::Matchers::WithinAbs(63.0 * 64.0 / 2.0, margin));
+    }
+}
+
+TEST_CASE("Calculating Higher-Order Gradients", "[engine]") {
+    const double margin = 0.00001;
+
+    SECTION("Gradients as Values") {
+        Value x{2.0};
+        Value y{3.0};
+        Value z = x * x * y + y.pow(2.0);
+        const auto grads = grad(z, {x, y});
+        CHECK_THAT(grads[0].get_data(), Catch::Matchers::WithinAbs(12.0, margin));
+        CHECK_THAT(grads[1].get_data(), Catch::Matchers::WithinAbs(10.0, margin));
+        // The grad of the nodes is left untouched
+        CHECK(x.get_grad() == 0.0);
+        CHECK(y.get_grad() == 0.0);
+        // Inputs which don't affect the output get a gradient of 0
+        CHECK(grad(z, {Value{1.0}})[0].get_data() == 0.0);
+    }
+
+    SECTION("Gradients of Gradients") {
+        Value x{1.5};
+        Value cube = x.pow(3.0);
+        const Value first = grad(cube, {x}, true)[0];
+        CHECK_THAT(first.get_data(), Catch::Matchers::WithinAbs(3.0 * 1.5 * 1.5, margin));
+        const Value second = grad(first, {x}, true)[0];
+        CHECK_THAT(second.get_data(), Catch::Matchers::WithinAbs(6.0 * 1.5, margin));
+        const Value third = grad(second, {x})[0];
+        CHECK_THAT(third.get_data(), Catch::Matchers::WithinAbs(6.0, margin));
+        // The gradients can also go through backwards
+        second.backwards();
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(6.0, margin));
+    }
+
+    SECTION("Hessian-Vector Products") {
+        std::vector<Value> inputs{Value{0.5}, Value{-1.0}, Value{2.0}};
+        std::vector<Value> weights{Value{0.3}, Value{-0.7}, Value{1.1}, Value{0.9}, Value{-0.2}, Value{0.4}};
+        const std::vector<double> vector{0.2, -0.4, 1.0, 0.5, -1.5, 0.3};
+        std::vector<Value> parameters = weights;
+        // A small network of dot products, ReLUs, powers and affine maps
+        auto buildLoss = [&]() {
+            const std::span<const Value> first{weights.data(), 3};
+            const std::span<const Value> second{weights.data() + 3, 3};
+            const Value hidden = dot(first, inputs).relu() + dot(second, inputs) * dot(first, inputs);
+            const std::vector<Value> terms{hidden.pow(2.0), (hidden * 0.5 - 1.0).pow(3.0), weights[0] * weights[5]};
+            return sum(terms);
+        };
+        const Value loss = buildLoss();
+        const auto product = hvp(loss, parameters, vector);
+
+        // Same product from the gradient of the gradient along vector
+        const auto grads = grad(loss, parameters, true);
+        std::vector<Value> directions;
+        for (const double v: vector) {
+            directions.emplace_back(v);
+        }
+        const auto expected = grad(dot(grads, directions), parameters);
+        REQUIRE(product.size() == expected.size());
+        for (std::size_t idx = 0; idx < product.size(); ++idx) {
+            CHECK_THAT(product[idx], Catch::Matchers::WithinAbs(expected[idx].get_data(), margin));
+        }
+
+        // And from finite differences of the gradient
+        const double step = 1e-6;
+        auto gradientAt = [&](const double shift) {
+            for (std::size_t idx = 0; idx < weights.size(); ++idx) {
+                weights[idx].set_data(weights[idx].get_data() + shift * vector[idx]);
+            }
+            const Value shifted = buildLoss();
+            const auto out = grad(shifted, parameters);
+            for (std::size_t idx = 0; idx < weights.size(); ++idx) {
+                weights[idx].set_data(weights[idx].get_data() - shift * vector[idx]);
+            }
+            return out;
+        };
+        const auto above = gradientAt(step);
+        const auto below = gradientAt(-step);
+        for (std::size_t idx = 0; idx < product.size(); ++idx) {
+            const double difference = (above[idx].get_data() - below[idx].get_data()) / (2.0 * step);
+            CHECK_THAT(product[idx], Catch::Matchers::WithinAbs(difference, 0.0001));
+        }
+    }
+
+    SECTION("Mismatched Sizes") {
+        Value x{1.0};
+        CHECK_THROWS(hvp(x * x, {x}, {1.0, 2.0}));
+    }
+
+    SECTION("Checkpointed Segments") {
+        Value x{2.0};
+        const auto outputs = checkpoint([](const std::vector<Value> &in) {
+            return std::vector<Value>{in[0] * in[0]};
+        }, {x});
+        CHECK_THROWS(grad(outputs[0], {x}));
+    }
 }
@@ -110,3 +110,90 @@ class TestEngine:
         # backward pass went well
         assert abs(amg.grad - apt.grad.item()) < tol
         assert abs(bmg.grad - bpt.grad.item()) < tol
+
+    def test_parallel_backwards(self):
+        a = ng.Value(-4.0)
+        b = ng.Value(2.0)
+        total = sum(((a * i + b).relu() * b for i in range(-8, 8)), ng.Value(0.0))
+        total.backwards(parallel=True)
+        a_grad, b_grad = a.grad, b.grad
+
+        a.zero_grad()
+        b.zero_grad()
+        # A fresh graph, since the inner nodes keep their gradients
+        total = sum(((a * i + b).relu() * b for i in range(-8, 8)), ng.Value(0.0))
+        total.backwards()
+        assert a.grad == pytest.approx(a_grad)
+        assert b.grad == pytest.approx(b_grad)
+
+    def test_sum_and_dot(self):
+        x = [ng.Value(float(i)) for i in range(4)]
+        w = [ng.Value(2.0 - i) for i in range(4)]
+        out = ng.engine.dot(x, w) + ng.engine.sum(w)
+        assert out.data == pytest.approx(-2.0 + 2.0)
+        out.backwards()
+        assert [v.grad for v in x] == pytest.approx([2.0, 1.0, 0.0, -1.0])
+        assert [v.grad for v in w] == pytest.approx([1.0, 2.0, 3.0, 4.0])
+
+    def test_no_grad(self):
+        x = ng.Value(3.0)
+        w = ng.Value(2.0)
+        with ng.no_grad():
+            assert not ng.engine.is_grad_enabled()
+            out = x * w + 1.0
+        assert ng.engine.is_grad_enabled()
+        assert out.data == pytest.approx(7.0)
+        out.backwards()
+        assert x.grad == 0.0
+        assert w.grad == 0.0
+
+    def test_checkpoint(self):
+        a = ng.Value(1.5)
+        b = ng.Value(-2.0)
+        outputs = ng.engine.checkpoint(lambda v: [v[0] * v[1] + v[0]], [a, b])
+        assert outputs[0].data == pytest.approx(-1.5)
+        outputs[0].backwards(retain_graph=False)
+        assert a.grad == pytest.approx(-1.0)
+        assert b.grad == pytest.approx(1.5)
+
+    def test_profiler(self, tmp_path):
+        ng.profiler.start()
+        a = ng.Value(2.0)
+        b = ng.Value(-3.0)
+        (a * b + 1.0).relu().backwards()
+        ng.profiler.stop()
+        assert not ng.profiler.is_enabled()
+        report = ng.profiler.report()
+        assert report["operations"]["*"]["nodes"] == 1
+        assert report["nodes"] == 5
+        assert report["backward_passes"] == 1
+        assert report["max_depth"] == 3
+        path = tmp_path / "trace.json"
+        ng.profiler.write_chrome_trace(str(path))
+        assert '"name":"backwards"' in path.read_text()
+
+    def test_jvp(self):
+        def f(v):
+            return [v[0] * v[1] + v[0] ** 2.0]
+
+        outputs = ng.engine.jvp(f, [5.0, 3.0], [1.0, 0.0])
+        assert outputs[0].data == pytest.approx(40.0)
+        # d/dx (x y + x^2) = y + 2x
+        assert outputs[0].tangent == pytest.approx(13.0)
+        y = ng.Dual(3.0, 1.0)
+        assert (ng.Dual(5.0) / y).tangent == pytest.approx(-5.0 / 9.0)
+
+    def test_higher_order(self):
+        x = ng.Value(1.5)
+        y = ng.Value(2.0)
+        z = x**3.0 * y
+        (dx, dy) = ng.engine.grad(z, [x, y], create_graph=True)
+        assert dx.data == pytest.approx(3.0 * 1.5**2 * 2.0)
+        assert dy.data == pytest.approx(1.5**3)
+        assert x.grad == 0.0
+        # d/dx (3 x^2 y) = 6 x y
+        assert ng.engine.grad(dx, [x])[0].data == pytest.approx(6.0 * 1.5 * 2.0)
+        # Hessian [[6 x y, 3 x^2], [3 x^2, 0]] times [1, 2]
+        product = ng.engine.hvp(z, [x, y], [1.0, 2.0])
+        assert product[0] == pytest.approx(6.0 * 1.5 * 2.0 + 2.0 * 3.0 * 1.5**2)
+        assert product[1] == pytest.approx(3.0 * 1.5**2)
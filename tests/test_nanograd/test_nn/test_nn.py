@@ -1,6 +1,8 @@
 # Standard Library Imports
+from concurrent.futures import ThreadPoolExecutor
 
 # External Imports
+import numpy as np
 import pytest
 
 # Local Imports
@@ -92,3 +94,187 @@ class TestMultiLayerPerceptron:
         test_mlp.zero_grad()
         for param in test_mlp.get_parameters():
             assert param.grad == 0
+
+    def test_flat_parameters(self):
+        test_mlp = ng.MultiLayerPerceptron(4, [5, 3])
+        flat = test_mlp.get_flat_parameters()
+        assert len(flat) == 43
+        flat.data[:] = 0.5
+        for param in test_mlp.get_parameters():
+            assert param.data == 0.5
+        assert np.all(test_mlp.layers[1].biases.data == 0.5)
+
+    def test_checkpointed(self):
+        test_mlp = ng.MultiLayerPerceptron(3, [4, 4, 4, 4, 1])
+        x = [ng.Value(0.5), ng.Value(-1.0), ng.Value(2.0)]
+        expected = test_mlp(x)[0]
+        expected.backwards(retain_graph=False)
+        expected_grads = [p.grad for p in test_mlp.get_parameters()]
+        test_mlp.zero_grad()
+
+        out = test_mlp.checkpointed(x, 2)[0]
+        assert out.data == pytest.approx(expected.data)
+        out.backwards()
+        assert [p.grad for p in test_mlp.get_parameters()] == pytest.approx(
+            expected_grads
+        )
+
+
+class TestModule:
+    def test_parameters(self):
+        x = ng.Value(2.0)
+        y = ng.Value(-3.0)
+        test_module = ng.Module([x, y])
+        (x * y).backwards()
+        assert list(test_module.get_flat_parameters().grad) == [-3.0, 2.0]
+        test_module.zero_grad()
+        assert x.grad == 0
+        assert y.grad == 0
+
+
+class TestCompiledMultiLayerPerceptron:
+    def test_calling(self):
+        test_mlp = ng.MultiLayerPerceptron(4, [5, 5, 3])
+        compiled = test_mlp.compile()
+        outputs = test_mlp([ng.Value(1), ng.Value(2), ng.Value(3), ng.Value(4)])
+        compiled_outputs = compiled([1, 2, 3, 4])
+        assert len(compiled_outputs) == 3
+        for output, compiled_output in zip(outputs, compiled_outputs):
+            assert compiled_output == pytest.approx(output.data)
+
+    def test_grads(self):
+        test_mlp = ng.MultiLayerPerceptron(4, [5, 5, 3])
+        outputs = test_mlp([ng.Value(1), ng.Value(2), ng.Value(3), ng.Value(4)])
+        outputs[1].backwards()
+        expected = [param.grad for param in test_mlp.get_parameters()]
+        test_mlp.zero_grad()
+
+        compiled = test_mlp.compile()
+        compiled([1, 2, 3, 4])
+        compiled.backwards([0.0, 1.0, 0.0])
+        for param, grad in zip(test_mlp.get_parameters(), expected):
+            assert param.grad == pytest.approx(grad)
+
+
+class TestNumpyInterop:
+    def test_calling(self):
+        test_mlp = ng.MultiLayerPerceptron(4, [5, 5, 3])
+        outputs = test_mlp([ng.Value(1), ng.Value(2), ng.Value(3), ng.Value(4)])
+        tensor_outputs = test_mlp(np.array([1.0, 2.0, 3.0, 4.0]))
+        assert tensor_outputs.shape == (3,)
+        np.testing.assert_allclose(
+            np.asarray(tensor_outputs), [output.data for output in outputs]
+        )
+
+    def test_batches(self):
+        test_mlp = ng.MultiLayerPerceptron(4, [5, 5, 3])
+        batch = np.arange(8.0).reshape(2, 4)
+        tensor_outputs = test_mlp(batch)
+        assert tensor_outputs.shape == (2, 3)
+        for row, sample in enumerate(batch):
+            np.testing.assert_allclose(tensor_outputs.data[row], test_mlp(sample).data)
+
+    def test_parameter_views(self):
+        test_layer = ng.Layer(3, 2, False)
+        weights = test_layer.weights.data
+        assert weights.shape == (2, 3)
+        # Writes through the view change the parameters of the Layer
+        weights[:] = 1.0
+        test_layer.biases.data[:] = [0.5, -0.5]
+        outputs = test_layer(np.array([1.0, 2.0, 3.0]))
+        np.testing.assert_allclose(outputs.data, [6.5, 5.5])
+        assert test_layer.get_parameters()[0].data == 1.0
+
+        outputs.backwards()
+        np.testing.assert_allclose(test_layer.weights.grad, [[1, 2, 3], [1, 2, 3]])
+        test_layer.zero_grad()
+        assert not test_layer.weights.grad.any()
+
+    def test_zero_copy(self):
+        x = np.array([1.0, 2.0, 3.0])
+        tensor = ng.Tensor(x)
+        x[0] = 5.0
+        assert tensor.data[0] == 5.0
+
+    def test_read_only_copy(self):
+        x = np.array([1.0, 2.0, 3.0])
+        x.setflags(write=False)
+        tensor = ng.Tensor(x)
+        tensor.data[0] = 5.0
+        assert x[0] == 1.0
+
+
+class TestThreads:
+    def test_independent_models(self):
+        models = [ng.MultiLayerPerceptron(4, [16, 16, 2]) for _ in range(4)]
+        batch = np.arange(32.0).reshape(8, 4) / 32.0
+
+        def run(model):
+            outputs = model(batch)
+            outputs.backwards()
+            return outputs.data.copy(), model.layers[0].weights.grad.copy()
+
+        expected = []
+        for model in models:
+            expected.append(run(model))
+            model.zero_grad()
+
+        with ThreadPoolExecutor(max_workers=4) as pool:
+            results = list(pool.map(run, models))
+        for (outputs, grads), (expected_outputs, expected_grads) in zip(
+            results, expected
+        ):
+            np.testing.assert_allclose(outputs, expected_outputs)
+            np.testing.assert_allclose(grads, expected_grads)
+
+
+class TestDataParallelTrainer:
+    def test_training(self):
+        rng = np.random.default_rng(0)
+        inputs = rng.uniform(-1, 1, size=(64, 3))
+        targets = inputs @ np.array([[1.0], [-2.0], [0.5]]) + 0.25
+        test_mlp = ng.MultiLayerPerceptron(3, [8, 1])
+        trainer = ng.DataParallelTrainer(test_mlp, num_workers=4, learning_rate=0.05)
+        assert trainer.num_workers == 4
+        first_loss = trainer.step(inputs, targets)
+        for _ in range(100):
+            last_loss = trainer.step(inputs, targets)
+        assert last_loss < first_loss
+
+
+class TestSaving:
+    def test_save_and_load(self, tmp_path):
+        path = str(tmp_path / "model.bin")
+        test_mlp = ng.MultiLayerPerceptron(3, [4, 2])
+        optimizer = ng.Adam(test_mlp.get_parameter_tensors())
+        test_mlp(np.array([1.0, -1.0, 0.5])).sum().backwards()
+        optimizer.step(zero_grad=True)
+        test_mlp.save(path, optimizer)
+
+        loaded = ng.MultiLayerPerceptron.load(path)
+        np.testing.assert_array_equal(
+            loaded.get_flat_parameters().data, test_mlp.get_flat_parameters().data
+        )
+        restored = ng.Adam(loaded.get_parameter_tensors())
+        ng.MultiLayerPerceptron.load_optimizer_state(path, restored)
+        assert restored.get_state() == optimizer.get_state()
+
+
+class TestInitialization:
+    def test_seeded(self):
+        first = ng.MultiLayerPerceptron(4, [8, 1], ng.Initialization.He, seed=3)
+        second = ng.MultiLayerPerceptron(4, [8, 1], ng.Initialization.He, seed=3)
+        np.testing.assert_array_equal(
+            first.get_flat_parameters().data, second.get_flat_parameters().data
+        )
+        bound = np.sqrt(6.0 / 4.0)
+        assert np.abs(first.layers[0].weights.data).max() <= bound
+
+
+class TestForwardMode:
+    def test_matches_backwards(self):
+        test_mlp = ng.MultiLayerPerceptron(2, [4, 1], seed=1)
+        inputs = [ng.Value(0.5), ng.Value(-1.0)]
+        test_mlp(inputs)[0].backwards()
+        outputs = test_mlp([ng.Dual(0.5, 1.0), ng.Dual(-1.0)])
+        assert outputs[0].tangent == pytest.approx(inputs[0].grad)
@@ -0,0 +1,56 @@
+# External Imports
+import numpy as np
+import pytest
+
+# Local Imports
+import nanograd_bgriebel as ng
+
+
+class TestSGD:
+    def test_step(self):
+        param = ng.Tensor(np.array([1.0, 2.0]))
+        param.sum().backwards()
+        optimizer = ng.SGD([param], learning_rate=0.5)
+        optimizer.step()
+        assert list(param.data) == pytest.approx([0.5, 1.5])
+        assert list(param.grad) == pytest.approx([1.0, 1.0])
+        optimizer.step(zero_grad=True)
+        assert list(param.data) == pytest.approx([0.0, 1.0])
+        assert list(param.grad) == pytest.approx([0.0, 0.0])
+
+    def test_momentum(self):
+        param = ng.Tensor(np.array([1.0]))
+        param.sum().backwards()
+        optimizer = ng.SGD([param], learning_rate=0.1, momentum=0.9)
+        optimizer.step()
+        optimizer.step()
+        # Velocity is 1 then 1.9
+        assert param.data[0] == pytest.approx(1.0 - 0.1 - 0.19)
+
+    def test_learning_rate(self):
+        optimizer = ng.SGD([ng.Tensor(np.zeros(1))], learning_rate=0.1)
+        optimizer.learning_rate = 0.01
+        assert optimizer.learning_rate == pytest.approx(0.01)
+
+
+class TestAdam:
+    def test_first_step(self):
+        param = ng.Tensor(np.array([1.0, -1.0]))
+        (param * param).sum().backwards()
+        optimizer = ng.Adam([param], learning_rate=0.1)
+        optimizer.step(zero_grad=True)
+        # The first step of Adam moves every parameter by the learning rate
+        assert list(param.data) == pytest.approx([0.9, -0.9], abs=1e-6)
+        assert list(param.grad) == pytest.approx([0.0, 0.0])
+
+    def test_training(self):
+        rng = np.random.default_rng(0)
+        inputs = rng.uniform(-1, 1, size=(64, 3))
+        targets = inputs @ np.array([[1.0], [-2.0], [0.5]]) + 0.25
+        test_mlp = ng.MultiLayerPerceptron(3, [8, 1])
+        optimizer = ng.Adam(test_mlp.get_parameter_tensors(), learning_rate=0.01)
+        trainer = ng.DataParallelTrainer(test_mlp, 4, optimizer)
+        first_loss = trainer.step(inputs, targets)
+        for _ in range(100):
+            last_loss = trainer.step(inputs, targets)
+        assert last_loss < first_loss
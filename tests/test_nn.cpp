@@ -1,5 +1,11 @@
 // Standard Library Includes
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
 
 // External Includes
 #include "catch2/catch_test_macros.hpp"
@@ -7,6 +13,10 @@
 
 // Local Includes
 #include "nn.h"
+#include "optim.h"
+#include "philox.h"
+#include "profiler.h"
+#include "thread_pool.h"
 
 TEST_CASE("Creating Modules", "[nn]") {
     SECTION("Creating Neurons") {
@@ -16,7 +26,7 @@ TEST_CASE("Creating Modules", "[nn]") {
         // Check that there are 6 parameters (5 weights and 1 bias)
         CHECK(testNeuron.get_parameters().size() == 6);
         const auto parameters = testNeuron.get_parameters();
-        for (int idx = 0; idx < parameters.size()-1; idx++) {
+        for (std::size_t idx = 0; idx < parameters.size()-1; idx++) {
             // For all the weights, check that they are not 0.
             CHECK(std::abs(parameters[idx].get_data())>margin);
         }
@@ -112,4 +122,503 @@ TEST_CASE("Creating Modules", "[nn]") {
             ++idx;
         }
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Running Modules on Tensors", "[nn]") {
+    SECTION("Layer matches the Value graph") {
+        Layer testLayer{3, 4, true};
+        const double margin = 0.0000001;
+
+        const std::vector<Value> inputs{Value{0.5}, Value{-1.0}, Value{2.0}};
+        const std::vector<Value> outputs = testLayer(inputs);
+        Value loss{0.0};
+        for (auto &output: outputs) {
+            loss = loss + output;
+        }
+        loss.backwards();
+        std::vector<double> expectedGrads;
+        for (auto &param: testLayer.get_parameters()) {
+            expectedGrads.push_back(param.get_grad());
+        }
+        testLayer.zero_grad();
+
+        const Tensor tensorOutputs = testLayer(Tensor{{3}, {0.5, -1.0, 2.0}});
+        REQUIRE(tensorOutputs.size() == 4);
+        for (std::size_t idx = 0; idx < 4; ++idx) {
+            CHECK_THAT(tensorOutputs.get_data()[idx], Catch::Matchers::WithinAbs(outputs[idx].get_data(), margin));
+        }
+        tensorOutputs.backwards();
+        int idx = 0;
+        for (auto &param: testLayer.get_parameters()) {
+            CHECK_THAT(param.get_grad(), Catch::Matchers::WithinAbs(expectedGrads[idx], margin));
+            ++idx;
+        }
+    }
+
+    SECTION("Layer runs in float") {
+        const Layer testLayer{5, 4, true, Initialization::Uniform, 42};
+        const FloatLayer floatLayer{5, 4, true, Initialization::Uniform, 42};
+        const Tensor inputs{{2, 5}, {0.5, -1.0, 2.0, 0.3, -0.2, 1.0, 0.1, -0.4, 0.8, 0.6}};
+        const Tensor outputs = testLayer(inputs);
+        outputs.backwards();
+
+        // The same seed gives the same weights, rounded to float
+        const FloatTensor floatInputs = inputs.cast<float>();
+        const FloatTensor floatOutputs = floatLayer(floatInputs);
+        REQUIRE(floatOutputs.get_shape() == outputs.get_shape());
+        for (std::size_t idx = 0; idx < outputs.size(); ++idx) {
+            CHECK_THAT(floatOutputs.get_data()[idx], Catch::Matchers::WithinAbs(outputs.get_data()[idx], 0.0001));
+        }
+        // The gradients are accumulated into the float parameters
+        floatOutputs.backwards();
+        const auto grads = testLayer.get_parameter_grads();
+        const auto floatGrads = floatLayer.get_parameter_grads();
+        REQUIRE(floatGrads.size() == grads.size());
+        for (std::size_t idx = 0; idx < grads.size(); ++idx) {
+            CHECK_THAT(floatGrads[idx], Catch::Matchers::WithinAbs(grads[idx], 0.0001));
+        }
+
+        // The float weights are used as they are, without being converted on every call
+        Profiler::start();
+        const FloatTensor again = floatLayer(floatInputs);
+        Profiler::stop();
+        const ProfileReport report = Profiler::report();
+        CHECK(report.operations.contains("Tensor @T"));
+        CHECK_FALSE(report.operations.contains("Tensor cast"));
+        CHECK(again.get_data()[0] == floatOutputs.get_data()[0]);
+
+        // Updates to the parameters are seen by the next call
+        floatLayer.get_parameter_data()[20] += 1.0f;
+        CHECK(floatLayer(floatInputs).get_data()[0] != floatOutputs.get_data()[0]);
+    }
+
+    SECTION("MultiLayerPerceptron trains in float") {
+        const MultiLayerPerceptron mlp{3, {8, 2}, Initialization::Uniform, 7};
+        const FloatMultiLayerPerceptron floatMlp = mlp.cast<float>();
+        const Tensor inputs{{4, 3}, {0.5, -1.0, 2.0, 0.3, -0.2, 1.0, 0.1, -0.4, 0.8, 0.6, 0.2, -0.9}};
+        const FloatTensor floatInputs = inputs.cast<float>();
+        const Tensor outputs = mlp(inputs);
+        const FloatTensor floatOutputs = floatMlp(floatInputs);
+        for (std::size_t idx = 0; idx < outputs.size(); ++idx) {
+            CHECK_THAT(floatOutputs.get_data()[idx], Catch::Matchers::WithinAbs(outputs.get_data()[idx], 0.0001));
+        }
+        // The cast copies the parameters, so the two models are independent
+        floatMlp.get_parameter_data()[0] += 1.0f;
+        CHECK(mlp.get_parameter_data()[0] != static_cast<double>(floatMlp.get_parameter_data()[0]));
+        floatMlp.get_parameter_data()[0] -= 1.0f;
+
+        FloatSGD optimizer{floatMlp.get_parameter_tensors(), 0.05};
+        const auto loss = [&]() { return floatMlp(floatInputs).pow(2.0).sum(); };
+        const float initialLoss = loss().get_data()[0];
+        for (int step = 0; step < 20; ++step) {
+            const FloatTensor stepLoss = loss();
+            stepLoss.backwards();
+            optimizer.step();
+        }
+        CHECK(loss().get_data()[0] < initialLoss);
+    }
+
+    SECTION("Parameters view the Layer") {
+        Layer testLayer{2, 2, false};
+        const double margin = 0.0000001;
+        auto parameters = testLayer.get_parameters();
+        // The parameters are ordered neuron by neuron, weights then bias
+        parameters[0].set_data(1.0);
+        parameters[1].set_data(2.0);
+        parameters[2].set_data(3.0);
+        parameters[3].set_data(-1.0);
+        parameters[4].set_data(0.5);
+        parameters[5].set_data(0.0);
+        CHECK_THAT(testLayer.get_weights().get_data()[1], Catch::Matchers::WithinAbs(2.0, margin));
+        CHECK_THAT(testLayer.get_biases().get_data()[0], Catch::Matchers::WithinAbs(3.0, margin));
+
+        const Tensor outputs = testLayer(Tensor{{2}, {1.0, 1.0}});
+        CHECK_THAT(outputs.get_data()[0], Catch::Matchers::WithinAbs(6.0, margin));
+        CHECK_THAT(outputs.get_data()[1], Catch::Matchers::WithinAbs(-0.5, margin));
+
+        CHECK_THROWS_AS(testLayer(std::vector<Value>{Value{1.0}}), std::runtime_error);
+    }
+
+    SECTION("MultiLayerPerceptron matches the Value graph") {
+        MultiLayerPerceptron testMultiLayerPerceptron{3, std::vector{8, 6, 2}};
+        const double margin = 0.0000001;
+
+        const std::vector<Value> inputs{Value{0.5}, Value{-1.0}, Value{2.0}};
+        const std::vector<Value> outputs = testMultiLayerPerceptron(inputs);
+        const Tensor tensorOutputs = testMultiLayerPerceptron(Tensor{{3}, {0.5, -1.0, 2.0}});
+        REQUIRE(tensorOutputs.size() == 2);
+        CHECK_THAT(tensorOutputs.get_data()[0], Catch::Matchers::WithinAbs(outputs[0].get_data(), margin));
+        CHECK_THAT(tensorOutputs.get_data()[1], Catch::Matchers::WithinAbs(outputs[1].get_data(), margin));
+    }
+
+    SECTION("Predicting without a graph") {
+        MultiLayerPerceptron testMultiLayerPerceptron{3, std::vector{8, 6, 2}};
+        const double margin = 0.0000001;
+
+        const std::vector<Value> inputs{Value{0.5}, Value{-1.0}, Value{2.0}};
+        const std::vector<Value> expected = testMultiLayerPerceptron(inputs);
+        NoGradGuard guard{};
+        const std::vector<Value> outputs = testMultiLayerPerceptron(inputs);
+        const Tensor tensorOutputs = testMultiLayerPerceptron(Tensor{{2, 3}, {0.5, -1.0, 2.0, 0.5, -1.0, 2.0}});
+        for (std::size_t idx = 0; idx < 2; ++idx) {
+            CHECK_THAT(outputs[idx].get_data(), Catch::Matchers::WithinAbs(expected[idx].get_data(), margin));
+            CHECK_THAT(tensorOutputs.get_data()[2 + idx],
+                       Catch::Matchers::WithinAbs(expected[idx].get_data(), margin));
+        }
+        // Nothing links the outputs back to the parameters
+        outputs[0].backwards();
+        tensorOutputs.backwards();
+        for (const double grad: testMultiLayerPerceptron.get_parameter_grads()) {
+            CHECK(grad == 0.0);
+        }
+    }
+}
+
+TEST_CASE("Running Modules on Batches", "[nn]") {
+    SECTION("MultiLayerPerceptron matches each sample") {
+        MultiLayerPerceptron testMultiLayerPerceptron{3, std::vector{8, 6, 2}};
+        const double margin = 0.0000001;
+        const std::vector<std::vector<double> > samples{{0.5, -1.0, 2.0}, {1.5, 0.25, -0.5}, {-0.5, 1.0, 1.0}};
+
+        // Accumulate the gradients of every sample one at a time
+        std::vector<std::vector<double> > expectedOutputs;
+        for (const auto &sample: samples) {
+            const Tensor outputs = testMultiLayerPerceptron(Tensor{{3}, sample});
+            expectedOutputs.emplace_back(outputs.get_data().begin(), outputs.get_data().end());
+            outputs.backwards();
+        }
+        std::vector<double> expectedGrads;
+        for (auto &param: testMultiLayerPerceptron.get_parameters()) {
+            expectedGrads.push_back(param.get_grad());
+        }
+        testMultiLayerPerceptron.zero_grad();
+
+        std::vector<double> batchData;
+        for (const auto &sample: samples) {
+            batchData.insert(batchData.end(), sample.begin(), sample.end());
+        }
+        const Tensor outputs = testMultiLayerPerceptron(Tensor{{3, 3}, batchData});
+        REQUIRE(outputs.get_shape() == std::vector<std::size_t>{3, 2});
+        for (std::size_t row = 0; row < 3; ++row) {
+            for (std::size_t col = 0; col < 2; ++col) {
+                CHECK_THAT(outputs.get_data()[row * 2 + col],
+                           Catch::Matchers::WithinAbs(expectedOutputs[row][col], margin));
+            }
+        }
+        // A single backward pass collects the gradients of the whole batch
+        outputs.backwards();
+        int idx = 0;
+        for (auto &param: testMultiLayerPerceptron.get_parameters()) {
+            CHECK_THAT(param.get_grad(), Catch::Matchers::WithinAbs(expectedGrads[idx], margin));
+            ++idx;
+        }
+    }
+}
+
+TEST_CASE("Checkpointing Modules", "[nn]") {
+    SECTION("Checkpointed MultiLayerPerceptron matches the full graph") {
+        MultiLayerPerceptron testMultiLayerPerceptron{3, std::vector{6, 6, 6, 6, 6, 2}};
+        const double margin = 0.0000001;
+        const std::vector<Value> inputs{Value{0.5}, Value{-1.0}, Value{2.0}};
+
+        const std::vector<Value> outputs = testMultiLayerPerceptron(inputs);
+        (outputs[0] + outputs[1] * 2.0).backwards(false);
+        const std::span<const double> currentGrads = testMultiLayerPerceptron.get_parameter_grads();
+        const std::vector<double> expectedGrads(currentGrads.begin(), currentGrads.end());
+        const double expectedInputGrad = inputs[2].get_grad();
+        testMultiLayerPerceptron.zero_grad();
+        inputs[2].zero_grad();
+
+        const std::vector<Value> checkpointed = testMultiLayerPerceptron.checkpointed(inputs, 2);
+        REQUIRE(checkpointed.size() == 2);
+        CHECK_THAT(checkpointed[0].get_data(), Catch::Matchers::WithinAbs(outputs[0].get_data(), margin));
+        CHECK_THAT(checkpointed[1].get_data(), Catch::Matchers::WithinAbs(outputs[1].get_data(), margin));
+        (checkpointed[0] + checkpointed[1] * 2.0).backwards(false);
+        const std::span<const double> grads = testMultiLayerPerceptron.get_parameter_grads();
+        for (std::size_t idx = 0; idx < grads.size(); ++idx) {
+            CHECK_THAT(grads[idx], Catch::Matchers::WithinAbs(expectedGrads[idx], margin));
+        }
+        CHECK_THAT(inputs[2].get_grad(), Catch::Matchers::WithinAbs(expectedInputGrad, margin));
+        CHECK_THROWS_AS(testMultiLayerPerceptron.checkpointed(inputs, 0), std::runtime_error);
+    }
+}
+
+TEST_CASE("Training on Several Threads", "[nn]") {
+    ThreadPool pool{3};
+    const double margin = 0.0000001;
+    // y = x0 - 2 x1 + 0.5 on a small grid
+    std::vector<double> inputData, targetData;
+    for (int idx = 0; idx < 30; ++idx) {
+        const double x0 = (idx % 6) / 3.0 - 1.0;
+        const double x1 = (idx / 6) / 2.0 - 1.0;
+        inputData.insert(inputData.end(), {x0, x1});
+        targetData.push_back(x0 - 2.0 * x1 + 0.5);
+    }
+    const Tensor inputs{{30, 2}, inputData};
+    const Tensor targets{{30, 1}, targetData};
+
+    SECTION("Gradients match a single pass over the batch") {
+        MultiLayerPerceptron testMultiLayerPerceptron{2, std::vector{8, 1}};
+        // Reference gradient of the mean squared error over the whole batch
+        const Tensor outputs = testMultiLayerPerceptron(inputs);
+        std::vector<double> seeds(30);
+        double expectedLoss = 0.;
+        for (std::size_t idx = 0; idx < 30; ++idx) {
+            const double error = outputs.get_data()[idx] - targetData[idx];
+            expectedLoss += error * error / 30.0;
+            seeds[idx] = 2.0 * error / 30.0;
+        }
+        outputs.backwards(seeds);
+        std::vector<double> expectedGrads, oldData;
+        for (auto &param: testMultiLayerPerceptron.get_parameters()) {
+            expectedGrads.push_back(param.get_grad());
+            oldData.push_back(param.get_data());
+        }
+        testMultiLayerPerceptron.zero_grad();
+
+        DataParallelTrainer trainer{testMultiLayerPerceptron, 4, 0.1, pool};
+        CHECK(trainer.get_num_workers() == 4);
+        CHECK_THAT(trainer.step(inputs, targets), Catch::Matchers::WithinAbs(expectedLoss, margin));
+        int idx = 0;
+        for (auto &param: testMultiLayerPerceptron.get_parameters()) {
+            CHECK_THAT(param.get_grad(), Catch::Matchers::WithinAbs(expectedGrads[idx], margin));
+            CHECK_THAT(param.get_data(), Catch::Matchers::WithinAbs(oldData[idx] - 0.1 * expectedGrads[idx], margin));
+            ++idx;
+        }
+    }
+
+    SECTION("Training reduces the loss") {
+        MultiLayerPerceptron testMultiLayerPerceptron{2, std::vector{8, 1}};
+        DataParallelTrainer trainer{testMultiLayerPerceptron, 3, 0.05, pool};
+        const double firstLoss = trainer.step(inputs, targets);
+        double lastLoss = firstLoss;
+        for (int epoch = 0; epoch < 100; ++epoch) {
+            lastLoss = trainer.step(inputs, targets);
+        }
+        CHECK(lastLoss < firstLoss);
+        CHECK_THROWS_AS(trainer.step(targets, targets), std::runtime_error);
+    }
+
+    SECTION("Models without layers are rejected") {
+        const MultiLayerPerceptron empty{2, std::vector<int>{}};
+        CHECK_THROWS_AS((DataParallelTrainer{empty, 2, 0.1, pool}), std::runtime_error);
+    }
+}
+
+TEST_CASE("Storing Parameters Contiguously", "[nn]") {
+    const double margin = 0.0000001;
+
+    SECTION("Parameters view a single buffer") {
+        MultiLayerPerceptron testMultiLayerPerceptron{3, std::vector{4, 2}};
+        const auto data = testMultiLayerPerceptron.get_parameter_data();
+        const auto grads = testMultiLayerPerceptron.get_parameter_grads();
+        CHECK(data.size() == 26);
+        CHECK(grads.size() == 26);
+        // The buffer holds the weights of each Layer followed by its biases
+        const auto &layers = testMultiLayerPerceptron.get_layers();
+        CHECK(layers[0].get_weights().get_data().data() == data.data());
+        CHECK(layers[0].get_biases().get_data().data() == data.data() + 12);
+        CHECK(layers[1].get_weights().get_data().data() == data.data() + 16);
+        CHECK(layers[1].get_parameter_grads().data() == grads.data() + 16);
+
+        // Gradients computed through the Values land in the buffer, and zero_grad clears them all
+        const auto outputs = testMultiLayerPerceptron({Value{1.0}, Value{-1.0}, Value{0.5}});
+        (outputs[0] + outputs[1]).backwards();
+        // The gradient of the bias of the second Layer is always 1
+        CHECK_THAT(grads[24], Catch::Matchers::WithinAbs(1.0, margin));
+        testMultiLayerPerceptron.zero_grad();
+        for (const double grad: grads) {
+            CHECK(grad == 0.0);
+        }
+
+        // An optimizer over the flat parameters updates every Value
+        for (double &grad: grads) {
+            grad = 1.0;
+        }
+        std::vector<double> oldData;
+        for (auto &param: testMultiLayerPerceptron.get_parameters()) {
+            oldData.push_back(param.get_data());
+        }
+        SGD optimizer{{testMultiLayerPerceptron.get_flat_parameters()}, 0.5};
+        optimizer.step(true);
+        int idx = 0;
+        for (auto &param: testMultiLayerPerceptron.get_parameters()) {
+            CHECK_THAT(param.get_data(), Catch::Matchers::WithinAbs(oldData[idx] - 0.5, margin));
+            CHECK(param.get_grad() == 0.0);
+            ++idx;
+        }
+    }
+
+    SECTION("Replicas share the data but not the gradients") {
+        MultiLayerPerceptron testMultiLayerPerceptron{2, std::vector{3, 1}};
+        const MultiLayerPerceptron replica = testMultiLayerPerceptron.replicate();
+        CHECK(replica.get_parameter_data().data() == testMultiLayerPerceptron.get_parameter_data().data());
+        CHECK(replica.get_parameter_grads().data() != testMultiLayerPerceptron.get_parameter_grads().data());
+        replica.get_parameter_grads()[0] = 1.0;
+        CHECK(testMultiLayerPerceptron.get_parameter_grads()[0] == 0.0);
+    }
+
+    SECTION("Modules move existing Values into a buffer") {
+        const Value x{2.0};
+        const Value y{-3.0};
+        const Module testModule{{x, y}};
+        CHECK(testModule.get_parameter_data()[0] == 2.0);
+        CHECK(testModule.get_parameter_data()[1] == -3.0);
+        (x * y).backwards();
+        CHECK(testModule.get_parameter_grads()[0] == -3.0);
+        CHECK(testModule.get_parameter_grads()[1] == 2.0);
+        testModule.zero_grad();
+        CHECK(x.get_grad() == 0.0);
+        CHECK(y.get_grad() == 0.0);
+        testModule.get_parameter_data()[0] = 5.0;
+        CHECK(x.get_data() == 5.0);
+    }
+
+    SECTION("Modules can't take over the parameters of another Module") {
+        const MultiLayerPerceptron perceptron{2, std::vector{3, 1}};
+        const Value x{1.0};
+        CHECK_THROWS_AS(Module{perceptron.get_parameters()}, std::runtime_error);
+        CHECK_THROWS_AS((Module{{x, perceptron.get_parameters()[0]}}), std::runtime_error);
+        // Nothing was moved, so the perceptron still sees its parameters
+        CHECK_FALSE(x.is_view());
+        perceptron.get_parameters()[0].set_data(100.0);
+        CHECK(perceptron.get_parameter_data()[0] == 100.0);
+        perceptron(std::vector{Value{1.0}, Value{-1.0}})[0].backwards();
+        CHECK(perceptron.get_parameter_grads()[0] == perceptron.get_parameters()[0].get_grad());
+    }
+}
+
+TEST_CASE("Saving and Loading Modules", "[nn]") {
+    const std::string path = (std::filesystem::temp_directory_path() / "nanograd_test_model.bin").string();
+    const std::vector inputs{Value{1.0}, Value{-1.0}, Value{0.5}};
+
+    SECTION("Loaded MultiLayerPerceptron matches the saved one") {
+        const MultiLayerPerceptron saved{3, std::vector{4, 4, 2}};
+        saved.save(path);
+        const MultiLayerPerceptron loaded = MultiLayerPerceptron::load(path);
+        CHECK(loaded.get_nin() == 3);
+        REQUIRE(loaded.get_layers().size() == 3);
+        CHECK(loaded.get_layers()[1].get_weights().get_shape() == std::vector<std::size_t>{4, 4});
+        CHECK(std::ranges::equal(loaded.get_parameter_data(), saved.get_parameter_data()));
+        const auto savedOutputs = saved(inputs);
+        const auto loadedOutputs = loaded(inputs);
+        CHECK(loadedOutputs[0].get_data() == savedOutputs[0].get_data());
+        CHECK(loadedOutputs[1].get_data() == savedOutputs[1].get_data());
+
+        // The loaded parameters can be trained, and saved back over the file they were loaded from
+        (loadedOutputs[0] + loadedOutputs[1]).backwards();
+        SGD optimizer{loaded.get_parameter_tensors(), 0.1};
+        optimizer.step(true);
+        loaded.save(path);
+        const MultiLayerPerceptron reloaded = MultiLayerPerceptron::load(path);
+        CHECK(std::ranges::equal(reloaded.get_parameter_data(), loaded.get_parameter_data()));
+        CHECK_FALSE(std::ranges::equal(reloaded.get_parameter_data(), saved.get_parameter_data()));
+    }
+
+    SECTION("Optimizer state is restored") {
+        const MultiLayerPerceptron saved{3, std::vector{4, 1}};
+        Adam optimizer{saved.get_parameter_tensors(), 0.01};
+        saved(inputs)[0].backwards();
+        optimizer.step(true);
+        saved.save(path, optimizer);
+
+        const MultiLayerPerceptron loaded = MultiLayerPerceptron::load(path);
+        Adam restored{loaded.get_parameter_tensors(), 0.01};
+        MultiLayerPerceptron::load_optimizer_state(path, restored);
+        CHECK(restored.get_state() == optimizer.get_state());
+
+        // Both take the same next step
+        saved(inputs)[0].backwards();
+        optimizer.step(true);
+        loaded(inputs)[0].backwards();
+        restored.step(true);
+        CHECK(std::ranges::equal(loaded.get_parameter_data(), saved.get_parameter_data()));
+
+        SGD mismatched{loaded.get_parameter_tensors(), 0.1, 0.9};
+        CHECK_THROWS_AS(MultiLayerPerceptron::load_optimizer_state(path, mismatched), std::runtime_error);
+        saved.save(path);
+        CHECK_THROWS_AS(MultiLayerPerceptron::load_optimizer_state(path, restored), std::runtime_error);
+    }
+
+    SECTION("Invalid files are rejected") {
+        const MultiLayerPerceptron saved{3, std::vector{2, 1}};
+        saved.save(path);
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - sizeof(double));
+        CHECK_THROWS_AS(MultiLayerPerceptron::load(path), std::runtime_error);
+        {
+            std::ofstream file{path, std::ios::binary | std::ios::trunc};
+            file << "not a model";
+        }
+        CHECK_THROWS_AS(MultiLayerPerceptron::load(path), std::runtime_error);
+        std::filesystem::remove(path);
+        CHECK_THROWS_AS(MultiLayerPerceptron::load(path), std::runtime_error);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Initializing Parameters", "[nn]") {
+    SECTION("Philox matches the reference implementation") {
+        // Known answers of Philox4x32-10 from Random123
+        CHECK(Philox::block({0, 0, 0, 0}, {0, 0}) ==
+              std::array<std::uint32_t, 4>{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+        CHECK(Philox::block({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}) ==
+              std::array<std::uint32_t, 4>{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+        CHECK(Philox::block({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}) ==
+              std::array<std::uint32_t, 4>{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+    }
+
+    SECTION("Streams can be generated in any order") {
+        std::vector<double> whole(101);
+        Philox::uniform(whole.data(), whole.size(), 0, -1.0, 1.0, 42, 3);
+        std::vector<double> pieces(101);
+        Philox::uniform(pieces.data() + 37, 64, 37, -1.0, 1.0, 42, 3);
+        Philox::uniform(pieces.data(), 37, 0, -1.0, 1.0, 42, 3);
+        CHECK(whole == pieces);
+        for (const double value: whole) {
+            CHECK(value >= -1.0);
+            CHECK(value < 1.0);
+        }
+        std::vector<double> otherStream(101);
+        Philox::uniform(otherStream.data(), otherStream.size(), 0, -1.0, 1.0, 42, 4);
+        CHECK(whole != otherStream);
+    }
+
+    SECTION("Seeded Modules are reproducible") {
+        // Wide enough to be split between several threads
+        const MultiLayerPerceptron first{300, std::vector{200, 10}, Initialization::Xavier, 7};
+        const MultiLayerPerceptron second{300, std::vector{200, 10}, Initialization::Xavier, 7};
+        CHECK(std::ranges::equal(first.get_parameter_data(), second.get_parameter_data()));
+        const MultiLayerPerceptron reseeded{300, std::vector{200, 10}, Initialization::Xavier, 8};
+        CHECK_FALSE(std::ranges::equal(first.get_parameter_data(), reseeded.get_parameter_data()));
+
+        // Layer i of a MultiLayerPerceptron uses stream i, so the first Layer matches a lone Layer
+        const Layer layer{300, 200, true, Initialization::Xavier, 7};
+        CHECK(std::ranges::equal(layer.get_weights().get_data(), first.get_layers()[0].get_weights().get_data()));
+
+        const Neuron neuron{4, true, Initialization::He, 7};
+        const Neuron sameNeuron{4, true, Initialization::He, 7};
+        CHECK(neuron.get_parameters()[3].get_data() == sameNeuron.get_parameters()[3].get_data());
+    }
+
+    SECTION("Schemes scale the weights") {
+        const Layer xavier{300, 100, true, Initialization::Xavier, 1};
+        const Layer he{300, 100, true, Initialization::He, 1};
+        const double xavierBound = std::sqrt(6.0 / 400.0);
+        const double heBound = std::sqrt(6.0 / 300.0);
+        double xavierMax = 0.;
+        double heMax = 0.;
+        for (const double weight: xavier.get_weights().get_data()) {
+            xavierMax = std::max(xavierMax, std::abs(weight));
+        }
+        for (const double weight: he.get_weights().get_data()) {
+            heMax = std::max(heMax, std::abs(weight));
+        }
+        CHECK(xavierMax <= xavierBound);
+        CHECK(xavierMax > 0.9 * xavierBound);
+        CHECK(heMax <= heBound);
+        CHECK(heMax > 0.9 * heBound);
+        for (const double bias: he.get_biases().get_data()) {
+            CHECK(bias == 0.0);
+        }
+    }
+}
@@ -0,0 +1,113 @@
+// Standard Library Includes
+#include <cmath>
+#include <vector>
+
+// External Includes
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+
+// Local Includes
+#include "nn.h"
+#include "optim.h"
+#include "tensor.h"
+
+TEST_CASE("Updating Parameters", "[optim]") {
+    double margin = 0.0000001;
+    // Sizes which aren't multiples of the SIMD width
+    const std::vector<double> startData{1.0, -2.0, 0.5, 3.0, -1.5, 0.25, 2.0, -0.75, 1.25, -3.0, 0.1};
+    const std::vector<double> gradData{0.5, 1.0, -0.25, 2.0, -1.0, 0.0, 0.75, -0.5, 1.5, 0.3, -2.0};
+
+    const auto makeParams = [&]() {
+        Tensor a{{2, 4}, std::vector<double>(startData.begin(), startData.begin() + 8)};
+        Tensor b{{3}, std::vector<double>(startData.begin() + 8, startData.end())};
+        std::ranges::copy(gradData.begin(), gradData.begin() + 8, a.get_grad().begin());
+        std::ranges::copy(gradData.begin() + 8, gradData.end(), b.get_grad().begin());
+        return std::vector<Tensor>{a, b};
+    };
+    const auto flatData = [](const std::vector<Tensor> &params) {
+        std::vector<double> out;
+        for (const auto &param: params) {
+            out.insert(out.end(), param.get_data().begin(), param.get_data().end());
+        }
+        return out;
+    };
+
+    SECTION("Gradient Descent") {
+        const auto params = makeParams();
+        SGD optimizer{params, 0.1};
+        optimizer.step(true);
+        const auto data = flatData(params);
+        for (std::size_t idx = 0; idx < data.size(); ++idx) {
+            CHECK_THAT(data[idx], Catch::Matchers::WithinAbs(startData[idx] - 0.1 * gradData[idx], margin));
+        }
+        // The gradients were zeroed in the same pass
+        for (const auto &param: params) {
+            for (const double g: param.get_grad()) {
+                CHECK_THAT(g, Catch::Matchers::WithinAbs(0.0, margin));
+            }
+        }
+    }
+
+    SECTION("Momentum") {
+        const auto params = makeParams();
+        SGD optimizer{params, 0.1, 0.9};
+        optimizer.step();
+        // The gradients are kept, so the second step sees the same gradient again
+        optimizer.step();
+        const auto data = flatData(params);
+        for (std::size_t idx = 0; idx < data.size(); ++idx) {
+            // velocity is g, then 0.9 g + g
+            const double expected = startData[idx] - 0.1 * gradData[idx] - 0.1 * 1.9 * gradData[idx];
+            CHECK_THAT(data[idx], Catch::Matchers::WithinAbs(expected, margin));
+        }
+    }
+
+    SECTION("Adam") {
+        const auto params = makeParams();
+        Adam optimizer{params, 0.01};
+        std::vector<double> expected = startData;
+        std::vector<double> m(startData.size(), 0.), v(startData.size(), 0.);
+        for (int t = 1; t <= 3; ++t) {
+            optimizer.step();
+            for (std::size_t idx = 0; idx < expected.size(); ++idx) {
+                const double g = gradData[idx];
+                m[idx] = 0.9 * m[idx] + 0.1 * g;
+                v[idx] = 0.999 * v[idx] + 0.001 * g * g;
+                const double mHat = m[idx] / (1.0 - std::pow(0.9, t));
+                const double vHat = v[idx] / (1.0 - std::pow(0.999, t));
+                expected[idx] -= 0.01 * mHat / (std::sqrt(vHat) + 1e-8);
+            }
+        }
+        const auto data = flatData(params);
+        for (std::size_t idx = 0; idx < data.size(); ++idx) {
+            CHECK_THAT(data[idx], Catch::Matchers::WithinAbs(expected[idx], margin));
+        }
+    }
+
+    SECTION("Training a MultiLayerPerceptron") {
+        MultiLayerPerceptron testMultiLayerPerceptron{2, std::vector{8, 1}};
+        Adam optimizer{testMultiLayerPerceptron.get_parameter_tensors(), 0.01};
+        // Fit y = x0 - x1 on a few points
+        const Tensor inputs{{4, 2}, {0., 0., 1., 0., 0., 1., 1., 1.}};
+        const std::vector<double> targets{0., 1., -1., 0.};
+        const auto lossStep = [&]() {
+            const Tensor outputs = testMultiLayerPerceptron(inputs);
+            std::vector<double> seeds(4);
+            double loss = 0.;
+            for (std::size_t idx = 0; idx < 4; ++idx) {
+                const double error = outputs.get_data()[idx] - targets[idx];
+                loss += error * error;
+                seeds[idx] = 2.0 * error;
+            }
+            outputs.backwards(seeds);
+            optimizer.step(true);
+            return loss;
+        };
+        const double firstLoss = lossStep();
+        double lastLoss = firstLoss;
+        for (int idx = 0; idx < 200; ++idx) {
+            lastLoss = lossStep();
+        }
+        CHECK(lastLoss < firstLoss);
+    }
+}
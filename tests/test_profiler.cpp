@@ -0,0 +1,76 @@
+// Standard Library Includes
+#include <string>
+#include <thread>
+#include <vector>
+
+// External Includes
+#include "catch2/catch_test_macros.hpp"
+
+// Local Includes
+#include "engine.h"
+#include "nn.h"
+#include "profiler.h"
+#include "tensor.h"
+
+TEST_CASE("Profiling the Engine", "[profiler]") {
+    SECTION("Counting Nodes and Passes") {
+        Profiler::start();
+        CHECK(Profiler::is_enabled());
+        const Value a{2.0};
+        const Value b{-3.0};
+        const Value c = (a * b + 1.0).relu();
+        c.backwards();
+        Profiler::stop();
+
+        const ProfileReport report = Profiler::report();
+        CHECK(report.operations.at("leaf").nodes == 2);
+        CHECK(report.operations.at("*").nodes == 1);
+        CHECK(report.operations.at("affine").nodes == 1);
+        CHECK(report.operations.at("ReLU").nodes == 1);
+        CHECK(report.nodes == 5);
+        CHECK(report.nodeBytes >= 5 * sizeof(InternalValue));
+        CHECK(report.backwardPasses == 1);
+        // ReLU -> affine -> * -> {a, b}
+        CHECK(report.maxDepth == 3);
+        CHECK(report.maxWidth == 2);
+        CHECK(report.topoSortSeconds >= 0.);
+        CHECK(report.backwardSeconds >= 0.);
+
+        const std::string trace = Profiler::chrome_trace();
+        CHECK(trace.find("\"name\":\"backwards\"") != std::string::npos);
+        CHECK(trace.find("\"name\":\"topo sort\"") != std::string::npos);
+    }
+
+    SECTION("Recording Nothing While Stopped") {
+        Profiler::start();
+        Profiler::stop();
+        CHECK_FALSE(Profiler::is_enabled());
+        const Value a{2.0};
+        (a * a).backwards();
+        const ProfileReport report = Profiler::report();
+        CHECK(report.nodes == 0);
+        CHECK(report.backwardPasses == 0);
+        CHECK(Profiler::chrome_trace() == "{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}");
+    }
+
+    SECTION("Collecting Every Thread") {
+        Profiler::start();
+        std::thread worker{[]() {
+            const Tensor x{{2, 2}, {1.0, 2.0, 3.0, 4.0}};
+            x.matmul(x).sum().backwards();
+        }};
+        worker.join();
+        const MultiLayerPerceptron mlp{2, std::vector{3, 1}};
+        mlp(std::vector{Value{1.0}, Value{0.5}});
+        Profiler::stop();
+
+        const ProfileReport report = Profiler::report();
+        CHECK(report.operations.at("Tensor @").nodes == 1);
+        CHECK(report.operations.at("Tensor sum").nodes == 1);
+        CHECK(report.operations.at("dot").nodes == 4);
+        CHECK(report.backwardPasses == 1);
+        const std::string trace = Profiler::chrome_trace();
+        CHECK(trace.find("\"name\":\"Tensor backwards\"") != std::string::npos);
+        CHECK(trace.find("\"name\":\"MultiLayerPerceptron\"") != std::string::npos);
+    }
+}
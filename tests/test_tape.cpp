@@ -0,0 +1,286 @@
+// Standard Library Includes
+#include <vector>
+
+// External Includes
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+
+// Local Includes
+#include "nn.h"
+#include "tape.h"
+
+TEST_CASE("Calculating Gradients on a Tape", "[tape]") {
+    SECTION("For Basic Operations") {
+        Tape tape{};
+        TapeValue x = tape.value(5.);
+        TapeValue y = tape.value(3.);
+        TapeValue z = x * y + x.pow(2.0) - y.relu();
+        // Define the floating point margin
+        double margin = 0.0000001;
+
+        CHECK_THAT(z.get_data(), Catch::Matchers::WithinAbs(37.0, margin));
+        z.backwards();
+        // dz/dx = y + 2x, dz/dy = x - 1
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(13.0, margin));
+        CHECK_THAT(y.get_grad(), Catch::Matchers::WithinAbs(4.0, margin));
+        CHECK_THAT(z.get_grad(), Catch::Matchers::WithinAbs(1.0, margin));
+    }
+
+    SECTION("More Complex Calculation") {
+        Tape tape{};
+        TapeValue a = tape.value(-4.0);
+        TapeValue b = tape.value(2.0);
+        TapeValue c = a + b;
+        TapeValue d = a * b + b.pow(3.0);
+        c = c + c + 1.0;
+        c = c + 1.0 + c + (-a);
+        d = d + d * 2.0 + (b + a).relu();
+        d = d + 3.0 * d + (b - a).relu();
+        TapeValue e = c - d;
+        TapeValue f = e.pow(2.0);
+        TapeValue g = f / 2.0;
+        g = g + 10.0 / f;
+        // Same calculation as in the engine tests
+        CHECK_THAT(g.get_data(), Catch::Matchers::WithinAbs(24.7041, 0.0001));
+        g.backwards();
+        CHECK_THAT(a.get_grad(), Catch::Matchers::WithinAbs(138.8338, 0.0001));
+        CHECK_THAT(b.get_grad(), Catch::Matchers::WithinAbs(645.5773, 0.0001));
+    }
+
+    SECTION("Accumulating Into Parameters") {
+        Tape tape{};
+        Value w{3.0};
+        TapeValue x = tape.value(2.0);
+        TapeValue wLeaf = tape.parameter(w);
+        TapeValue y = x * wLeaf;
+        double margin = 0.0000001;
+
+        CHECK_THAT(y.get_data(), Catch::Matchers::WithinAbs(6.0, margin));
+        y.backwards();
+        CHECK_THAT(w.get_grad(), Catch::Matchers::WithinAbs(2.0, margin));
+        // Gradients on the tape are recomputed, while the Value accumulates
+        y.backwards();
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(3.0, margin));
+        CHECK_THAT(w.get_grad(), Catch::Matchers::WithinAbs(4.0, margin));
+    }
+
+    SECTION("Replaying the Tape") {
+        Tape tape{};
+        TapeValue x = tape.value(2.0);
+        TapeValue y = tape.value(3.0);
+        TapeValue z = (x * y).relu() + x.pow(2.0);
+        double margin = 0.0000001;
+        CHECK_THAT(z.get_data(), Catch::Matchers::WithinAbs(10.0, margin));
+
+        x.set_data(-1.0);
+        tape.forward();
+        CHECK_THAT(z.get_data(), Catch::Matchers::WithinAbs(1.0, margin));
+        z.backwards();
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(-2.0, margin));
+        CHECK_THAT(y.get_grad(), Catch::Matchers::WithinAbs(0.0, margin));
+    }
+
+    SECTION("Seeding Several Roots") {
+        Tape tape{};
+        TapeValue x = tape.value(2.0);
+        TapeValue a = x * 3.0;
+        TapeValue b = x.pow(2.0);
+        double margin = 0.0000001;
+        const std::vector roots{a, b};
+        const std::vector seeds{1.0, 0.5};
+        tape.backwards(roots, seeds);
+        // 1.0 * 3 + 0.5 * 2x
+        CHECK_THAT(x.get_grad(), Catch::Matchers::WithinAbs(5.0, margin));
+    }
+
+    SECTION("Clearing the Tape") {
+        Tape tape{16};
+        TapeValue x = tape.value(1.0);
+        [[maybe_unused]] const TapeValue y = x + x;
+        CHECK(tape.size() == 2);
+        tape.clear();
+        CHECK(tape.size() == 0);
+        // The memory is kept for the next expression
+        CHECK(tape.capacity() >= 16);
+    }
+
+    SECTION("Mixing Tapes") {
+        Tape first{};
+        Tape second{};
+        TapeValue x = first.value(1.0);
+        TapeValue y = second.value(2.0);
+        CHECK_THROWS_AS(x + y, std::runtime_error);
+    }
+}
+
+TEST_CASE("Optimizing a Tape", "[tape]") {
+    const double margin = 0.0000001;
+    // Same calculation as in "More Complex Calculation"
+    const auto record = [](Tape &tape, const double aData, const double bData) {
+        TapeValue a = tape.value(aData);
+        TapeValue b = tape.value(bData);
+        TapeValue c = a + b;
+        TapeValue d = a * b + b.pow(3.0);
+        c = c + c + 1.0;
+        c = c + 1.0 + c + (-a);
+        d = d + d * 2.0 + (b + a).relu();
+        d = d + 3.0 * d + (b - a).relu();
+        TapeValue e = c - d;
+        TapeValue f = e.pow(2.0);
+        TapeValue g = f / 2.0;
+        g = g + 10.0 / f;
+        return std::vector{a, b, g};
+    };
+
+    SECTION("Matching the Recorded Expression") {
+        Tape tape{};
+        auto nodes = record(tape, -4.0, 2.0);
+        const std::size_t recordedSize = tape.size();
+        std::vector inputs{nodes[0], nodes[1]};
+        std::vector outputs{nodes[2]};
+        tape.optimize(inputs, outputs);
+        CHECK(tape.size() < recordedSize);
+        CHECK_THAT(outputs[0].get_data(), Catch::Matchers::WithinAbs(24.7041, 0.0001));
+        outputs[0].backwards();
+        CHECK_THAT(inputs[0].get_grad(), Catch::Matchers::WithinAbs(138.8338, 0.0001));
+        CHECK_THAT(inputs[1].get_grad(), Catch::Matchers::WithinAbs(645.5773, 0.0001));
+
+        // Replaying with new inputs matches a freshly recorded tape
+        Tape reference{};
+        auto referenceNodes = record(reference, 1.5, -0.5);
+        referenceNodes[2].backwards();
+        inputs[0].set_data(1.5);
+        inputs[1].set_data(-0.5);
+        tape.forward();
+        outputs[0].backwards();
+        CHECK_THAT(outputs[0].get_data(), Catch::Matchers::WithinAbs(referenceNodes[2].get_data(), margin));
+        CHECK_THAT(inputs[0].get_grad(), Catch::Matchers::WithinAbs(referenceNodes[0].get_grad(), margin));
+        CHECK_THAT(inputs[1].get_grad(), Catch::Matchers::WithinAbs(referenceNodes[1].get_grad(), margin));
+    }
+
+    SECTION("Fusing Weighted Sums") {
+        Tape tape{};
+        const std::vector weights{Value{0.5}, Value{-1.0}, Value{2.0}};
+        const Value bias{0.25};
+        std::vector<TapeValue> inputs{tape.value(1.0), tape.value(2.0), tape.value(3.0)};
+        TapeValue sum = tape.parameter(bias);
+        for (std::size_t idx = 0; idx < inputs.size(); ++idx) {
+            sum = sum + inputs[idx] * tape.parameter(weights[idx]);
+        }
+        std::vector outputs{sum};
+        // 7 leaves, 3 products and 3 sums
+        CHECK(tape.size() == 13);
+        tape.optimize(inputs, outputs);
+        // The 7 leaves, a leaf holding 1 for the bias, and a single Dot node
+        CHECK(tape.size() == 9);
+        CHECK_THAT(outputs[0].get_data(), Catch::Matchers::WithinAbs(4.75, margin));
+        outputs[0].backwards();
+        CHECK_THAT(bias.get_grad(), Catch::Matchers::WithinAbs(1.0, margin));
+        CHECK_THAT(weights[2].get_grad(), Catch::Matchers::WithinAbs(3.0, margin));
+        CHECK_THAT(inputs[1].get_grad(), Catch::Matchers::WithinAbs(-1.0, margin));
+
+        // Updates to the parameters are still picked up by forward
+        weights[0].set_data(1.5);
+        tape.forward();
+        CHECK_THAT(outputs[0].get_data(), Catch::Matchers::WithinAbs(5.75, margin));
+    }
+
+    SECTION("Folding Constants and Subtractions") {
+        Tape tape{};
+        std::vector inputs{tape.value(5.0), tape.value(3.0)};
+        const TapeValue two = tape.value(2.0);
+        std::vector outputs{inputs[0] - inputs[1], inputs[0] * (two * 3.0 + 1.0)};
+        tape.optimize(inputs, outputs);
+        // The inputs, a Sub node, the folded constant 7 and a Mul node
+        CHECK(tape.size() == 5);
+        CHECK_THAT(outputs[0].get_data(), Catch::Matchers::WithinAbs(2.0, margin));
+        CHECK_THAT(outputs[1].get_data(), Catch::Matchers::WithinAbs(35.0, margin));
+        outputs[0].backwards();
+        CHECK_THAT(inputs[0].get_grad(), Catch::Matchers::WithinAbs(1.0, margin));
+        CHECK_THAT(inputs[1].get_grad(), Catch::Matchers::WithinAbs(-1.0, margin));
+        outputs[1].backwards();
+        CHECK_THAT(inputs[0].get_grad(), Catch::Matchers::WithinAbs(7.0, margin));
+    }
+}
+
+TEST_CASE("Running Modules on a Tape", "[tape]") {
+    SECTION("MultiLayerPerceptron matches the Value graph") {
+        MultiLayerPerceptron mlp{3, std::vector{4, 4, 2}};
+        double margin = 0.0000001;
+
+        const std::vector<Value> inputs{Value{0.5}, Value{-1.0}, Value{2.0}};
+        const std::vector<Value> outputs = mlp(inputs);
+        outputs[0].backwards();
+        std::vector<double> expectedGrads;
+        for (auto &param: mlp.get_parameters()) {
+            expectedGrads.push_back(param.get_grad());
+        }
+        mlp.zero_grad();
+
+        Tape tape{};
+        const std::vector<TapeValue> tapeInputs{tape.value(0.5), tape.value(-1.0), tape.value(2.0)};
+        const std::vector<TapeValue> tapeOutputs = mlp(tape, tapeInputs);
+        REQUIRE(tapeOutputs.size() == 2);
+        CHECK_THAT(tapeOutputs[0].get_data(), Catch::Matchers::WithinAbs(outputs[0].get_data(), margin));
+        CHECK_THAT(tapeOutputs[1].get_data(), Catch::Matchers::WithinAbs(outputs[1].get_data(), margin));
+        tapeOutputs[0].backwards();
+
+        int idx = 0;
+        for (auto &param: mlp.get_parameters()) {
+            CHECK_THAT(param.get_grad(), Catch::Matchers::WithinAbs(expectedGrads[idx], margin));
+            ++idx;
+        }
+    }
+}
+
+TEST_CASE("Compiling Modules", "[tape]") {
+    SECTION("Replaying a MultiLayerPerceptron") {
+        MultiLayerPerceptron mlp{3, std::vector{5, 4, 2}};
+        CompiledMultiLayerPerceptron compiled = mlp.compile();
+        double margin = 0.0000001;
+        // 3 inputs, 54 parameters and a leaf holding 1, then a Dot node per neuron and 9 ReLUs
+        CHECK(compiled.size() == 3 + 54 + 1 + 11 + 9);
+
+        const std::vector<std::vector<double> > samples{{0.5, -1.0, 2.0}, {1.5, 0.25, -0.5}};
+        for (const auto &sample: samples) {
+            // Reference result from a freshly built graph
+            std::vector<Value> inputs;
+            for (const double x: sample) {
+                inputs.emplace_back(x);
+            }
+            const std::vector<Value> outputs = mlp(inputs);
+            Value loss = outputs[0] * 2.0 + outputs[1] * -1.0;
+            mlp.zero_grad();
+            loss.backwards();
+            std::vector<double> expectedGrads;
+            for (auto &param: mlp.get_parameters()) {
+                expectedGrads.push_back(param.get_grad());
+            }
+            mlp.zero_grad();
+
+            const std::vector<double> compiledOutputs = compiled(sample);
+            REQUIRE(compiledOutputs.size() == 2);
+            CHECK_THAT(compiledOutputs[0], Catch::Matchers::WithinAbs(outputs[0].get_data(), margin));
+            CHECK_THAT(compiledOutputs[1], Catch::Matchers::WithinAbs(outputs[1].get_data(), margin));
+            compiled.backwards({2.0, -1.0});
+            int idx = 0;
+            for (auto &param: mlp.get_parameters()) {
+                CHECK_THAT(param.get_grad(), Catch::Matchers::WithinAbs(expectedGrads[idx], margin));
+                ++idx;
+            }
+            mlp.zero_grad();
+
+            // Updates to the parameters are seen by the next replay
+            for (auto &param: mlp.get_parameters()) {
+                param.set_data(param.get_data() * 0.5);
+            }
+        }
+    }
+
+    SECTION("Mismatched Inputs") {
+        MultiLayerPerceptron mlp{3, std::vector{2}};
+        CompiledMultiLayerPerceptron compiled = mlp.compile();
+        CHECK_THROWS_AS(compiled({1.0, 2.0}), std::runtime_error);
+        CHECK_THROWS_AS(compiled.backwards({1.0}), std::runtime_error);
+    }
+}
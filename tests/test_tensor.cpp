@@ -0,0 +1,295 @@
+// Standard Library Includes
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// External Includes
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+
+// Local Includes
+#include "engine.h"
+#include "kernels.h"
+#include "tensor.h"
+
+namespace {
+    // Deterministic, irregular test data
+    std::vector<double> testData(const std::size_t size, const double offset) {
+        std::vector<double> out(size);
+        for (std::size_t idx = 0; idx < size; ++idx) {
+            out[idx] = std::sin(static_cast<double>(idx) * 0.7 + offset);
+        }
+        return out;
+    }
+}
+
+TEST_CASE("Running Kernels", "[tensor]") {
+    double margin = 0.0000001;
+
+    SECTION("Matrix Products") {
+        // Sizes which aren't multiples of the SIMD width or the block sizes
+        const std::size_t m = 37, n = 270, k = 131;
+        const std::vector<double> a = testData(m * k, 0.1);
+        const std::vector<double> b = testData(k * n, 0.2);
+        std::vector<double> expected(m * n, 0.);
+        for (std::size_t i = 0; i < m; ++i) {
+            for (std::size_t j = 0; j < n; ++j) {
+                for (std::size_t p = 0; p < k; ++p) {
+                    expected[i * n + j] += a[i * k + p] * b[p * n + j];
+                }
+            }
+        }
+
+        std::vector<double> c(m * n, 0.);
+        kernels::gemmNN(m, n, k, a.data(), b.data(), c.data());
+        for (std::size_t idx = 0; idx < m * n; ++idx) {
+            CHECK_THAT(c[idx], Catch::Matchers::WithinAbs(expected[idx], margin));
+        }
+
+        // Transposed copies of a and b give the same product
+        std::vector<double> aT(k * m), bT(n * k);
+        for (std::size_t i = 0; i < m; ++i) {
+            for (std::size_t p = 0; p < k; ++p) {
+                aT[p * m + i] = a[i * k + p];
+            }
+        }
+        for (std::size_t p = 0; p < k; ++p) {
+            for (std::size_t j = 0; j < n; ++j) {
+                bT[j * k + p] = b[p * n + j];
+            }
+        }
+        std::vector<double> cNT(m * n, 0.), cTN(m * n, 0.);
+        kernels::gemmNT(m, n, k, a.data(), bT.data(), cNT.data());
+        kernels::gemmTN(m, n, k, aT.data(), b.data(), cTN.data());
+        for (std::size_t idx = 0; idx < m * n; ++idx) {
+            CHECK_THAT(cNT[idx], Catch::Matchers::WithinAbs(expected[idx], margin));
+            CHECK_THAT(cTN[idx], Catch::Matchers::WithinAbs(expected[idx], margin));
+        }
+    }
+
+    SECTION("Vector Operations") {
+        const std::size_t n = 45;
+        const std::vector<double> x = testData(n, 0.3);
+        const std::vector<double> y = testData(n, 1.3);
+        double expectedDot = 0., expectedSum = 0.;
+        for (std::size_t idx = 0; idx < n; ++idx) {
+            expectedDot += x[idx] * y[idx];
+            expectedSum += x[idx];
+        }
+        CHECK_THAT(kernels::dot(x.data(), y.data(), n), Catch::Matchers::WithinAbs(expectedDot, margin));
+        CHECK_THAT(kernels::sum(x.data(), n), Catch::Matchers::WithinAbs(expectedSum, margin));
+
+        std::vector<double> out(n), grad(n, 1.0);
+        kernels::relu(x.data(), out.data(), n);
+        kernels::reluBackwards(out.data(), y.data(), grad.data(), n);
+        for (std::size_t idx = 0; idx < n; ++idx) {
+            CHECK_THAT(out[idx], Catch::Matchers::WithinAbs(x[idx] > 0. ? x[idx] : 0., margin));
+            CHECK_THAT(grad[idx], Catch::Matchers::WithinAbs(x[idx] > 0. ? 1.0 + y[idx] : 1.0, margin));
+        }
+    }
+
+    SECTION("Float Kernels") {
+        // Sizes which aren't multiples of the (wider) float SIMD width
+        const std::size_t m = 19, n = 45, k = 37;
+        const std::vector<double> a = testData(m * k, 0.1);
+        const std::vector<double> b = testData(n * k, 0.2);
+        const std::vector<float> aFloat(a.begin(), a.end());
+        const std::vector<float> bFloat(b.begin(), b.end());
+        std::vector<double> c(m * n, 0.);
+        std::vector<float> cFloat(m * n, 0.f);
+        kernels::gemmNT(m, n, k, a.data(), b.data(), c.data());
+        kernels::gemmNT(m, n, k, aFloat.data(), bFloat.data(), cFloat.data());
+        for (std::size_t idx = 0; idx < m * n; ++idx) {
+            CHECK_THAT(cFloat[idx], Catch::Matchers::WithinAbs(c[idx], 0.0001));
+        }
+        CHECK_THAT(kernels::sum(aFloat.data(), n), Catch::Matchers::WithinAbs(kernels::sum(a.data(), n), 0.0001));
+
+        std::vector<float> out(n), grad(n, 1.f);
+        kernels::relu(aFloat.data(), out.data(), n);
+        kernels::reluBackwards(out.data(), bFloat.data(), grad.data(), n);
+        for (std::size_t idx = 0; idx < n; ++idx) {
+            CHECK(out[idx] == (aFloat[idx] > 0.f ? aFloat[idx] : 0.f));
+            CHECK(grad[idx] == (aFloat[idx] > 0.f ? 1.f + bFloat[idx] : 1.f));
+        }
+    }
+}
+
+TEST_CASE("Calculating Tensor Gradients", "[tensor]") {
+    double margin = 0.0000001;
+
+    SECTION("Creating Tensors") {
+        Tensor x{{2, 3}, {1., 2., 3., 4., 5., 6.}};
+        CHECK(x.get_shape() == std::vector<std::size_t>{2, 3});
+        CHECK(x.size() == 6);
+        CHECK_THAT(x.get_data()[4], Catch::Matchers::WithinAbs(5.0, margin));
+        CHECK_THAT(x.get_grad()[4], Catch::Matchers::WithinAbs(0.0, margin));
+        CHECK_THROWS_AS((Tensor{{2, 2}, {1., 2., 3.}}), std::runtime_error);
+        CHECK_THROWS_AS(Tensor::zeros({2, 2, 2}), std::runtime_error);
+    }
+
+    SECTION("Matching the Value Engine") {
+        // loss = sum(relu(W x + b) ** 2 * y), computed both with Tensors and with Values
+        const std::size_t rows = 5, cols = 7;
+        const std::vector<double> wData = testData(rows * cols, 0.5);
+        const std::vector<double> xData = testData(cols, 2.5);
+        const std::vector<double> bData = testData(rows, 4.5);
+        const std::vector<double> yData = testData(rows, 6.5);
+
+        Tensor w{{rows, cols}, wData};
+        Tensor x{{cols}, xData};
+        Tensor b{{rows}, bData};
+        Tensor y{{rows}, yData};
+        Tensor loss = ((w.matmul(x) + b).relu().pow(2.0) * y).sum();
+        loss.backwards();
+
+        std::vector<Value> wValues, xValues;
+        for (const double v: wData) {
+            wValues.emplace_back(v);
+        }
+        for (const double v: xData) {
+            xValues.emplace_back(v);
+        }
+        Value expectedLoss{0.0};
+        for (std::size_t i = 0; i < rows; ++i) {
+            Value activation{bData[i]};
+            for (std::size_t j = 0; j < cols; ++j) {
+                activation = activation + wValues[i * cols + j] * xValues[j];
+            }
+            expectedLoss = expectedLoss + activation.relu().pow(2.0) * yData[i];
+        }
+        expectedLoss.backwards();
+
+        CHECK_THAT(loss.get_data()[0], Catch::Matchers::WithinAbs(expectedLoss.get_data(), margin));
+        for (std::size_t idx = 0; idx < rows * cols; ++idx) {
+            CHECK_THAT(w.get_grad()[idx], Catch::Matchers::WithinAbs(wValues[idx].get_grad(), margin));
+        }
+        for (std::size_t idx = 0; idx < cols; ++idx) {
+            CHECK_THAT(x.get_grad()[idx], Catch::Matchers::WithinAbs(xValues[idx].get_grad(), margin));
+        }
+    }
+
+    SECTION("Matrix Products and Broadcasting") {
+        // C = A B + bias, with every row of the product getting the bias
+        Tensor a{{2, 3}, {1., 2., 3., 4., 5., 6.}};
+        Tensor b{{3, 2}, {1., -1., 0., 2., -2., 1.}};
+        Tensor bias{{2}, {0.5, -0.5}};
+        Tensor c = a.matmul(b) + bias;
+        CHECK(c.get_shape() == std::vector<std::size_t>{2, 2});
+        const std::vector<double> expected{-4.5, 5.5, -7.5, 11.5};
+        for (std::size_t idx = 0; idx < 4; ++idx) {
+            CHECK_THAT(c.get_data()[idx], Catch::Matchers::WithinAbs(expected[idx], margin));
+        }
+
+        c.backwards();
+        // dC/dA[i, p] = sum_j B[p, j], dC/dB[p, j] = sum_i A[i, p]
+        const std::vector<double> expectedA{0., 2., -1., 0., 2., -1.};
+        const std::vector<double> expectedB{5., 5., 7., 7., 9., 9.};
+        for (std::size_t idx = 0; idx < 6; ++idx) {
+            CHECK_THAT(a.get_grad()[idx], Catch::Matchers::WithinAbs(expectedA[idx], margin));
+            CHECK_THAT(b.get_grad()[idx], Catch::Matchers::WithinAbs(expectedB[idx], margin));
+        }
+        // The bias is added to both rows
+        CHECK_THAT(bias.get_grad()[0], Catch::Matchers::WithinAbs(2.0, margin));
+        CHECK_THAT(bias.get_grad()[1], Catch::Matchers::WithinAbs(2.0, margin));
+
+        CHECK_THROWS_AS(a.matmul(a), std::runtime_error);
+        CHECK_THROWS_AS(a + b, std::runtime_error);
+    }
+
+    SECTION("Transposed Matrix Products") {
+        // A B^T against the same product with B stored transposed
+        Tensor a{{2, 3}, {1., 2., 3., 4., 5., 6.}};
+        Tensor b{{2, 3}, {1., 0., -2., -1., 2., 1.}};
+        Tensor bT{{3, 2}, {1., -1., 0., 2., -2., 1.}};
+        Tensor c = a.matmul_transposed(b);
+        Tensor expected = a.matmul(bT);
+        CHECK(c.get_shape() == std::vector<std::size_t>{2, 2});
+        for (std::size_t idx = 0; idx < 4; ++idx) {
+            CHECK_THAT(c.get_data()[idx], Catch::Matchers::WithinAbs(expected.get_data()[idx], margin));
+        }
+
+        c.backwards();
+        // dC/dA[i, p] = sum_j B[j, p], dC/dB[j, p] = sum_i A[i, p]
+        const std::vector<double> expectedA{0., 2., -1., 0., 2., -1.};
+        const std::vector<double> expectedB{5., 7., 9., 5., 7., 9.};
+        for (std::size_t idx = 0; idx < 6; ++idx) {
+            CHECK_THAT(a.get_grad()[idx], Catch::Matchers::WithinAbs(expectedA[idx], margin));
+            CHECK_THAT(b.get_grad()[idx], Catch::Matchers::WithinAbs(expectedB[idx], margin));
+        }
+
+        CHECK_THROWS_AS(a.matmul_transposed(bT), std::runtime_error);
+    }
+
+    SECTION("Viewing External Memory") {
+        auto buffer = std::make_shared<std::vector<double> >(std::vector<double>{1., 2., 3., 4.});
+        Tensor x = Tensor::view({2, 2}, buffer->data(), buffer);
+        CHECK(x.get_data().data() == buffer->data());
+        // Writes to the memory are seen by the tensor, without copying
+        (*buffer)[3] = 5.;
+        CHECK_THAT(x.get_data()[3], Catch::Matchers::WithinAbs(5.0, margin));
+        Tensor y = (x * x).sum();
+        y.backwards();
+        CHECK_THAT(x.get_grad()[3], Catch::Matchers::WithinAbs(10.0, margin));
+        CHECK_THROWS_AS(Tensor::view({2, 2, 1}, buffer->data(), buffer), std::runtime_error);
+    }
+
+    SECTION("Zeroing Gradients") {
+        Tensor x{{3}, {1., 2., 3.}};
+        Tensor y = (x * x).sum();
+        y.backwards();
+        CHECK_THAT(x.get_grad()[2], Catch::Matchers::WithinAbs(6.0, margin));
+        x.zero_grad();
+        for (const double g: x.get_grad()) {
+            CHECK_THAT(g, Catch::Matchers::WithinAbs(0.0, margin));
+        }
+    }
+}
+
+TEST_CASE("Calculating Float Tensor Gradients", "[tensor]") {
+    const double margin = 0.0001;
+
+    SECTION("Matching Double Tensors") {
+        const std::vector<double> aData = testData(12, 0.4);
+        const std::vector<double> bData = testData(8, 0.9);
+        Tensor a{{3, 4}, aData};
+        Tensor b{{2, 4}, bData};
+        FloatTensor aFloat{{3, 4}, std::vector<float>(aData.begin(), aData.end())};
+        FloatTensor bFloat{{2, 4}, std::vector<float>(bData.begin(), bData.end())};
+        Tensor c = a.matmul_transposed(b).relu().pow(2.0);
+        FloatTensor cFloat = aFloat.matmul_transposed(bFloat).relu().pow(2.0);
+        for (std::size_t idx = 0; idx < c.size(); ++idx) {
+            CHECK_THAT(cFloat.get_data()[idx], Catch::Matchers::WithinAbs(c.get_data()[idx], margin));
+        }
+        c.sum().backwards();
+        cFloat.sum().backwards();
+        for (std::size_t idx = 0; idx < a.size(); ++idx) {
+            CHECK_THAT(aFloat.get_grad()[idx], Catch::Matchers::WithinAbs(a.get_grad()[idx], margin));
+        }
+        for (std::size_t idx = 0; idx < b.size(); ++idx) {
+            CHECK_THAT(bFloat.get_grad()[idx], Catch::Matchers::WithinAbs(b.get_grad()[idx], margin));
+        }
+    }
+
+    SECTION("Casting Between Scalar Types") {
+        Tensor x{{3}, {1., 2., 3.}};
+        const FloatTensor xFloat = x.cast<float>();
+        CHECK(xFloat.get_data()[1] == 2.f);
+        // The gradient of the float graph ends up in the double Tensor
+        (xFloat * xFloat).sum().backwards();
+        CHECK_THAT(x.get_grad()[2], Catch::Matchers::WithinAbs(6.0, margin));
+        // and is accumulated there like for any other leaf
+        const FloatTensor again = x.cast<float>();
+        (again * again).sum().backwards();
+        CHECK_THAT(x.get_grad()[2], Catch::Matchers::WithinAbs(12.0, margin));
+
+        const Tensor back = FloatTensor{{2}, {0.5f, -1.5f}}.cast<double>();
+        CHECK(back.get_data()[1] == -1.5);
+        {
+            NoGradGuard guard;
+            x.zero_grad();
+            (x.cast<float>() * xFloat).sum().backwards();
+        }
+        // Without the graph, the cast is a plain leaf
+        CHECK(x.get_grad()[0] == 0.0);
+    }
+}